@@ -181,6 +181,16 @@ public:
    virtual size_t RealtimeProcess(int group, float **inBuf, float **outBuf, size_t numSamples) = 0;
    virtual bool RealtimeProcessEnd() = 0;
 
+   // True if the processors made by RealtimeAddProcessor() keep independent
+   // state and add no latency, so that RealtimeProcess() may be called
+   // concurrently for different groups.  Then destructive processing of many
+   // tracks may use a processor for each group of channels.  That processing
+   // calls neither ProcessInitialize() and ProcessFinalize(), nor
+   // RealtimeProcessStart() and RealtimeProcessEnd(), so an effect that opts
+   // in must not rely on them; each processor must be ready to use once
+   // RealtimeAddProcessor() returns.
+   virtual bool SupportsParallelProcessing() = 0;
+
    virtual bool ShowInterface(
       wxWindow &parent, const EffectDialogFactory &factory,
       bool forceModal = false
@@ -458,6 +458,7 @@ time warp info and AudioIOListener and whether the playback is looped.
 #include "Mix.h"
 #include "Resample.h"
 #include "RingBuffer.h"
+#include "ThreadPool.h"
 #include "prefs/GUISettings.h"
 #include "Prefs.h"
 #include "Project.h"
@@ -1740,6 +1741,7 @@ int AudioIO::StartStream(const TransportTracks &tracks,
    // audio thread call FillBuffers here makes the code more predictable, since
    // FillBuffers will ALWAYS get called from the Audio thread.
    mAudioThreadShouldCallFillBuffersOnce = true;
+   WakeAudioThread();
 
    while( mAudioThreadShouldCallFillBuffersOnce ) {
       auto interval = 50ull;
@@ -1891,6 +1893,7 @@ bool AudioIO::AllocateBuffers(
 
             mPlaybackBuffers.reinit(mPlaybackTracks.size());
             mPlaybackMixers.reinit(mPlaybackTracks.size());
+            mPlaybackProcessed.resize(mPlaybackTracks.size());
 
             const Mixer::WarpOptions &warpOptions =
 #ifdef EXPERIMENTAL_SCRUBBING_SUPPORT
@@ -2322,6 +2325,7 @@ void AudioIO::StopStream()
       // call FillBuffers one last time (it normally would not do so since
       // Pa_GetStreamActive() would now return false
       mAudioThreadShouldCallFillBuffersOnce = true;
+      WakeAudioThread();
 
       while( mAudioThreadShouldCallFillBuffersOnce )
       {
@@ -2337,6 +2341,7 @@ void AudioIO::StopStream()
 
       if (mPlaybackTracks.size() > 0)
       {
+         ReportMixTimings();
          mPlaybackBuffers.reset();
          mPlaybackMixers.reset();
          mTimeQueue.mData.reset();
@@ -2594,6 +2599,23 @@ finished:
 //
 //////////////////////////////////////////////////////////////////////
 
+void AudioIoCallback::WakeAudioThread()
+{
+   // Don't lock the mutex, which the callback must never wait for.  So the
+   // notification may fall between the waiting thread's test of the flag and
+   // its sleep, and then it is lost; but the wait has a timeout.
+   if (!mAudioThreadWakeRequested.exchange(true))
+      mAudioThreadWakeCondition.notify_one();
+}
+
+void AudioIoCallback::WaitForAudioThreadWake(
+   std::chrono::milliseconds timeout)
+{
+   std::unique_lock<std::mutex> lock{ mAudioThreadWakeMutex };
+   mAudioThreadWakeCondition.wait_for(lock, timeout, [this]{
+      return mAudioThreadWakeRequested.exchange(false); });
+}
+
 AudioThread::ExitCode AudioThread::Entry()
 {
    AudioIO *gAudioIO;
@@ -2621,7 +2643,10 @@ AudioThread::ExitCode AudioThread::Entry()
          std::this_thread::sleep_until(
             loopPassStart + std::chrono::milliseconds( interval ) );
       else
-         Sleep(10);
+         // The callback, or the main thread, wakes us when there is work;
+         // poll only in case a wakeup was missed, and seldom when idle
+         gAudioIO->WaitForAudioThreadWake( std::chrono::milliseconds(
+            gAudioIO->mAudioThreadFillBuffersLoopRunning ? 10 : 50 ) );
    }
 
    return 0;
@@ -2673,6 +2698,53 @@ size_t AudioIoCallback::GetCommonlyReadyPlayback()
    return commonlyAvail;
 }
 
+void AudioIO::ProcessPlaybackMixers(size_t toProcess)
+{
+   using Clock = std::chrono::steady_clock;
+   const auto start = Clock::now();
+
+   const auto nMixers = mPlaybackTracks.size();
+   const auto process = [&](size_t ii) {
+      const auto mixStart = Clock::now();
+      mPlaybackProcessed[ii] = mPlaybackMixers[ii]->Process( toProcess );
+      mMixBusyTime += std::chrono::duration_cast<std::chrono::nanoseconds>(
+         Clock::now() - mixStart ).count();
+   };
+   // The pool returns only when all mixers are done, so the caller may then
+   // write all the ring buffers
+   if (nMixers > 1)
+      ThreadPool::Get().ParallelFor( nMixers, process );
+   else if (nMixers == 1)
+      process( 0 );
+
+   ++mMixPasses;
+   mMixElapsedTime += Clock::now() - start;
+}
+
+void AudioIO::ReportMixTimings()
+{
+   if (mMixPasses == 0)
+      return;
+
+   using namespace std::chrono;
+   const auto elapsed = duration<double, std::milli>(mMixElapsedTime).count();
+   const auto busy = duration<double, std::milli>(
+      nanoseconds( mMixBusyTime.load() ) ).count();
+   const auto nThreads = std::min<size_t>( mPlaybackProcessed.size(),
+      1 + ThreadPool::Get().GetThreadCount() );
+   // The part of the elapsed time not explained by mixing, if the threads
+   // had shared the work perfectly
+   const auto overhead = std::max( 0.0, elapsed - busy / nThreads );
+   wxLogDebug(wxT("AudioIO::FillBuffers(): %llu mixing passes on %llu threads, "
+      "%.1f ms elapsed, %.1f ms in mixers, %.1f ms scheduling overhead"),
+      (unsigned long long) mMixPasses, (unsigned long long) nThreads,
+      elapsed, busy, overhead);
+
+   mMixPasses = 0;
+   mMixElapsedTime = {};
+   mMixBusyTime = 0;
+}
+
 size_t AudioIO::GetCommonlyAvailCapture()
 {
    auto commonlyAvail = mCaptureBuffers[0]->AvailForGet();
@@ -2798,26 +2870,29 @@ void AudioIO::FillBuffers()
                (mPlaybackSchedule.Interactive() ? mScrubSpeed : 1.0),
                frames);
 
-            for (i = 0; i < mPlaybackTracks.size(); i++)
+            if (frames > 0)
             {
-               // The mixer here isn't actually mixing: it's just doing
+               // The mixers here aren't actually mixing: they're just doing
                // resampling, format conversion, and possibly time track
-               // warping
-               samplePtr warpedSamples;
+               // warping, independently of each other
+               if ( toProcess )
+                  ProcessPlaybackMixers( toProcess );
+               else
+                  std::fill( mPlaybackProcessed.begin(),
+                     mPlaybackProcessed.end(), 0 );
 
-               if (frames > 0)
+               // Write the ring buffers in order, in this thread
+               for (i = 0; i < mPlaybackTracks.size(); i++)
                {
-                  size_t processed = 0;
-                  if ( toProcess )
-                     processed = mPlaybackMixers[i]->Process( toProcess );
+                  const auto processed = mPlaybackProcessed[i];
                   //wxASSERT(processed <= toProcess);
-                  warpedSamples = mPlaybackMixers[i]->GetBuffer();
+                  samplePtr warpedSamples = mPlaybackMixers[i]->GetBuffer();
                   const auto put = mPlaybackBuffers[i]->Put(
                      warpedSamples, floatSample, processed, frames - processed);
                   // wxASSERT(put == frames);
                   // but we can't assert in this thread
                   wxUnusedVar(put);
-               }               
+               }
             }
 
             available -= frames;
@@ -4461,6 +4536,8 @@ int AudioIoCallback::AudioCallback(const void *inputBuffer, void *outputBuffer,
 
    SendVuOutputMeterData( outputMeterFloats, framesPerBuffer);
 
+   CallbackWakeAudioThread();
+
    return mCallbackReturn;
 }
 
@@ -4505,6 +4582,7 @@ int AudioIoCallback::CallbackDoSeek()
 
    // Reload the ring buffers
    mAudioThreadShouldCallFillBuffersOnce = true;
+   WakeAudioThread();
    while( mAudioThreadShouldCallFillBuffersOnce )
    {
       wxMilliSleep( 50 );
@@ -4516,6 +4594,28 @@ int AudioIoCallback::CallbackDoSeek()
    return paContinue;
 }
 
+void AudioIoCallback::CallbackWakeAudioThread()
+{
+   if (!mAudioThreadFillBuffersLoopRunning)
+      return;
+
+   // Wake the audio thread as soon as FillBuffers has a batch of work, rather
+   // than leave the ring buffers to drain until its next poll.  Repeated
+   // wakeups before the thread runs cost nothing more.
+   bool wake = false;
+   if (!mPlaybackTracks.empty()) {
+      const auto nReady = GetCommonlyReadyPlayback();
+      wake = nReady < mPlaybackQueueMinimum ||
+         mPlaybackBuffers[0]->AvailForPut() >= mPlaybackSamplesToCopy;
+   }
+   if (!wake && !mCaptureTracks.empty())
+      wake = mCaptureBuffers[0]->AvailForGet() >=
+         mMinCaptureSecsToCopy * mRate;
+
+   if (wake)
+      WakeAudioThread();
+}
+
 void AudioIoCallback::CallbackCheckCompletion(
    int &callbackReturn, unsigned long len)
 {
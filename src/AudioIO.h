@@ -19,7 +19,11 @@
 
 #include "Experimental.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <wx/atomic.h> // member variable
 
@@ -296,6 +300,18 @@ public:
    void CallbackCheckCompletion(
       int &callbackReturn, unsigned long len);
 
+   // Part of the callback
+   void CallbackWakeAudioThread();
+
+   //! Wake the audio thread now, if it is waiting
+   /*! Never blocks, so the PortAudio callback may call it */
+   void WakeAudioThread();
+
+   //! Called only by the audio thread, between passes of its loop
+   /*! Returns after WakeAudioThread, or after the timeout, so that the
+    thread still polls, if a wakeup is lost */
+   void WaitForAudioThreadWake(std::chrono::milliseconds timeout);
+
    int mbHasSoloTracks;
    int mCallbackReturn;
    // Helpers to determine if tracks have already been faded out.
@@ -491,6 +507,12 @@ public:
    volatile bool       mAudioThreadFillBuffersLoopRunning;
    volatile bool       mAudioThreadFillBuffersLoopActive;
 
+   // Lets the audio thread sleep until the callback has drained enough of
+   // the ring buffers for FillBuffers to have work
+   std::mutex          mAudioThreadWakeMutex;
+   std::condition_variable mAudioThreadWakeCondition;
+   std::atomic<bool>   mAudioThreadWakeRequested{ false };
+
    wxLongLong          mLastPlaybackTimeMillis;
 
 #ifdef EXPERIMENTAL_MIDI_OUT
@@ -761,6 +783,16 @@ private:
    * they are different. */
    size_t GetCommonlyFreePlayback();
 
+   /** \brief Call Process( toProcess ) on every playback mixer, on as many
+    * threads as there are cores, and store the results in mPlaybackProcessed
+    *
+    * Returns when all mixers are done, so that the ring buffers can then be
+    * written in order */
+   void ProcessPlaybackMixers(size_t toProcess);
+
+   //! Log, and reset, the timings of ProcessPlaybackMixers during a stream
+   void ReportMixTimings();
+
    /** \brief Get the number of audio samples ready in all of the recording
     * buffers.
     *
@@ -783,6 +815,15 @@ private:
      *
      * If bOnlyBuffers is specified, it only cleans up the buffers. */
    void StartStreamCleanup(bool bOnlyBuffers = false);
+
+   //! Samples produced by each playback mixer in the latest fill cycle
+   std::vector<size_t> mPlaybackProcessed;
+
+   // Timings of ProcessPlaybackMixers, to measure the cost of scheduling
+   size_t mMixPasses{ 0 };
+   std::chrono::steady_clock::duration mMixElapsedTime{};
+   //! Nanoseconds in Mixer::Process, summed over all threads
+   std::atomic<long long> mMixBusyTime{ 0 };
 };
 
 static constexpr unsigned ScrubPollInterval_ms = 50;
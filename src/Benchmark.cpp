@@ -25,6 +25,7 @@ of sample block storage.
 #include <wx/checkbox.h>
 #include <wx/choice.h>
 #include <wx/dialog.h>
+#include <wx/filename.h>
 #include <wx/sizer.h>
 #include <wx/stattext.h>
 #include <wx/timer.h>
@@ -33,12 +34,19 @@ of sample block storage.
 #include <wx/valtext.h>
 #include <wx/intl.h>
 
+#include "Envelope.h"
+#include "Mix.h"
 #include "SampleBlock.h"
+#include "SampleBlockCache.h"
 #include "ShuttleGui.h"
 #include "Project.h"
+#include "ProjectFileIO.h"
+#include "ProjectSerializer.h"
+#include "TempDirectory.h"
 #include "WaveClip.h"
 #include "WaveTrack.h"
 #include "Sequence.h"
+#include "SimdFuncs.h"
 #include "Prefs.h"
 #include "ProjectSettings.h"
 #include "ViewInfo.h"
@@ -46,12 +54,36 @@ of sample block storage.
 #include "FileNames.h"
 #include "widgets/AudacityMessageBox.h"
 #include "widgets/wxPanelWrapper.h"
+#include "xml/XMLFileReader.h"
 
 // Change these to the desired format...should probably make the
 // choice available in the dialog
 #define SampleType short
 #define SampleFormat int16Sample
 
+namespace {
+// Accepts any document, counting tags and attributes, to time the loading
+// of project documents apart from what the real handlers do
+class CountingTagHandler final : public XMLTagHandler
+{
+public:
+   bool HandleXMLTag(const wxChar *, const wxChar **attrs) override
+   {
+      ++mTags;
+      while (*attrs++)
+         ++mAttrs;
+      return true;
+   }
+   XMLTagHandler *HandleXMLChild(const wxChar *) override
+   {
+      return this;
+   }
+
+   size_t mTags{ 0 };
+   size_t mAttrs{ 0 };
+};
+}
+
 class BenchmarkDialog final : public wxDialogWrapper
 {
 public:
@@ -571,6 +603,290 @@ void BenchmarkDialog::OnRun( wxCommandEvent & WXUNUSED(event))
    Printf( XO("At 44100 Hz, %d bytes per sample, the estimated number of\n simultaneous tracks that could be played at once: %.1f\n" )
       .Format( SAMPLE_SIZE(SampleFormat), (nChunks*chunkSize/44100.0)/(elapsed/1000.0) ) );
 
+   Printf( XO("Doing small random reads...\n") );
+   wxTheApp->Yield();
+   FlushPrint();
+
+   {
+      // Compare reading a small part of a block, which need not fetch all
+      // of the block's storage, with reading the whole block, and then with
+      // reading through the cache of decoded blocks
+      auto &cache = SampleBlockCache::Get();
+      const auto budget = cache.GetBudget();
+      auto restoreBudget = finally( [&]{ cache.SetBudget( budget ); } );
+      cache.SetBudget( 0 );
+
+      const auto &blocks =
+         t->GetClipByIndex(0)->GetSequence()->GetBlockArray();
+      const size_t readLen = 256;
+      const int nReads = 1000;
+
+      size_t maxCount = 0;
+      for (const auto &seqBlock : blocks)
+         maxCount = std::max(maxCount, seqBlock.sb->GetSampleCount());
+      Samples partial{ readLen };
+      Samples whole{ maxCount };
+
+      srand(randSeed);
+      timer.Start();
+      for (z = 0; z < nReads; z++) {
+         const auto &sb = blocks[rand() % blocks.size()].sb;
+         const auto count = sb->GetSampleCount();
+         const auto len = std::min(readLen, count);
+         const size_t offset = rand() % (count - len + 1);
+         sb->GetSamples((samplePtr)partial.get(), SampleFormat, offset, len);
+      }
+      elapsed = timer.Time();
+
+      Printf( XO("Time for %d reads of %lld samples: %ld ms\n")
+         .Format( nReads, (long long) readLen, elapsed ) );
+
+      srand(randSeed);
+      timer.Start();
+      for (z = 0; z < nReads; z++) {
+         const auto &sb = blocks[rand() % blocks.size()].sb;
+         const auto count = sb->GetSampleCount();
+         const auto len = std::min(readLen, count);
+         const size_t offset = rand() % (count - len + 1);
+         sb->GetSamples((samplePtr)whole.get(), SampleFormat, 0, count);
+         std::copy(&whole[offset], &whole[offset] + len, &partial[0]);
+      }
+      elapsed = timer.Time();
+
+      Printf( XO("Time for %d reads of whole blocks: %ld ms\n")
+         .Format( nReads, elapsed ) );
+
+      // Measure the cache even if preferences disable it
+      cache.SetBudget( budget ? budget : 128 * 1024 * 1024 );
+      cache.ResetStatistics();
+      srand(randSeed);
+      timer.Start();
+      for (z = 0; z < nReads; z++) {
+         const auto &sb = blocks[rand() % blocks.size()].sb;
+         const auto count = sb->GetSampleCount();
+         const auto len = std::min(readLen, count);
+         const size_t offset = rand() % (count - len + 1);
+         sb->GetSamples((samplePtr)partial.get(), SampleFormat, offset, len);
+      }
+      elapsed = timer.Time();
+
+      const auto stats = cache.GetStatistics();
+      Printf( XO("Time for %d reads of %lld samples through the block cache: %ld ms, %llu hits, %llu misses\n")
+         .Format( nReads, (long long) readLen, elapsed,
+            stats.hits, stats.misses ) );
+   }
+
+   Printf( XO("Timing summary kernels...\n") );
+   wxTheApp->Yield();
+   FlushPrint();
+
+   {
+      // Throughput of the min, max, and RMS computation for each sample
+      // format, at each instruction set level that this CPU supports
+      const size_t kernelLen = 1 << 20;
+      const int passes = 100;
+      Floats noise{ kernelLen };
+      for (size_t i = 0; i < kernelLen; i++)
+         noise[i] = rand() / (RAND_MAX / 2.0f) - 1.0f;
+
+      const auto savedLevel = GetSimdLevel();
+      const auto restoreLevel =
+         finally( [&]{ SetSimdLevel( savedLevel ); } );
+      for (auto format : { int16Sample, int24Sample, floatSample }) {
+         SampleBuffer data{ kernelLen, format };
+         CopySamples((constSamplePtr)noise.get(), floatSample,
+            data.ptr(), format, kernelLen);
+
+         for (auto level : { SimdLevel::None, SimdLevel::SSE2, SimdLevel::AVX2 }) {
+            if (level > savedLevel)
+               break;
+            SetSimdLevel( level );
+            const auto minMaxSumsq = GetMinMaxSumsqFunction( format );
+
+            float min, max, sumsq;
+            timer.Start();
+            for (z = 0; z < passes; z++)
+               minMaxSumsq(data.ptr(), kernelLen, min, max, sumsq);
+            const double seconds = timer.TimeInMicro().ToDouble() / 1e6;
+
+            const auto levelName =
+               level == SimdLevel::AVX2 ? wxT("AVX2")
+               : level == SimdLevel::SSE2 ? wxT("SSE2")
+               : wxT("scalar");
+            Printf( XO("%s, %s: %.2f GB/s\n")
+               .Format( GetSampleFormatStr( format ), levelName,
+                  passes * kernelLen * SAMPLE_SIZE(format) /
+                     std::max(seconds, 1e-6) / 1e9 ) );
+         }
+      }
+   }
+
+   Printf( XO("Copying project file...\n") );
+   wxTheApp->Yield();
+   FlushPrint();
+
+   {
+      // Save a copy holding just the blocks of the test track, as Save As,
+      // backup and compaction do
+      auto tracks = TrackList::Create( nullptr );
+      tracks->Add( t->Duplicate() );
+
+      const wxFileName copyName{ TempDirectory::TempDir(),
+         wxT("benchmark-copy.aup3") };
+      const auto copyPath = copyName.GetFullPath();
+      wxRemoveFile(copyPath);
+      const auto removeCopy = finally( [&]{ wxRemoveFile(copyPath); } );
+
+      timer.Start();
+      const bool copied =
+         ProjectFileIO::Get( mProject ).SaveCopy( copyPath, tracks.get() );
+      elapsed = timer.Time();
+
+      if (!copied) {
+         Printf( XO("Copy of project file failed.\n") );
+         goto fail;
+      }
+
+      const double megabytes =
+         wxFileName::GetSize(copyPath).ToDouble() / 1048576.0;
+      Printf( XO("Time to copy %.1f MB: %ld ms, %.1f MB/s\n")
+         .Format( megabytes, elapsed,
+            megabytes * 1000.0 / std::max(elapsed, 1L) ) );
+   }
+
+   Printf( XO("Loading project document...\n") );
+   wxTheApp->Yield();
+   FlushPrint();
+
+   {
+      // Make a document like that of a project with 10000 clips, each with
+      // a few blocks and envelope points
+      const int nClips = 10000;
+      ProjectSerializer doc;
+      doc.StartTag(wxT("project"));
+      doc.WriteAttr(wxT("rate"), 44100.0);
+      doc.StartTag(wxT("wavetrack"));
+      doc.WriteAttr(wxT("name"), wxT("Benchmark"));
+      for (int ii = 0; ii < nClips; ++ii) {
+         doc.StartTag(wxT("waveclip"));
+         doc.WriteAttr(wxT("offset"), ii * 10.0, 8);
+         doc.WriteAttr(wxT("colorindex"), 0);
+         doc.StartTag(wxT("sequence"));
+         doc.WriteAttr(wxT("maxsamples"), (size_t)262144);
+         doc.WriteAttr(wxT("sampleformat"), (size_t)SampleFormat);
+         doc.WriteAttr(wxT("numsamples"), 4 * 262144LL);
+         for (int jj = 0; jj < 4; ++jj) {
+            doc.StartTag(wxT("waveblock"));
+            doc.WriteAttr(wxT("start"), jj * 262144LL);
+            doc.WriteAttr(wxT("blockid"), 4LL * ii + jj + 1);
+            doc.EndTag(wxT("waveblock"));
+         }
+         doc.EndTag(wxT("sequence"));
+         doc.StartTag(wxT("envelope"));
+         doc.WriteAttr(wxT("numpoints"), (size_t)2);
+         for (int jj = 0; jj < 2; ++jj) {
+            doc.StartTag(wxT("controlpoint"));
+            doc.WriteAttr(wxT("t"), jj * 5.0, 12);
+            doc.WriteAttr(wxT("val"), 1.0, 12);
+            doc.EndTag(wxT("controlpoint"));
+         }
+         doc.EndTag(wxT("envelope"));
+         doc.EndTag(wxT("waveclip"));
+      }
+      doc.EndTag(wxT("wavetrack"));
+      doc.EndTag(wxT("project"));
+
+      wxMemoryBuffer buffer;
+      buffer.AppendData(doc.GetDict().GetData(), doc.GetDict().GetDataLen());
+      buffer.AppendData(doc.GetData().GetData(), doc.GetData().GetDataLen());
+
+      // As before, through XML text and the parser
+      CountingTagHandler parsed;
+      timer.Start();
+      {
+         XMLFileReader reader;
+         if (!reader.ParseString(&parsed, ProjectSerializer::Decode(buffer))) {
+            Printf( XO("Parsing of project document failed.\n") );
+            goto fail;
+         }
+      }
+      const auto parseTime = timer.Time();
+
+      CountingTagHandler decoded;
+      timer.Start();
+      if (!ProjectSerializer::Decode(buffer, &decoded)) {
+         Printf( XO("Decoding of project document failed.\n") );
+         goto fail;
+      }
+      const auto decodeTime = timer.Time();
+
+      if (parsed.mTags != decoded.mTags || parsed.mAttrs != decoded.mAttrs) {
+         Printf( XO("Decoded project document differs from parsed.\n") );
+         goto fail;
+      }
+
+      Printf( XO("Time to load %d clips: %ld ms through XML text, %ld ms directly\n")
+         .Format( nClips, parseTime, decodeTime ) );
+   }
+
+   Printf( XO("Mixing tracks...\n") );
+   wxTheApp->Yield();
+   FlushPrint();
+
+   {
+      // Mix panned mono tracks with envelopes to stereo at their own rate, as
+      // playback and export do, at each instruction set level
+      const int nTracks = 16;
+      const unsigned nChannels = 2;
+      const double rate = 44100.0, seconds = 10.0;
+      const size_t len = rate * seconds;
+      Floats noise{ len };
+      for (size_t i = 0; i < len; i++)
+         noise[i] = rand() / (RAND_MAX / 2.0f) - 1.0f;
+
+      WaveTrackFactory factory{ mSettings,
+         SampleBlockFactory::New( mProject ) };
+      WaveTrackConstArray tracks;
+      for (int ii = 0; ii < nTracks; ++ii) {
+         const auto track = factory.NewWaveTrack(floatSample, rate);
+         track->Append((samplePtr)noise.get(), floatSample, len);
+         track->Flush();
+         track->SetGain(0.5f);
+         track->SetPan(2.0f * ii / (nTracks - 1) - 1.0f);
+         for (const auto &clip : track->GetClips())
+            clip->GetEnvelope()->InsertOrReplace(seconds / 2, 0.5);
+         tracks.push_back(track);
+      }
+
+      const auto savedLevel = GetSimdLevel();
+      const auto restoreLevel =
+         finally( [&]{ SetSimdLevel( savedLevel ); } );
+      for (auto level : { SimdLevel::None, SimdLevel::SSE2, SimdLevel::AVX2 }) {
+         if (level > savedLevel)
+            break;
+         SetSimdLevel( level );
+
+         const size_t bufferSize = 65536;
+         Mixer mixer{ tracks, true, Mixer::WarpOptions{ nullptr },
+            0.0, seconds, nChannels, bufferSize, true, rate, floatSample };
+         timer.Start();
+         while (mixer.Process(bufferSize) > 0)
+            ;
+         const double elapsedSeconds =
+            timer.TimeInMicro().ToDouble() / 1e6;
+
+         const auto levelName =
+            level == SimdLevel::AVX2 ? wxT("AVX2")
+            : level == SimdLevel::SSE2 ? wxT("SSE2")
+            : wxT("scalar");
+         Printf( XO("%s: %d tracks x %d channels x %.0f s mixed in %.1f ms, %.0f track-channel-seconds per second\n")
+            .Format( levelName, nTracks, (int)nChannels, seconds,
+               elapsedSeconds * 1000.0,
+               nTracks * nChannels * seconds /
+                  std::max(elapsedSeconds, 1e-6) ) );
+      }
+   }
+
    goto success;
 
  fail:
@@ -71,6 +71,55 @@ bool DBConnection::ShouldBypass()
    return mBypass;
 }
 
+bool DBConnection::HasSampleBlockCodecs()
+{
+   int has = mSampleBlockCodecs;
+   if (has >= 0)
+      return has != 0;
+
+   sqlite3_stmt *stmt = nullptr;
+   int rc = sqlite3_prepare_v2(mDB,
+      "SELECT Count(*) FROM pragma_table_info('sampleblocks')"
+      "  WHERE name = 'codec';",
+      -1, &stmt, nullptr);
+   if (rc == SQLITE_OK)
+   {
+      rc = sqlite3_step(stmt);
+      if (rc == SQLITE_ROW)
+         has = sqlite3_column_int(stmt, 0) != 0;
+   }
+
+   // No need to check return code
+   sqlite3_finalize(stmt);
+
+   if (rc != SQLITE_ROW)
+   {
+      wxLogDebug(wxT("DBConnection::HasSampleBlockCodecs - SQLITE error %s"), sqlite3_errmsg(mDB));
+
+      // Don't remember the failure
+      return false;
+   }
+
+   mSampleBlockCodecs = has;
+   return has != 0;
+}
+
+void DBConnection::SetSampleBlockCodecs( bool has )
+{
+   mSampleBlockCodecs = has;
+}
+
+void DBConnection::WriteInSavepoints(
+   const std::function<void(bool inSavepoint)> &write,
+   SavepointEndCallback callback)
+{
+   std::lock_guard<std::mutex> guard(mSavepointMutex);
+   const bool inSavepoint = mSavepointDepth > 0;
+   write(inSavepoint);
+   if (inSavepoint)
+      mSavepointCallbacks.push_back(std::move(callback));
+}
+
 void DBConnection::SetError(
    const TranslatableString &msg, const TranslatableString &libraryError, int errorCode)
 {
@@ -536,6 +585,7 @@ bool TransactionScope::TransactionStart(const wxString &name)
 {
    char *errmsg = nullptr;
 
+   std::lock_guard<std::mutex> guard(mConnection.mSavepointMutex);
    int rc = sqlite3_exec(mConnection.DB(),
                          wxT("SAVEPOINT ") + name + wxT(";"),
                          nullptr,
@@ -550,6 +600,9 @@ bool TransactionScope::TransactionStart(const wxString &name)
       sqlite3_free(errmsg);
    }
 
+   if (rc == SQLITE_OK)
+      ++mConnection.mSavepointDepth;
+
    return rc == SQLITE_OK;
 }
 
@@ -557,6 +610,7 @@ bool TransactionScope::TransactionCommit(const wxString &name)
 {
    char *errmsg = nullptr;
 
+   std::unique_lock<std::mutex> lock(mConnection.mSavepointMutex);
    int rc = sqlite3_exec(mConnection.DB(),
                          wxT("RELEASE ") + name + wxT(";"),
                          nullptr,
@@ -571,6 +625,14 @@ bool TransactionScope::TransactionCommit(const wxString &name)
       sqlite3_free(errmsg);
    }
 
+   // Writes inside the savepoints are now durable
+   std::vector<DBConnection::SavepointEndCallback> callbacks;
+   if (rc == SQLITE_OK && --mConnection.mSavepointDepth == 0)
+      callbacks.swap(mConnection.mSavepointCallbacks);
+   lock.unlock();
+   for (auto &callback : callbacks)
+      callback(false);
+
    return rc == SQLITE_OK;
 }
 
@@ -578,6 +640,7 @@ bool TransactionScope::TransactionRollback(const wxString &name)
 {
    char *errmsg = nullptr;
 
+   std::unique_lock<std::mutex> lock(mConnection.mSavepointMutex);
    int rc = sqlite3_exec(mConnection.DB(),
                          wxT("ROLLBACK TO ") + name + wxT(";"),
                          nullptr,
@@ -592,6 +655,15 @@ bool TransactionScope::TransactionRollback(const wxString &name)
       sqlite3_free(errmsg);
    }
 
+   // Writes inside the savepoint were undone; don't distinguish the nesting
+   // level, which errs on the side of redoing too much
+   std::vector<DBConnection::SavepointEndCallback> callbacks;
+   if (rc == SQLITE_OK)
+      callbacks.swap(mConnection.mSavepointCallbacks);
+   lock.unlock();
+   for (auto &callback : callbacks)
+      callback(true);
+
    return rc == SQLITE_OK;
 }
 
@@ -19,6 +19,7 @@ Paul Licameli -- split from ProjectFileIO.h
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "ClientData.h"
 
@@ -70,19 +71,45 @@ public:
    enum StatementID
    {
       GetSamples,
+      GetSamplesBatch,
+      GetSamplesBatchCodec,
       GetSummary256,
       GetSummary64k,
       LoadSampleBlock,
+      LoadSampleBlockCodec,
       InsertSampleBlock,
+      InsertSampleBlockCodec,
+      UpdateSummary,
       DeleteSampleBlock,
-      GetRootPage,
-      GetDBPage
+      FindSampleBlockHash,
+      InsertSampleBlockHash,
+      GetBlockUsage,
+      GetTotalUsage,
+      GetBlockCount,
+      InsertAutoSaveFragment,
+      DeleteAutoSaveFragment
    };
    sqlite3_stmt *Prepare(enum StatementID id, const char *sql);
 
    void SetBypass( bool bypass );
    bool ShouldBypass();
 
+   //! Whether the sampleblocks table has the codec column; the schema is
+   //! examined on first use, unless SetSampleBlockCodecs() was called
+   bool HasSampleBlockCodecs();
+   void SetSampleBlockCodecs( bool has );
+
+   //! Type of function called when the savepoints open at a write end
+   /*! @param rolledBack whether the write may have been undone */
+   using SavepointEndCallback = std::function<void(bool rolledBack)>;
+
+   //! Execute a write, from any thread, with no savepoint beginning or
+   //! ending meanwhile; it is passed whether a savepoint is open
+   /*! If one is, callback is called later, in the thread that ends it, when
+    any savepoint rolls back, or else when the last is released */
+   void WriteInSavepoints(const std::function<void(bool inSavepoint)> &write,
+      SavepointEndCallback callback);
+
    //! Just set stored errors
    void SetError(
       const TranslatableString &msg,
@@ -122,6 +149,17 @@ private:
 
    // Bypass transactions if database will be deleted after close
    bool mBypass;
+
+   // -1 until known, then 0 or 1
+   std::atomic<int> mSampleBlockCodecs{ -1 };
+
+   // Savepoints of TransactionScope, and callbacks for the writes of other
+   // threads made inside them; the mutex also guards the beginning and
+   // ending of savepoints
+   friend class TransactionScope;
+   std::mutex mSavepointMutex;
+   int mSavepointDepth{ 0 };
+   std::vector<SavepointEndCallback> mSavepointCallbacks;
 };
 
 //! RAII for a database transaction, possibly nested
@@ -31,6 +31,7 @@ a draggable point type.
 
 #include "Experimental.h"
 
+#include <algorithm>
 #include <math.h>
 
 #include <wx/wxcrtvararg.h>
@@ -266,6 +267,20 @@ Envelope::Envelope(const Envelope &orig)
    CopyRange(orig, 0, orig.GetNumberOfPoints());
 }
 
+bool Envelope::HasSameContents(const Envelope &other) const
+{
+   // Compare what the copy constructor copies
+   return mDB == other.mDB &&
+      mMinValue == other.mMinValue &&
+      mMaxValue == other.mMaxValue &&
+      mDefaultValue == other.mDefaultValue &&
+      mOffset == other.mOffset &&
+      mTrackLen == other.mTrackLen &&
+      std::equal( mEnv.begin(), mEnv.end(), other.mEnv.begin(), other.mEnv.end(),
+         []( const EnvPoint &a, const EnvPoint &b ){
+            return a.GetT() == b.GetT() && a.GetVal() == b.GetVal(); } );
+}
+
 void Envelope::CopyRange(const Envelope &orig, size_t begin, size_t end)
 {
    size_t len = orig.mEnv.size();
@@ -847,24 +862,28 @@ void Envelope::BinarySearchForTime( int &Lo, int &Hi, double t ) const
 {
    // Optimizations for the usual pattern of repeated calls with
    // small increases of t.
+   // Mixers on several threads may share the envelope of a time track, so
+   // take the guess once; a guess left by another thread is only slower.
    {
-      if (mSearchGuess >= 0 && mSearchGuess < (int)mEnv.size()) {
-         if (t >= mEnv[mSearchGuess].GetT() &&
-             (1 + mSearchGuess == (int)mEnv.size() ||
-              t < mEnv[1 + mSearchGuess].GetT())) {
-            Lo = mSearchGuess;
-            Hi = 1 + mSearchGuess;
+      auto guess = mSearchGuess.load(std::memory_order_relaxed);
+      if (guess >= 0 && guess < (int)mEnv.size()) {
+         if (t >= mEnv[guess].GetT() &&
+             (1 + guess == (int)mEnv.size() ||
+              t < mEnv[1 + guess].GetT())) {
+            Lo = guess;
+            Hi = 1 + guess;
             return;
          }
       }
 
-      ++mSearchGuess;
-      if (mSearchGuess >= 0 && mSearchGuess < (int)mEnv.size()) {
-         if (t >= mEnv[mSearchGuess].GetT() &&
-             (1 + mSearchGuess == (int)mEnv.size() ||
-              t < mEnv[1 + mSearchGuess].GetT())) {
-            Lo = mSearchGuess;
-            Hi = 1 + mSearchGuess;
+      ++guess;
+      if (guess >= 0 && guess < (int)mEnv.size()) {
+         if (t >= mEnv[guess].GetT() &&
+             (1 + guess == (int)mEnv.size() ||
+              t < mEnv[1 + guess].GetT())) {
+            Lo = guess;
+            Hi = 1 + guess;
+            mSearchGuess.store(guess, std::memory_order_relaxed);
             return;
          }
       }
@@ -884,7 +903,7 @@ void Envelope::BinarySearchForTime( int &Lo, int &Hi, double t ) const
    }
    wxASSERT( Hi == ( Lo+1 ));
 
-   mSearchGuess = Lo;
+   mSearchGuess.store(Lo, std::memory_order_relaxed);
 }
 
 // relative time
@@ -906,7 +925,7 @@ void Envelope::BinarySearchForTime_LeftLimit( int &Lo, int &Hi, double t ) const
    }
    wxASSERT( Hi == ( Lo+1 ));
 
-   mSearchGuess = Lo;
+   mSearchGuess.store(Lo, std::memory_order_relaxed);
 }
 
 /// GetInterpolationStartValueAtPoint() is used to select either the
@@ -941,112 +960,139 @@ void Envelope::GetValuesRelative
    const auto epsilon = tstep / 2;
    int len = mEnv.size();
 
+   // IF empty envelope THEN default value
+   if (len <= 0) {
+      std::fill(buffer, buffer + std::max(0, bufferLen), mDefaultValue);
+      return;
+   }
+
    double t = t0;
    double increment = 0;
    if ( len > 1 && t <= mEnv[0].GetT() && mEnv[0].GetT() == mEnv[1].GetT() )
       increment = leftLimit ? -epsilon : epsilon;
 
-   double tprev, vprev, tnext = 0, vnext, vstep = 0;
-
-   for (int b = 0; b < bufferLen; b++) {
-
-      // Get easiest cases out the way first...
-      // IF empty envelope THEN default value
-      if (len <= 0) {
-         buffer[b] = mDefaultValue;
-         t += tstep;
-         continue;
-      }
+   const auto firstT = mEnv[0].GetT(), lastT = mEnv[len - 1].GetT();
 
+   // Produce runs of values, each before the envelope, after it, or within
+   // one interval between points, so that the tests and the search are
+   // done once for each run, not for each value.  Step the time by repeated
+   // addition just as for one value at a time, so that the runs end at the
+   // same samples.
+   int b = 0;
+   while (b < bufferLen) {
       auto tplus = t + increment;
 
       // IF before envelope THEN first value
-      if ( leftLimit ? tplus <= mEnv[0].GetT() : tplus < mEnv[0].GetT() ) {
-         buffer[b] = mEnv[0].GetVal();
-         t += tstep;
+      if ( leftLimit ? tplus <= firstT : tplus < firstT ) {
+         const auto value = mEnv[0].GetVal();
+         do {
+            buffer[b++] = value;
+            t += tstep;
+            tplus = t + increment;
+         } while ( b < bufferLen &&
+            ( leftLimit ? tplus <= firstT : tplus < firstT ) );
          continue;
       }
+
       // IF after envelope THEN last value
-      if ( leftLimit
-            ? tplus > mEnv[len - 1].GetT() : tplus >= mEnv[len - 1].GetT() ) {
-         buffer[b] = mEnv[len - 1].GetVal();
-         t += tstep;
+      if ( leftLimit ? tplus > lastT : tplus >= lastT ) {
+         const auto value = mEnv[len - 1].GetVal();
+         do {
+            buffer[b++] = value;
+            t += tstep;
+            tplus = t + increment;
+         } while ( b < bufferLen &&
+            ( leftLimit ? tplus > lastT : tplus >= lastT ) );
          continue;
       }
 
-      // be careful to get the correct limit even in case epsilon == 0
-      if ( b == 0 ||
-           ( leftLimit ? tplus > tnext : tplus >= tnext ) ) {
-
-         // We're beyond our tnext, so find the next one.
-         // Don't just increment lo or hi because we might
-         // be zoomed far out and that could be a large number of
-         // points to move over.  That's why we binary search.
+      // Find the interval containing tplus.
+      // Don't just increment lo or hi because we might
+      // be zoomed far out and that could be a large number of
+      // points to move over.  That's why we binary search.
 
-         int lo,hi;
-         if ( leftLimit )
-            BinarySearchForTime_LeftLimit( lo, hi, tplus );
-         else
-            BinarySearchForTime( lo, hi, tplus );
-
-         // mEnv[0] is before tplus because of eliminations above, therefore lo >= 0
-         // mEnv[len - 1] is after tplus, therefore hi <= len - 1
-         wxASSERT( lo >= 0 && hi <= len - 1 );
-
-         tprev = mEnv[lo].GetT();
-         tnext = mEnv[hi].GetT();
-
-         if ( hi + 1 < len && tnext == mEnv[ hi + 1 ].GetT() )
-            // There is a discontinuity after this point-to-point interval.
-            // Usually will stop evaluating in this interval when time is slightly
-            // before tNext, then use the right limit.
-            // This is the right intent
-            // in case small roundoff errors cause a sample time to be a little
-            // before the envelope point time.
-            // Less commonly we want a left limit, so we continue evaluating in
-            // this interval until shortly after the discontinuity.
-            increment = leftLimit ? -epsilon : epsilon;
-         else
-            increment = 0;
+      int lo,hi;
+      if ( leftLimit )
+         BinarySearchForTime_LeftLimit( lo, hi, tplus );
+      else
+         BinarySearchForTime( lo, hi, tplus );
+
+      // mEnv[0] is before tplus because of eliminations above, therefore lo >= 0
+      // mEnv[len - 1] is after tplus, therefore hi <= len - 1
+      wxASSERT( lo >= 0 && hi <= len - 1 );
+
+      const double tprev = mEnv[lo].GetT();
+      const double tnext = mEnv[hi].GetT();
+
+      if ( hi + 1 < len && tnext == mEnv[ hi + 1 ].GetT() )
+         // There is a discontinuity after this point-to-point interval.
+         // Usually will stop evaluating in this interval when time is slightly
+         // before tNext, then use the right limit.
+         // This is the right intent
+         // in case small roundoff errors cause a sample time to be a little
+         // before the envelope point time.
+         // Less commonly we want a left limit, so we continue evaluating in
+         // this interval until shortly after the discontinuity.
+         increment = leftLimit ? -epsilon : epsilon;
+      else
+         increment = 0;
 
-         vprev = GetInterpolationStartValueAtPoint( lo );
-         vnext = GetInterpolationStartValueAtPoint( hi );
+      const double vprev = GetInterpolationStartValueAtPoint( lo );
+      const double vnext = GetInterpolationStartValueAtPoint( hi );
 
-         // Interpolate, either linear or log depending on mDB.
-         double dt = (tnext - tprev);
-         double to = t - tprev;
-         double v;
-         if (dt > 0.0)
-         {
-            v = (vprev * (dt - to) + vnext * to) / dt;
-            vstep = (vnext - vprev) * tstep / dt;
-         }
-         else
-         {
-            v = vnext;
-            vstep = 0.0;
-         }
+      // Interpolate, either linear or log depending on mDB.
+      double dt = (tnext - tprev);
+      double to = t - tprev;
+      double v, vstep;
+      if (dt > 0.0)
+      {
+         v = (vprev * (dt - to) + vnext * to) / dt;
+         vstep = (vnext - vprev) * tstep / dt;
+      }
+      else
+      {
+         v = vnext;
+         vstep = 0.0;
+      }
 
-         // An adjustment if logarithmic scale.
-         if( mDB )
-         {
-            v = pow(10.0, v);
-            vstep = pow( 10.0, vstep );
-         }
+      // An adjustment if logarithmic scale.
+      if( mDB )
+      {
+         v = pow(10.0, v);
+         vstep = pow( 10.0, vstep );
+      }
 
-         buffer[b] = v;
-      } else {
-         if (mDB){
+      // Step incrementally to the end of the interval, filling a constant
+      // interval without arithmetic
+      const bool constant = (vprev == vnext);
+      buffer[b++] = v;
+      t += tstep;
+      for (; b < bufferLen; ++b, t += tstep) {
+         tplus = t + increment;
+         // be careful to get the correct limit even in case epsilon == 0
+         if ( leftLimit ? tplus > tnext : tplus >= tnext )
+            break;
+         if (constant)
+            buffer[b] = v;
+         else if (mDB)
             buffer[b] = buffer[b - 1] * vstep;
-         }else{
+         else
             buffer[b] = buffer[b - 1] + vstep;
-         }
       }
-
-      t += tstep;
    }
 }
 
+bool Envelope::IsConstant(double *pValue) const
+{
+   const auto value = mEnv.empty() ? mDefaultValue : mEnv[0].GetVal();
+   for (const auto &point : mEnv)
+      if (point.GetVal() != value)
+         return false;
+   if (pValue)
+      *pValue = value;
+   return true;
+}
+
 // relative time
 int Envelope::NumberOfPointsAfter(double t) const
 {
@@ -13,6 +13,7 @@
 
 #include <stdlib.h>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 
 #include "xml/XMLTagHandler.h"
@@ -95,6 +96,9 @@ public:
    // and repaired
    bool ConsistencyCheck();
 
+   // Return true if the other would serve as a copy of this envelope
+   bool HasSameContents(const Envelope &other) const;
+
    double GetOffset() const { return mOffset; }
    double GetTrackLen() const { return mTrackLen; }
 
@@ -144,6 +148,12 @@ public:
     * more than one value in a row. */
    void GetValues(double *buffer, int len, double t0, double tstep) const;
 
+   /** \brief Whether the envelope has one value everywhere, as when it has no
+    * points, or all its points have the same value
+    *
+    * If so, and pValue is not null, store the value there. */
+   bool IsConstant(double *pValue = nullptr) const;
+
    // Guarantee an envelope point at the end of the domain.
    void Cap( double sampleDur );
 
@@ -260,7 +270,7 @@ private:
    bool mDragPointValid { false };
    int mDragPoint { -1 };
 
-   mutable int mSearchGuess { -2 };
+   mutable std::atomic<int> mSearchGuess { -2 };
 };
 
 inline void EnvPoint::SetVal( Envelope *pEnvelope, double val )
@@ -24,6 +24,7 @@
 #include "Audacity.h"
 #include "Mix.h"
 
+#include <algorithm>
 #include <math.h>
 
 #include <wx/textctrl.h>
@@ -34,6 +35,7 @@
 #include "WaveTrack.h"
 #include "Prefs.h"
 #include "Resample.h"
+#include "SimdFuncs.h"
 #include "TimeTrack.h"
 #include "float_cast.h"
 
@@ -362,9 +364,11 @@ void Mixer::Clear()
 }
 
 void MixBuffers(unsigned numChannels, int *channelFlags, float *gains,
-                samplePtr src, SampleBuffer *dests,
-                int len, bool interleaved)
+                constSamplePtr src, SampleBuffer *dests,
+                int len, bool interleaved, const double *envelope = nullptr)
 {
+   // the actual mixing process, with the envelope applied in the same pass
+   const auto mixAdd = GetMixAddFunction();
    for (unsigned int c = 0; c < numChannels; c++) {
       if (!channelFlags[c])
          continue;
@@ -380,13 +384,8 @@ void MixBuffers(unsigned numChannels, int *channelFlags, float *gains,
          skip = 1;
       }
 
-      float gain = gains[c];
-      float *dest = (float *)destPtr;
-      float *temp = (float *)src;
-      for (int j = 0; j < len; j++) {
-         *dest += temp[j] * gain;   // the actual mixing process
-         dest += skip;
-      }
+      mixAdd((const float *)src, envelope, gains[c], (float *)destPtr,
+         skip, len);
    }
 }
 
@@ -459,6 +458,7 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
 
          // Nothing to do if past end of play interval
          if (getLen > 0) {
+            bool hasEnvelope;
             if (backwards) {
                auto results = cache.Get(floatSample, *pos - (getLen - 1), getLen, mMayThrow);
                if (results)
@@ -466,7 +466,7 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
                else
                   memset(&queue[*queueLen], 0, sizeof(float) * getLen);
 
-               track->GetEnvelopeValues(mEnvValues.get(),
+               hasEnvelope = track->GetEnvelopeValues(mEnvValues.get(),
                                         getLen,
                                         (*pos - (getLen- 1)).as_double() / trackRate);
                *pos -= getLen;
@@ -478,16 +478,17 @@ size_t Mixer::MixVariableRates(int *channelFlags, WaveTrackCache &cache,
                else
                   memset(&queue[*queueLen], 0, sizeof(float) * getLen);
 
-               track->GetEnvelopeValues(mEnvValues.get(),
+               hasEnvelope = track->GetEnvelopeValues(mEnvValues.get(),
                                         getLen,
                                         (*pos).as_double() / trackRate);
 
                *pos += getLen;
             }
 
-            for (decltype(getLen) i = 0; i < getLen; i++) {
-               queue[(*queueLen) + i] *= mEnvValues[i];
-            }
+            if (hasEnvelope)
+               for (decltype(getLen) i = 0; i < getLen; i++) {
+                  queue[(*queueLen) + i] *= mEnvValues[i];
+               }
 
             if (backwards)
                ReverseSamples((samplePtr)&queue[0], floatSample,
@@ -588,40 +589,48 @@ size_t Mixer::MixSameRate(int *channelFlags, WaveTrackCache &cache,
       sampleCount{ (backwards ? t - tEnd : tEnd - t) * track->GetRate() + 0.5 }
    );
 
+   const float *src = nullptr;
+   bool hasEnvelope = false;
    if (backwards) {
       auto results = cache.Get(floatSample, *pos - (slen - 1), slen, mMayThrow);
-      if (results)
+      if (results) {
          memcpy(mFloatBuffer.get(), results, sizeof(float) * slen);
-      else
-         memset(mFloatBuffer.get(), 0, sizeof(float) * slen);
-      track->GetEnvelopeValues(mEnvValues.get(), slen, t - (slen - 1) / mRate);
-      for(decltype(slen) i = 0; i < slen; i++)
-         mFloatBuffer[i] *= mEnvValues[i]; // Track gain control will go here?
-      ReverseSamples((samplePtr)mFloatBuffer.get(), floatSample, 0, slen);
+         src = mFloatBuffer.get();
+      }
+      hasEnvelope = track->GetEnvelopeValues(
+         mEnvValues.get(), slen, t - (slen - 1) / mRate);
+      if (src) {
+         ReverseSamples((samplePtr)mFloatBuffer.get(), floatSample, 0, slen);
+         if (hasEnvelope)
+            std::reverse(mEnvValues.get(), mEnvValues.get() + slen);
+      }
 
       *pos -= slen;
    }
    else {
-      auto results = cache.Get(floatSample, *pos, slen, mMayThrow);
-      if (results)
-         memcpy(mFloatBuffer.get(), results, sizeof(float) * slen);
-      else
-         memset(mFloatBuffer.get(), 0, sizeof(float) * slen);
-      track->GetEnvelopeValues(mEnvValues.get(), slen, t);
-      for(decltype(slen) i = 0; i < slen; i++)
-         mFloatBuffer[i] *= mEnvValues[i]; // Track gain control will go here?
+      // Mix straight from the cache, without a copy
+      src = (const float *)cache.Get(floatSample, *pos, slen, mMayThrow);
+      if (src)
+         hasEnvelope = track->GetEnvelopeValues(mEnvValues.get(), slen, t);
 
       *pos += slen;
    }
 
+   // Nothing to add, if there are no samples
+   if (!src)
+      return slen;
+
    for(size_t c=0; c<mNumChannels; c++)
       if (mApplyTrackGains)
          mGains[c] = track->GetChannelGain(c);
       else
          mGains[c] = 1.0;
 
+   // Apply envelope, gain, and pan in one pass; or skip the envelope if it is
+   // all ones
    MixBuffers(mNumChannels, channelFlags, mGains.get(),
-              (samplePtr)mFloatBuffer.get(), mTemp.get(), slen, mInterleaved);
+              (constSamplePtr)src, mTemp.get(), slen, mInterleaved,
+              hasEnvelope ? mEnvValues.get() : nullptr);
 
    return slen;
 }
@@ -10,12 +10,20 @@ Paul Licameli split from AudacityProject.cpp
 
 #include "ProjectFileIO.h"
 
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <sqlite3.h>
 #include <wx/crt.h>
 #include <wx/frame.h>
 #include <wx/progdlg.h>
 #include <wx/sstream.h>
+#include <wx/stopwatch.h>
 #include <wx/xml/xml.h>
 
 #include "ActiveProjects.h"
@@ -25,16 +33,18 @@ Paul Licameli split from AudacityProject.cpp
 #include "ProjectSerializer.h"
 #include "ProjectSettings.h"
 #include "SampleBlock.h"
+#include "SampleBlockCodec.h"
 #include "Tags.h"
 #include "TempDirectory.h"
 #include "ViewInfo.h"
+#include "WaveClip.h"
 #include "WaveTrack.h"
 #include "widgets/AudacityMessageBox.h"
 #include "widgets/ErrorDialog.h"
 #include "widgets/NumericTextCtrl.h"
 #include "widgets/ProgressDialog.h"
 #include "wxFileNameWrapper.h"
-#include "xml/XMLFileReader.h"
+#include "prefs/QualityPrefs.h"
 
 #undef NO_SHM
 #if !defined(__WXMSW__)
@@ -72,6 +82,12 @@ static const int ProjectFileID = PACK('A', 'U', 'D', 'Y');
 // header.
 static const int ProjectFileVersion = PACK(3, 0, 0, 0);
 
+// Files whose sampleblocks table has the codec column have this version
+// instead, because earlier versions would misread the compressed blocks.
+// The column is added only to new projects, and only when preferences
+// choose compression.
+static const int CodecProjectFileVersion = PACK(3, 0, 3, 0);
+
 // Navigation:
 //
 // Bindings are marked out in the code by, e.g. 
@@ -138,7 +154,9 @@ static const char *ProjectFileSchema =
    // blockID is a 64 bit number.
    //
    // Rows are immutable -- never updated after addition, but may be
-   // deleted.
+   // deleted.  The exception is that summin to summary64k may be filled
+   // in later, when their computation is deferred; summary blobs are then
+   // empty until that happens.
    //
    // summin to summary64K are summaries at 3 distance scales.
    "CREATE TABLE IF NOT EXISTS <schema>.sampleblocks"
@@ -153,6 +171,156 @@ static const char *ProjectFileSchema =
    "  samples              BLOB"
    ");";
 
+// The codec and samplecount columns, when present, are the last in the
+// sampleblocks table.  codec tells how samples are encoded, as enum
+// SampleBlockCodec (see SampleBlockCodec.h); zero means raw samples as
+// above.  samplecount is the number of samples, which the length of
+// encoded samples does not tell.
+static const char *SampleBlockCodecSchema =
+   "ALTER TABLE <schema>.sampleblocks"
+   "  ADD COLUMN codec INTEGER NOT NULL DEFAULT 0;"
+   "ALTER TABLE <schema>.sampleblocks"
+   "  ADD COLUMN samplecount INTEGER NOT NULL DEFAULT 0;"
+   "PRAGMA <schema>.user_version = %d;";
+
+// CREATE SQL sampleblockusage
+// Totals over sampleblocks for each sampleformat:  the number of rows, and
+// the bytes of samples and summaries.  The triggers keep them up to date,
+// so that the space used by all blocks is known without a scan.
+// Older versions keep the totals too, because the triggers are in the file.
+#define SAMPLE_BLOCK_BYTES(row) \
+   "ifnull(length(" row ".samples), 0) +" \
+   "ifnull(length(" row ".summary256), 0) +" \
+   "ifnull(length(" row ".summary64k), 0)"
+
+static const char *BlockUsageSchema =
+   "CREATE TABLE IF NOT EXISTS <schema>.sampleblockusage"
+   "("
+   "  sampleformat         INTEGER PRIMARY KEY,"
+   "  blocks               INTEGER NOT NULL,"
+   "  bytes                INTEGER NOT NULL"
+   ");"
+   ""
+   "CREATE TRIGGER IF NOT EXISTS <schema>.sampleblockusage_insert"
+   "  AFTER INSERT ON sampleblocks"
+   "  BEGIN"
+   "    INSERT OR IGNORE INTO sampleblockusage VALUES(NEW.sampleformat, 0, 0);"
+   "    UPDATE sampleblockusage"
+   "      SET blocks = blocks + 1, bytes = bytes + " SAMPLE_BLOCK_BYTES("NEW")
+   "      WHERE sampleformat = NEW.sampleformat;"
+   "  END;"
+   ""
+   "CREATE TRIGGER IF NOT EXISTS <schema>.sampleblockusage_delete"
+   "  AFTER DELETE ON sampleblocks"
+   "  BEGIN"
+   "    UPDATE sampleblockusage"
+   "      SET blocks = blocks - 1, bytes = bytes - " SAMPLE_BLOCK_BYTES("OLD")
+   "      WHERE sampleformat = OLD.sampleformat;"
+   "  END;"
+   ""
+   // Summaries are updated when their computation was deferred
+   "CREATE TRIGGER IF NOT EXISTS <schema>.sampleblockusage_update"
+   "  AFTER UPDATE OF sampleformat, samples, summary256, summary64k"
+   "  ON sampleblocks"
+   "  BEGIN"
+   "    UPDATE sampleblockusage"
+   "      SET blocks = blocks - 1, bytes = bytes - " SAMPLE_BLOCK_BYTES("OLD")
+   "      WHERE sampleformat = OLD.sampleformat;"
+   "    INSERT OR IGNORE INTO sampleblockusage VALUES(NEW.sampleformat, 0, 0);"
+   "    UPDATE sampleblockusage"
+   "      SET blocks = blocks + 1, bytes = bytes + " SAMPLE_BLOCK_BYTES("NEW")
+   "      WHERE sampleformat = NEW.sampleformat;"
+   "  END;"
+   ""
+   // Count what is there already, when the table is new to the file
+   "INSERT OR IGNORE INTO <schema>.sampleblockusage"
+   "  SELECT sampleformat, count(*), sum(" SAMPLE_BLOCK_BYTES("sampleblocks") ")"
+   "    FROM <schema>.sampleblocks GROUP BY sampleformat;";
+
+// CREATE SQL sampleblockhashes
+// A hash of the samples of each block, so that a new block with the same
+// samples as an existing one can share its row instead of adding another.
+// Blocks written without a hash, as by older versions, are never shared.
+// The trigger forgets the hashes of deleted rows, in older versions too.
+static const char *BlockHashSchema =
+   "CREATE TABLE IF NOT EXISTS <schema>.sampleblockhashes"
+   "("
+   "  blockid              INTEGER PRIMARY KEY,"
+   "  hash                 INTEGER NOT NULL"
+   ");"
+   ""
+   "CREATE INDEX IF NOT EXISTS <schema>.sampleblockhashes_hash"
+   "  ON sampleblockhashes (hash);"
+   ""
+   "CREATE TRIGGER IF NOT EXISTS <schema>.sampleblockhashes_delete"
+   "  AFTER DELETE ON sampleblocks"
+   "  BEGIN"
+   "    DELETE FROM sampleblockhashes WHERE blockid = OLD.blockid;"
+   "  END;";
+
+// CREATE SQL autosavelayout
+// CREATE SQL autosavefragments
+// An alternative to the autosave table, made on demand, in which the
+// document is cut into pieces, so that saving after an edit rewrites only
+// the pieces that changed.
+// autosavelayout has one instance only.  id is always 1.
+// dict is as for autosave.
+// doc is the binary document, except that each wave clip, and each track
+// other than a wave track, is missing.
+// refs says where the missing pieces go:  pairs of 64 bit little-endian
+// numbers, a byte offset into doc and an id of autosavefragments, sorted
+// by offset.
+// autosavefragments doc is one piece, in the dictionary of the layout.
+// Older versions ignore these tables.
+static const char *AutoSaveFragmentsSchema =
+   "CREATE TABLE IF NOT EXISTS main.autosavelayout"
+   "("
+   "  id                   INTEGER PRIMARY KEY,"
+   "  dict                 BLOB,"
+   "  doc                  BLOB,"
+   "  refs                 BLOB"
+   ");"
+   ""
+   "CREATE TABLE IF NOT EXISTS main.autosavefragments"
+   "("
+   "  id                   INTEGER PRIMARY KEY,"
+   "  doc                  BLOB"
+   ");";
+
+struct ProjectFileIO::AutoSaveCache
+{
+   // The connection that the fragment tables belong to
+   sqlite3 *db{};
+
+   // Set, perhaps in another thread, when a savepoint that enclosed the
+   // writes rolled back, so that the tables no longer match
+   std::atomic<bool> rolledBack{ false };
+
+   // Copies of wave tracks as last saved, made with SharingDuplicate(), so
+   // that each clip that did not change since is the same object as
+   // before, and the fragment of each of those clips
+   struct WaveTrackEntry
+   {
+      Track::Holder snapshot;
+      std::unordered_map<const WaveClip *, long long> fragments;
+   };
+   std::map<TrackId, WaveTrackEntry> waveTracks;
+
+   // Other tracks are compared by their serialization
+   struct TrackEntry
+   {
+      wxMemoryBuffer data;
+      long long fragment;
+   };
+   std::map<TrackId, TrackEntry> otherTracks;
+
+   // Fragments of tracks without ids, such as the new tracks of a recording,
+   // which are written again each time, so the next pass deletes these
+   std::vector<long long> uncachedFragments;
+
+   long long nextFragment{ 1 };
+};
+
 // This singleton handles initialization/shutdown of the SQLite library.
 // It is needed because our local SQLite is built with SQLITE_OMIT_AUTOINIT
 // defined.
@@ -396,6 +564,10 @@ bool ProjectFileIO::CloseConnection()
    if (!curConn)
       return false;
 
+   // Release the copies of tracks, and so maybe delete sample blocks, while
+   // the connection is still open
+   mpAutoSaveCache.reset();
+
    if (!curConn->Close())
    {
       return false;
@@ -414,6 +586,7 @@ void ProjectFileIO::SaveConnection()
    // Should do nothing in proper usage, but be sure not to leak a connection:
    DiscardConnection();
 
+   mpAutoSaveCache.reset();
    mPrevConn = std::move(CurrConn());
    mPrevFileName = mFileName;
    mPrevTemporary = mTemporary;
@@ -458,6 +631,8 @@ void ProjectFileIO::DiscardConnection()
 // Close any current connection and switch back to using the saved
 void ProjectFileIO::RestoreConnection()
 {
+   mpAutoSaveCache.reset();
+
    auto &curConn = CurrConn();
    if (curConn)
    {
@@ -624,7 +799,17 @@ bool ProjectFileIO::CheckVersion()
    // must be a new project file.
    if (wxStrtol<char **>(result, nullptr, 10) == 0)
    {
-      return InstallSchema(db);
+      if (!InstallSchema(db))
+         return false;
+
+      if (QualityPrefs::SampleBlockCodecChoice() != SampleBlockCodec::None)
+      {
+         if (!InstallCodecSchema(db))
+            return false;
+         CurrConn()->SetSampleBlockCodecs(true);
+      }
+
+      return true;
    }
 
    // Check for our application ID
@@ -650,7 +835,7 @@ bool ProjectFileIO::CheckVersion()
 
    // Project file version is higher than ours. We will refuse to
    // process it since we can't trust anything about it.
-   if (version > ProjectFileVersion)
+   if (version > CodecProjectFileVersion)
    {
       SetError(
          XO("This project was created with a newer version of Audacity.\n\nYou will need to upgrade to open it.")
@@ -662,10 +847,12 @@ bool ProjectFileIO::CheckVersion()
    // upgrade.
    if (version < ProjectFileVersion)
    {
-      return UpgradeSchema();
+      if (!UpgradeSchema())
+         return false;
    }
 
-   return true;
+   // Files from before the usage totals or the hashes gain them now
+   return InstallBlockUsageSchema(db) && InstallBlockHashSchema(db);
 }
 
 bool ProjectFileIO::InstallSchema(sqlite3 *db, const char *schema /* = "main" */)
@@ -685,6 +872,94 @@ bool ProjectFileIO::InstallSchema(sqlite3 *db, const char *schema /* = "main" */
       return false;
    }
 
+   return InstallBlockUsageSchema(db, schema) &&
+      InstallBlockHashSchema(db, schema);
+}
+
+bool ProjectFileIO::InstallBlockUsageSchema(sqlite3 *db, const char *schema /* = "main" */)
+{
+   int rc;
+
+   wxString sql;
+   sql.Printf(
+      "SELECT Count(*) FROM %s.sqlite_master"
+      "   WHERE type = 'table' AND name = 'sampleblockusage';", schema);
+
+   wxString result;
+   if (!GetValue(sql, result))
+   {
+      return false;
+   }
+
+   if (wxStrtol<char **>(result, nullptr, 10) != 0)
+   {
+      return true;
+   }
+
+   // Create the table and the triggers, and count the existing blocks, all
+   // or nothing
+   sql = BlockUsageSchema;
+   sql.Replace("<schema>", schema);
+   sql = "SAVEPOINT InstallBlockUsage;" + sql + "RELEASE InstallBlockUsage;";
+
+   rc = sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
+   if (rc != SQLITE_OK)
+   {
+      SetDBError(
+         XO("Unable to initialize the project file")
+      );
+      sqlite3_exec(db,
+         "ROLLBACK TO InstallBlockUsage;"
+         "RELEASE InstallBlockUsage;",
+         nullptr, nullptr, nullptr);
+      return false;
+   }
+
+   return true;
+}
+
+bool ProjectFileIO::InstallBlockHashSchema(sqlite3 *db, const char *schema /* = "main" */)
+{
+   int rc;
+
+   // Every statement is conditional, so there is no need to look first
+   wxString sql = BlockHashSchema;
+   sql.Replace("<schema>", schema);
+   sql = "SAVEPOINT InstallBlockHash;" + sql + "RELEASE InstallBlockHash;";
+
+   rc = sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
+   if (rc != SQLITE_OK)
+   {
+      SetDBError(
+         XO("Unable to initialize the project file")
+      );
+      sqlite3_exec(db,
+         "ROLLBACK TO InstallBlockHash;"
+         "RELEASE InstallBlockHash;",
+         nullptr, nullptr, nullptr);
+      return false;
+   }
+
+   return true;
+}
+
+bool ProjectFileIO::InstallCodecSchema(sqlite3 *db, const char *schema /* = "main" */)
+{
+   int rc;
+
+   wxString sql;
+   sql.Printf(SampleBlockCodecSchema, CodecProjectFileVersion);
+   sql.Replace("<schema>", schema);
+
+   rc = sqlite3_exec(db, sql, nullptr, nullptr, nullptr);
+   if (rc != SQLITE_OK)
+   {
+      SetDBError(
+         XO("Unable to initialize the project file")
+      );
+      return false;
+   }
+
    return true;
 }
 
@@ -777,6 +1052,192 @@ bool ProjectFileIO::DeleteBlocks(const BlockIDs &blockids, bool complement)
    return true;
 }
 
+namespace {
+
+// One row of the sampleblocks table, of whatever columns it has
+struct BlockRow
+{
+   struct Value
+   {
+      int type; // SQLITE_INTEGER, etc.
+      sqlite3_int64 integer;
+      double real;
+      std::vector<char> bytes; // for blobs and text
+   };
+   std::vector<Value> values;
+   size_t bytes{ 0 };
+};
+
+// Reads sample block rows in a worker thread, using its own connection to
+// the database file, and hands them over through a bounded queue, so that
+// reading overlaps the writing of the copy
+class BlockReader
+{
+public:
+   BlockReader(const char *fileName, std::vector<SampleBlockID> blockids)
+      : mFileName{ fileName }
+      , mBlockIDs{ std::move(blockids) }
+   {
+      // Read in order of the table's b-tree
+      std::sort(mBlockIDs.begin(), mBlockIDs.end());
+      mThread = std::thread([this]{ Run(); });
+   }
+
+   ~BlockReader()
+   {
+      {
+         std::lock_guard<std::mutex> guard(mMutex);
+         mStop = true;
+      }
+      mCondition.notify_all();
+      mThread.join();
+   }
+
+   //! Wait for the next row; false at the end, or after an error
+   bool Next(BlockRow &row)
+   {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [this]{ return !mQueue.empty() || mDone; });
+      if (mQueue.empty())
+         return false;
+      row = std::move(mQueue.front());
+      mQueue.pop_front();
+      mQueuedBytes -= row.bytes;
+      lock.unlock();
+      mCondition.notify_all();
+      return true;
+   }
+
+   //! Valid after Next() returns false
+   bool Failed() const { return !mError.empty(); }
+   const std::string &GetError() const { return mError; }
+
+private:
+   // Bound on memory used by rows read but not yet written
+   static constexpr size_t MaxQueuedBytes = 32 * 1024 * 1024;
+
+   void Run()
+   {
+      std::string error;
+      {
+         sqlite3 *db = nullptr;
+         sqlite3_stmt *stmt = nullptr;
+         auto cleanup = finally([&]
+         {
+            // No need to check return codes
+            sqlite3_finalize(stmt);
+            if (db)
+            {
+               sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+               sqlite3_close(db);
+            }
+         });
+
+         // Read-only, so that the reader never takes a write lock or makes
+         // a journal
+         int rc = sqlite3_open_v2(mFileName.c_str(), &db,
+            SQLITE_OPEN_READONLY, nullptr);
+         if (rc == SQLITE_OK)
+            rc = sqlite3_busy_timeout(db, 5000);
+         // One read transaction sees a consistent state and saves locking
+         if (rc == SQLITE_OK)
+            rc = sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+         if (rc == SQLITE_OK)
+            rc = sqlite3_prepare_v2(db,
+               "SELECT * FROM sampleblocks WHERE blockid = ?1;",
+               -1, &stmt, nullptr);
+
+         for (auto iter = mBlockIDs.begin();
+            rc == SQLITE_OK && iter != mBlockIDs.end(); ++iter)
+         {
+            rc = sqlite3_bind_int64(stmt, 1, *iter);
+            if (rc != SQLITE_OK)
+               break;
+
+            // A missing row is skipped, as the INSERT ... SELECT did before
+            rc = sqlite3_step(stmt);
+            if (rc == SQLITE_ROW)
+            {
+               BlockRow row;
+               const int columns = sqlite3_column_count(stmt);
+               row.values.resize(columns);
+               for (int ii = 0; ii < columns; ++ii)
+               {
+                  auto &value = row.values[ii];
+                  value.type = sqlite3_column_type(stmt, ii);
+                  switch (value.type)
+                  {
+                  case SQLITE_INTEGER:
+                     value.integer = sqlite3_column_int64(stmt, ii);
+                     break;
+                  case SQLITE_FLOAT:
+                     value.real = sqlite3_column_double(stmt, ii);
+                     break;
+                  case SQLITE_BLOB:
+                  case SQLITE_TEXT:
+                  {
+                     auto data = static_cast<const char *>(
+                        value.type == SQLITE_BLOB
+                           ? sqlite3_column_blob(stmt, ii)
+                           : (const void *) sqlite3_column_text(stmt, ii));
+                     value.bytes.assign(data,
+                        data + sqlite3_column_bytes(stmt, ii));
+                     row.bytes += value.bytes.size();
+                     break;
+                  }
+                  default:
+                     break;
+                  }
+               }
+
+               std::unique_lock<std::mutex> lock(mMutex);
+               mCondition.wait(lock, [&]{
+                  return mStop || mQueue.empty() ||
+                     mQueuedBytes + row.bytes <= MaxQueuedBytes; });
+               if (mStop)
+               {
+                  rc = SQLITE_OK;
+                  break;
+               }
+               mQueuedBytes += row.bytes;
+               mQueue.push_back(std::move(row));
+               lock.unlock();
+               mCondition.notify_all();
+
+               rc = sqlite3_step(stmt);
+            }
+            if (rc == SQLITE_DONE)
+               rc = sqlite3_reset(stmt);
+            else
+               sqlite3_reset(stmt);
+         }
+
+         if (rc != SQLITE_OK && rc != SQLITE_DONE)
+            error = db ? sqlite3_errmsg(db) : sqlite3_errstr(rc);
+      }
+
+      std::lock_guard<std::mutex> guard(mMutex);
+      mError = std::move(error);
+      mDone = true;
+      mCondition.notify_all();
+   }
+
+   const std::string mFileName;
+   std::vector<SampleBlockID> mBlockIDs;
+
+   std::mutex mMutex;
+   std::condition_variable mCondition;
+   std::deque<BlockRow> mQueue;
+   size_t mQueuedBytes{ 0 };
+   bool mStop{ false };
+   bool mDone{ false };
+   std::string mError;
+
+   std::thread mThread;
+};
+
+}
+
 bool ProjectFileIO::CopyTo(const FilePath &destpath,
    const TranslatableString &msg,
    bool isTemporary,
@@ -895,6 +1356,13 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
       return false;
    }
 
+   // Tables must have the same columns for the copying of rows below
+   if (pConn->HasSampleBlockCodecs() && !InstallCodecSchema(db, "outbound"))
+   {
+      // Message already set
+      return false;
+   }
+
    {
       // Ensure statement gets cleaned up
       sqlite3_stmt *stmt = nullptr;
@@ -907,22 +1375,6 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
          }
       });
 
-      // Prepare the statement only once
-      rc = sqlite3_prepare_v2(db,
-                              "INSERT INTO outbound.sampleblocks"
-                              "  SELECT * FROM main.sampleblocks"
-                              "  WHERE blockid = ?;",
-                              -1,
-                              &stmt,
-                              nullptr);
-      if (rc != SQLITE_OK)
-      {
-         SetDBError(
-            XO("Unable to prepare project file command:\n\n%s").Format(sql)
-         );
-         return false;
-      }
-
       /* i18n-hint: This title appears on a dialog that indicates the progress
          in doing something.*/
       ProgressDialog progress(XO("Progress"), msg, pdlgHideStopButton);
@@ -930,6 +1382,7 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
 
       wxLongLong_t count = 0;
       wxLongLong_t total = blockids.size();
+      double bytes = 0;
 
       // Start a transaction.  Since we're running without a journal,
       // this really doesn't provide rollback.  It just prevents SQLite
@@ -940,18 +1393,70 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
       // to delete the database anyway.
       sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
 
+      // Rows are read from the main DB in another thread while this one
+      // writes them to the outbound DB
+      BlockReader reader{ sqlite3_db_filename(db, "main"),
+         std::vector<SampleBlockID>( blockids.begin(), blockids.end() ) };
+
+      wxStopWatch timer;
+      long lastReport = 0;
+
       // Copy sample blocks from the main DB to the outbound DB
-      for (auto blockid : blockids)
+      BlockRow row;
+      while (reader.Next(row))
       {
+         // Prepare the statement only once, when the number of columns
+         // is known
+         if (!stmt)
+         {
+            sql = "INSERT INTO outbound.sampleblocks VALUES(?1";
+            for (size_t ii = 2; ii <= row.values.size(); ++ii)
+               sql += wxString::Format(",?%d", (int) ii);
+            sql += ");";
+
+            rc = sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
+            if (rc != SQLITE_OK)
+            {
+               SetDBError(
+                  XO("Unable to prepare project file command:\n\n%s").Format(sql)
+               );
+               return false;
+            }
+         }
+
          // Bind statement parameters
-         rc = sqlite3_bind_int64(stmt, 1, blockid);
-         if (rc != SQLITE_OK)
+         for (size_t ii = 0; ii < row.values.size(); ++ii)
          {
-            SetDBError(
-               XO("Failed to bind SQL parameter")
-            );
+            const auto &value = row.values[ii];
+            const int param = ii + 1;
+            switch (value.type)
+            {
+            case SQLITE_INTEGER:
+               rc = sqlite3_bind_int64(stmt, param, value.integer);
+               break;
+            case SQLITE_FLOAT:
+               rc = sqlite3_bind_double(stmt, param, value.real);
+               break;
+            case SQLITE_BLOB:
+               rc = sqlite3_bind_blob(stmt, param,
+                  value.bytes.data(), value.bytes.size(), SQLITE_STATIC);
+               break;
+            case SQLITE_TEXT:
+               rc = sqlite3_bind_text(stmt, param,
+                  value.bytes.data(), value.bytes.size(), SQLITE_STATIC);
+               break;
+            default:
+               rc = sqlite3_bind_null(stmt, param);
+               break;
+            }
+            if (rc != SQLITE_OK)
+            {
+               SetDBError(
+                  XO("Failed to bind SQL parameter")
+               );
 
-            return false;
+               return false;
+            }
          }
 
          // Process it
@@ -970,7 +1475,21 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
             THROW_INCONSISTENCY_EXCEPTION;
          }
 
-         result = progress.Update(++count, total);
+         ++count;
+         bytes += row.bytes;
+
+         // Report throughput now and then
+         const auto elapsed = timer.Time();
+         if (elapsed - lastReport >= 500)
+         {
+            lastReport = elapsed;
+            const double seconds = elapsed / 1000.0;
+            result = progress.Update(count, total,
+               XO("%s\n%.0f blocks per second, %.1f MB per second")
+                  .Format(msg, count / seconds, bytes / 1048576.0 / seconds));
+         }
+         else
+            result = progress.Update(count, total);
          if (result != ProgressResult::Success)
          {
             // Note that we're not setting success, so the finally
@@ -979,6 +1498,34 @@ bool ProjectFileIO::CopyTo(const FilePath &destpath,
          }
       }
 
+      if (reader.Failed())
+      {
+         SetError(
+            XO("Unable to read sample blocks from the project file"),
+            Verbatim(reader.GetError())
+         );
+         return false;
+      }
+
+      wxLogDebug(wxT("Copied %lld blocks, %.1f MB, in %ld ms"),
+         count, bytes / 1048576.0, timer.Time());
+
+      // Copy the hashes of the copied blocks, so that they can still be
+      // shared
+      rc = sqlite3_exec(db,
+         "INSERT INTO outbound.sampleblockhashes"
+         "  SELECT blockid, hash FROM main.sampleblockhashes"
+         "    WHERE blockid IN (SELECT blockid FROM outbound.sampleblocks);",
+         nullptr, nullptr, nullptr);
+      if (rc != SQLITE_OK)
+      {
+         SetDBError(
+            XO("Failed to update the project file.\nThe following command failed:\n\n%s")
+               .Format("INSERT INTO outbound.sampleblockhashes")
+         );
+         return false;
+      }
+
       // Write the doc.
       //
       // If we're compacting a temporary project (user initiated from the File
@@ -1026,16 +1573,9 @@ bool ProjectFileIO::ShouldCompact(const std::vector<const TrackList *> &tracks)
 
    // Get the number of blocks and total length from the project file.
    unsigned long long total = GetTotalUsage();
-   unsigned long long blockcount = 0;
-   
-   auto cb = [&blockcount](int cols, char **vals, char **)
-   {
-      // Convert
-      wxString(vals[0]).ToULongLong(&blockcount);
-      return 0;
-   };
+   unsigned long long blockcount = GetBlockCount();
 
-   if (!Query("SELECT Count(*) FROM sampleblocks;", cb) || blockcount == 0)
+   if (blockcount == 0)
    {
       // Shouldn't compact since we don't have the full picture
       return false;
@@ -1639,7 +2179,8 @@ void ProjectFileIO::WriteXMLHeader(XMLWriter &xmlFile) const
 
 void ProjectFileIO::WriteXML(XMLWriter &xmlFile,
                              bool recording /* = false */,
-                             const TrackList *tracks /* = nullptr */)
+                             const TrackList *tracks /* = nullptr */,
+                             const TrackWriter &writeTrack /* = {} */)
 // may throw
 {
    auto &proj = mProject;
@@ -1686,7 +2227,10 @@ void ProjectFileIO::WriteXML(XMLWriter &xmlFile,
          // when pushing.  Don't auto-save it.
          return;
       }
-      useTrack->WriteXML(xmlFile);
+      if ( writeTrack )
+         writeTrack( xmlFile, *useTrack );
+      else
+         useTrack->WriteXML(xmlFile);
    });
 
    xmlFile.EndTag(wxT("project"));
@@ -1696,6 +2240,21 @@ void ProjectFileIO::WriteXML(XMLWriter &xmlFile,
 
 bool ProjectFileIO::AutoSave(bool recording)
 {
+   if (gPrefs->ReadBool(wxT("/FileFormats/AutoSaveFragments"), true))
+   {
+      if (AutoSaveFragments(recording))
+      {
+         mModified = true;
+         return true;
+      }
+
+      return false;
+   }
+
+   // The fragment tables, if any, become stale, but the autosave document
+   // takes precedence in LoadProject()
+   mpAutoSaveCache.reset();
+
    ProjectSerializer autosave;
    WriteXMLHeader(autosave);
    WriteXML(autosave, recording);
@@ -1709,6 +2268,24 @@ bool ProjectFileIO::AutoSave(bool recording)
    return false;
 }
 
+static bool HasAutoSaveFragments(sqlite3 *db)
+{
+   sqlite3_stmt *stmt = nullptr;
+   auto cleanup = finally([&]
+   {
+      if (stmt)
+      {
+         sqlite3_finalize(stmt);
+      }
+   });
+
+   return sqlite3_prepare_v2(db,
+      "SELECT 1 FROM sqlite_master"
+      "   WHERE type = 'table' AND name = 'autosavelayout';",
+      -1, &stmt, nullptr) == SQLITE_OK &&
+      sqlite3_step(stmt) == SQLITE_ROW;
+}
+
 bool ProjectFileIO::AutoSaveDelete(sqlite3 *db /* = nullptr */)
 {
    int rc;
@@ -1718,7 +2295,19 @@ bool ProjectFileIO::AutoSaveDelete(sqlite3 *db /* = nullptr */)
       db = DB();
    }
 
+   if (mpAutoSaveCache && mpAutoSaveCache->db == db)
+   {
+      mpAutoSaveCache.reset();
+   }
+
    rc = sqlite3_exec(db, "DELETE FROM autosave;", nullptr, nullptr, nullptr);
+   if (rc == SQLITE_OK && HasAutoSaveFragments(db))
+   {
+      rc = sqlite3_exec(db,
+         "DELETE FROM autosavelayout;"
+         "DELETE FROM autosavefragments;",
+         nullptr, nullptr, nullptr);
+   }
    if (rc != SQLITE_OK)
    {
       SetDBError(
@@ -1794,11 +2383,441 @@ bool ProjectFileIO::WriteDoc(const char *table,
    return true;
 }
 
-bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
+// Fragments are mostly much smaller than whole documents
+static const size_t FragmentAllocSize = 64 * 1024;
+
+static void AppendLittleEndian(wxMemoryBuffer &buffer, unsigned long long value)
 {
-   bool success = false;
+   for (int ii = 0; ii < 8; ++ii)
+      buffer.AppendByte(static_cast<char>((value >> (8 * ii)) & 0xff));
+}
 
-   auto cleanup = finally([&]
+static unsigned long long ReadLittleEndian(const unsigned char *ptr)
+{
+   unsigned long long value = 0;
+   for (int ii = 8; ii--;)
+      value = (value << 8) | ptr[ii];
+   return value;
+}
+
+bool ProjectFileIO::AutoSaveFragments(bool recording)
+{
+   auto db = DB();
+   auto &conn = GetConnection();
+
+   TransactionScope trans(conn, "AutoSave");
+
+   const AutoSaveCache *pOld = nullptr;
+   if (mpAutoSaveCache && mpAutoSaveCache->db == db &&
+       !mpAutoSaveCache->rolledBack)
+   {
+      pOld = mpAutoSaveCache.get();
+   }
+   else
+   {
+      // Start over, creating the tables if this is an older project file
+      mpAutoSaveCache.reset();
+      int rc = sqlite3_exec(db, AutoSaveFragmentsSchema, nullptr, nullptr, nullptr);
+      if (rc == SQLITE_OK)
+      {
+         rc = sqlite3_exec(db,
+            "DELETE FROM autosave;"
+            "DELETE FROM autosavelayout;"
+            "DELETE FROM autosavefragments;",
+            nullptr, nullptr, nullptr);
+      }
+      if (rc != SQLITE_OK)
+      {
+         SetDBError(
+            XO("Failed to update the project file.")
+         );
+         return false;
+      }
+   }
+
+   auto pNew = std::make_shared<AutoSaveCache>();
+   pNew->db = db;
+   if (pOld)
+   {
+      pNew->nextFragment = pOld->nextFragment;
+   }
+
+   ProjectSerializer layout;
+   std::vector< std::pair<size_t, long long> > refs;
+   bool success = true;
+
+   auto newFragment = [&](const ProjectSerializer &fragment)
+   {
+      auto id = pNew->nextFragment++;
+      if (success)
+      {
+         success = WriteAutoSaveFragment(id, fragment);
+      }
+      return id;
+   };
+
+   auto addRef = [&](long long id)
+   {
+      refs.emplace_back(layout.GetData().GetDataLen(), id);
+   };
+
+   auto writeTrack = [&](XMLWriter &, const Track &track)
+   {
+      // Tracks not in the undo history are not yet given an id; don't cache
+      // them
+      const auto id = track.GetId();
+      const bool cached = (id != TrackId{});
+
+      if (auto pWaveTrack = dynamic_cast<const WaveTrack *>(&track))
+      {
+         const AutoSaveCache::WaveTrackEntry *pPrevious = nullptr;
+         if (pOld && cached)
+         {
+            auto iter = pOld->waveTracks.find(id);
+            if (iter != pOld->waveTracks.end())
+            {
+               pPrevious = &iter->second;
+            }
+         }
+
+         // The copy shares each clip that is unchanged since the last copy
+         AutoSaveCache::WaveTrackEntry entry;
+         entry.snapshot = track.SharingDuplicate(
+            pPrevious ? pPrevious->snapshot.get() : nullptr);
+         const auto &clips =
+            static_cast<const WaveTrack &>(*entry.snapshot).GetClips();
+
+         std::vector<long long> fragments;
+         for (const auto &pClip : clips)
+         {
+            long long fragment = 0;
+            if (pPrevious)
+            {
+               auto found = pPrevious->fragments.find(pClip.get());
+               if (found != pPrevious->fragments.end())
+               {
+                  fragment = found->second;
+               }
+            }
+            if (!fragment)
+            {
+               ProjectSerializer doc(FragmentAllocSize);
+               pClip->WriteXML(doc);
+               fragment = newFragment(doc);
+               if (!cached)
+               {
+                  pNew->uncachedFragments.push_back(fragment);
+               }
+            }
+            entry.fragments.emplace(pClip.get(), fragment);
+            fragments.push_back(fragment);
+         }
+
+         // The copy has the same clips in the same order
+         auto iter = fragments.begin();
+         pWaveTrack->WriteXML(layout, [&](XMLWriter &, const WaveClip &)
+         {
+            addRef(*iter++);
+         });
+
+         if (cached)
+         {
+            pNew->waveTracks.emplace(id, std::move(entry));
+         }
+      }
+      else
+      {
+         ProjectSerializer doc(FragmentAllocSize);
+         track.WriteXML(doc);
+         const auto &data = doc.GetData();
+
+         long long fragment = 0;
+         if (pOld && cached)
+         {
+            auto found = pOld->otherTracks.find(id);
+            if (found != pOld->otherTracks.end())
+            {
+               const auto &previous = found->second.data;
+               if (previous.GetDataLen() == data.GetDataLen() &&
+                   memcmp(previous.GetData(), data.GetData(), data.GetDataLen()) == 0)
+               {
+                  fragment = found->second.fragment;
+               }
+            }
+         }
+         if (!fragment)
+         {
+            fragment = newFragment(doc);
+            if (!cached)
+            {
+               pNew->uncachedFragments.push_back(fragment);
+            }
+         }
+         addRef(fragment);
+
+         if (cached)
+         {
+            pNew->otherTracks.emplace(id, AutoSaveCache::TrackEntry{ data, fragment });
+         }
+      }
+   };
+
+   WriteXMLHeader(layout);
+   WriteXML(layout, recording, nullptr, writeTrack);
+   if (!success)
+   {
+      // Error already set
+      return false;
+   }
+
+   // Delete the fragments that nothing refers to any more
+   if (pOld)
+   {
+      std::unordered_set<long long> used;
+      for (const auto &ref : refs)
+      {
+         used.insert(ref.second);
+      }
+
+      std::unordered_set<long long> unused;
+      for (const auto &pair : pOld->waveTracks)
+      {
+         for (const auto &fragment : pair.second.fragments)
+         {
+            if (!used.count(fragment.second))
+            {
+               unused.insert(fragment.second);
+            }
+         }
+      }
+      for (const auto &pair : pOld->otherTracks)
+      {
+         if (!used.count(pair.second.fragment))
+         {
+            unused.insert(pair.second.fragment);
+         }
+      }
+      unused.insert(
+         pOld->uncachedFragments.begin(), pOld->uncachedFragments.end());
+
+      auto stmt = conn.Prepare(DBConnection::DeleteAutoSaveFragment,
+         "DELETE FROM autosavefragments WHERE id = ?1;");
+      for (auto id : unused)
+      {
+         sqlite3_bind_int64(stmt, 1, id);
+         int rc = sqlite3_step(stmt);
+         sqlite3_clear_bindings(stmt);
+         sqlite3_reset(stmt);
+         if (rc != SQLITE_DONE)
+         {
+            SetDBError(
+               XO("Failed to update the project file.")
+            );
+            return false;
+         }
+      }
+   }
+
+   wxMemoryBuffer refsBuffer;
+   for (const auto &ref : refs)
+   {
+      AppendLittleEndian(refsBuffer, ref.first);
+      AppendLittleEndian(refsBuffer, ref.second);
+   }
+
+   const char *sql =
+      "INSERT INTO autosavelayout(id, dict, doc, refs) VALUES(1, ?1, ?2, ?3)"
+      "       ON CONFLICT(id) DO UPDATE SET dict = ?1, doc = ?2, refs = ?3;";
+
+   sqlite3_stmt *stmt = nullptr;
+   auto cleanup = finally([&]
+   {
+      if (stmt)
+      {
+         sqlite3_finalize(stmt);
+      }
+   });
+
+   if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK)
+   {
+      SetDBError(
+         XO("Unable to prepare project file command:\n\n%s").Format(sql)
+      );
+      return false;
+   }
+
+   // The dictionary only grows, so it covers the names in all fragments
+   const wxMemoryBuffer &dict = layout.GetDict();
+   const wxMemoryBuffer &data = layout.GetData();
+   if (sqlite3_bind_blob(stmt, 1, dict.GetData(), dict.GetDataLen(), SQLITE_STATIC) ||
+       sqlite3_bind_blob(stmt, 2, data.GetData(), data.GetDataLen(), SQLITE_STATIC) ||
+       sqlite3_bind_blob(stmt, 3, refsBuffer.GetData(), refsBuffer.GetDataLen(), SQLITE_STATIC))
+   {
+      SetDBError(
+         XO("Unable to bind to blob")
+      );
+      return false;
+   }
+
+   if (sqlite3_step(stmt) != SQLITE_DONE)
+   {
+      SetDBError(
+         XO("Failed to update the project file.\nThe following command failed:\n\n%s").Format(sql)
+      );
+      return false;
+   }
+
+   trans.Commit();
+
+   // The caller may have its own savepoint open, which may yet roll back
+   // what was written; there is nothing more to write, but be told if so
+   conn.WriteInSavepoints( [](bool){},
+      [wCache = std::weak_ptr<AutoSaveCache>(pNew)](bool rolledBack)
+      {
+         auto pCache = wCache.lock();
+         if (rolledBack && pCache)
+         {
+            pCache->rolledBack = true;
+         }
+      });
+
+   mpAutoSaveCache = std::move(pNew);
+
+   return true;
+}
+
+bool ProjectFileIO::WriteAutoSaveFragment(
+   long long id, const ProjectSerializer &fragment)
+{
+   auto stmt = GetConnection().Prepare(DBConnection::InsertAutoSaveFragment,
+      "INSERT INTO autosavefragments(id, doc) VALUES(?1, ?2);");
+
+   auto cleanup = finally([&]
+   {
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+   });
+
+   const wxMemoryBuffer &data = fragment.GetData();
+   if (sqlite3_bind_int64(stmt, 1, id) ||
+       sqlite3_bind_blob(stmt, 2, data.GetData(), data.GetDataLen(), SQLITE_STATIC))
+   {
+      SetDBError(
+         XO("Unable to bind to blob")
+      );
+      return false;
+   }
+
+   if (sqlite3_step(stmt) != SQLITE_DONE)
+   {
+      SetDBError(
+         XO("Failed to update the project file.")
+      );
+      return false;
+   }
+
+   return true;
+}
+
+bool ProjectFileIO::GetAutoSaveFragments(wxMemoryBuffer &buffer)
+{
+   auto db = DB();
+
+   buffer.Clear();
+
+   if (!HasAutoSaveFragments(db))
+   {
+      return true;
+   }
+
+   sqlite3_stmt *layoutStmt = nullptr;
+   sqlite3_stmt *fragmentStmt = nullptr;
+   auto cleanup = finally([&]
+   {
+      if (layoutStmt)
+      {
+         sqlite3_finalize(layoutStmt);
+      }
+      if (fragmentStmt)
+      {
+         sqlite3_finalize(fragmentStmt);
+      }
+   });
+
+   if (sqlite3_prepare_v2(db,
+          "SELECT dict, doc, refs FROM autosavelayout WHERE id = 1;",
+          -1, &layoutStmt, nullptr) != SQLITE_OK ||
+       sqlite3_prepare_v2(db,
+          "SELECT doc FROM autosavefragments WHERE id = ?1;",
+          -1, &fragmentStmt, nullptr) != SQLITE_OK)
+   {
+      SetDBError(
+         XO("Failed to retrieve data from the project file.")
+      );
+      return false;
+   }
+
+   int rc = sqlite3_step(layoutStmt);
+
+   // A row wasn't found...not an error
+   if (rc == SQLITE_DONE)
+   {
+      return true;
+   }
+
+   if (rc != SQLITE_ROW)
+   {
+      SetDBError(
+         XO("Failed to retrieve data from the project file.")
+      );
+      return false;
+   }
+
+   buffer.AppendData(sqlite3_column_blob(layoutStmt, 0),
+      sqlite3_column_bytes(layoutStmt, 0));
+
+   auto doc = static_cast<const char *>(sqlite3_column_blob(layoutStmt, 1));
+   size_t docLen = sqlite3_column_bytes(layoutStmt, 1);
+   auto refs =
+      static_cast<const unsigned char *>(sqlite3_column_blob(layoutStmt, 2));
+   size_t nRefs = sqlite3_column_bytes(layoutStmt, 2) / 16;
+
+   // Splice each fragment into the layout document
+   size_t pos = 0;
+   for (size_t ii = 0; ii < nRefs; ++ii)
+   {
+      size_t next = ReadLittleEndian(refs + 16 * ii);
+      long long id = ReadLittleEndian(refs + 16 * ii + 8);
+      if (next < pos || next > docLen)
+      {
+         SetError(XO("Unable to decode project document"));
+         return false;
+      }
+      buffer.AppendData(doc + pos, next - pos);
+      pos = next;
+
+      sqlite3_bind_int64(fragmentStmt, 1, id);
+      if (sqlite3_step(fragmentStmt) != SQLITE_ROW)
+      {
+         SetDBError(
+            XO("Failed to retrieve data from the project file.")
+         );
+         return false;
+      }
+      buffer.AppendData(sqlite3_column_blob(fragmentStmt, 0),
+         sqlite3_column_bytes(fragmentStmt, 0));
+      sqlite3_reset(fragmentStmt);
+   }
+   buffer.AppendData(doc + pos, docLen - pos);
+
+   return true;
+}
+
+bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
+{
+   bool success = false;
+
+   auto cleanup = finally([&]
    {
       if (!success)
       {
@@ -1814,7 +2833,6 @@ bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
       return false;
    }
 
-   wxString project;
    wxMemoryBuffer buffer;
    bool usedAutosave = true;
 
@@ -1826,6 +2844,14 @@ bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
       return false;
    }
  
+   // Else reassemble the autosave doc from fragments, if any
+   if (!ignoreAutosave && buffer.GetDataLen() == 0 &&
+       !GetAutoSaveFragments(buffer))
+   {
+      // Error already set
+      return false;
+   }
+
    // If we didn't have an autosave doc, load the project doc instead
    if (buffer.GetDataLen() == 0)
    {
@@ -1847,23 +2873,15 @@ bool ProjectFileIO::LoadProject(const FilePath &fileName, bool ignoreAutosave)
    }
    else
    {
-      project = ProjectSerializer::Decode(buffer);
-      if (project.empty())
-      {
-         SetError(XO("Unable to decode project document"));
-
-         return false;
-      }
-
-      XMLFileReader xmlFile;
-
-      // Load 'er up
-      success = xmlFile.ParseString(this, project);
+      // Load 'er up, straight from the binary document, without making
+      // XML text to parse
+      TranslatableString error;
+      success = ProjectSerializer::Decode(buffer, this, &error);
       if (!success)
       {
          SetError(
             XO("Unable to parse project information."),
-            xmlFile.GetErrorStr()
+            error
          );
          return false;
       }
@@ -2150,10 +3168,10 @@ bool ProjectFileIO::SaveProject(
    return true;
 }
 
-bool ProjectFileIO::SaveCopy(const FilePath& fileName)
+bool ProjectFileIO::SaveCopy(const FilePath& fileName, const TrackList *pTracks)
 {
    return CopyTo(fileName, XO("Backing up project"), false, true,
-      {&TrackList::Get(mProject)});
+      {pTracks ? pTracks : &TrackList::Get(mProject)});
 }
 
 bool ProjectFileIO::OpenProject()
@@ -2357,255 +3375,61 @@ int64_t ProjectFileIO::GetTotalUsage()
 }
 
 //
-// Returns the amount of disk space used by the specified sample blockid or all
-// of the sample blocks if the blockid is 0.  It does this by using the raw SQLite
-// pages available from the "sqlite_dbpage" virtual table to traverse the SQLite
-// table b-tree described here:  https://www.sqlite.org/fileformat.html
+// Returns the bytes of samples and summaries stored for the specified sample
+// blockid, or for all of the sample blocks if the blockid is 0.  The total
+// is kept up to date in the sampleblockusage table by triggers, so no scan of
+// the sampleblocks table is needed.
 //
 int64_t ProjectFileIO::GetDiskUsage(DBConnection &conn, SampleBlockID blockid /* = 0 */)
 {
-   // Information we need to track our travels through the b-tree
-   typedef struct
-   {
-      int64_t pgno;
-      int currentCell;
-      int numCells;
-      unsigned char data[65536];
-   } page;
-   std::vector<page> stack;
+   sqlite3_stmt *stmt = blockid
+      ? conn.Prepare(DBConnection::GetBlockUsage,
+         "SELECT " SAMPLE_BLOCK_BYTES("sampleblocks")
+         "  FROM sampleblocks WHERE blockid = ?1;")
+      : conn.Prepare(DBConnection::GetTotalUsage,
+         "SELECT ifnull(sum(bytes), 0) FROM sampleblockusage;");
 
-   int64_t total = 0;
-   int64_t found = 0;
-   int64_t right = 0;
-   int rc;
+   auto cleanup = finally([&]
+   {
+      // Clear statement bindings and rewind statement
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+   });
 
-   // Get the rootpage for the sampleblocks table.
-   sqlite3_stmt *stmt =
-      conn.Prepare(DBConnection::GetRootPage,
-                    "SELECT rootpage FROM sqlite_master WHERE tbl_name = 'sampleblocks';");
-   if (stmt == nullptr || sqlite3_step(stmt) != SQLITE_ROW)
+   if (blockid && sqlite3_bind_int64(stmt, 1, blockid))
    {
       return 0;
    }
 
-   // And store it in our first stack frame
-   stack.push_back({sqlite3_column_int64(stmt, 0)});
-
-   // All done with the statement
-   sqlite3_clear_bindings(stmt);
-   sqlite3_reset(stmt);
-
-   // Prepare/retrieve statement to read raw database page
-   stmt = conn.Prepare(DBConnection::GetDBPage,
-      "SELECT data FROM sqlite_dbpage WHERE pgno = ?1;");
-   if (stmt == nullptr)
+   if (sqlite3_step(stmt) != SQLITE_ROW)
    {
+      // Likely harmless failure - says size is zero on this error.
       return 0;
    }
 
-   // Traverse the b-tree until we've visited all of the leaf pages or until
-   // we find the one corresponding to the passed in sample blockid. Because we
-   // use an integer primary key for the sampleblocks table, the traversal will
-   // be in ascending blockid sequence.
-   do
-   {
-      // Acces the top stack frame
-      page &pg = stack.back();
-
-      // Read the page from the sqlite_dbpage table if it hasn't yet been loaded
-      if (pg.numCells == 0)
-      {
-         // Bind the page number
-         sqlite3_bind_int64(stmt, 1, pg.pgno);
-
-         // And retrieve the page
-         if (sqlite3_step(stmt) != SQLITE_ROW)
-         {
-            // REVIEW: Likely harmless failure - says size is zero on
-            // this error.
-            // LLL: Yea, but not much else we can do.
-            return 0;
-         }
-
-         // Copy the page content to the stack frame
-         memcpy(&pg.data,
-                sqlite3_column_blob(stmt, 0),
-                sqlite3_column_bytes(stmt, 0));
-
-         // And retrieve the total number of cells within it
-         pg.numCells = get2(&pg.data[3]);
-
-         // Reset statement for next usage
-         sqlite3_clear_bindings(stmt);
-         sqlite3_reset(stmt);
-      }
-
-      //wxLogDebug("%*.*spgno %lld currentCell %d numCells %d", (stack.size() - 1) * 2, (stack.size() - 1) * 2, "", pg.pgno, pg.currentCell, pg.numCells);
-
-      // Process an interior table b-tree page
-      if (pg.data[0] == 0x05)
-      {
-         // Process the next cell if we haven't examined all of them yet
-         if (pg.currentCell < pg.numCells)
-         {
-            // Remember the right-most leaf page number.
-            right = get4(&pg.data[8]);
-
-            // Iterate over the cells.
-            //
-            // If we're not looking for a specific blockid, then we always push the
-            // target page onto the stack and leave the loop after a single iteration.
-            //
-            // Otherwise, we match the blockid against the highest integer key contained
-            // within the cell and if the blockid falls within the cell, we stack the
-            // page and stop the iteration.
-            //
-            // In theory, we could do a binary search for a specific blockid here, but
-            // because our sample blocks are always large, we will get very few cells
-            // per page...usually 6 or less.
-            //
-            // In both cases, the stacked page can be either an internal or leaf page.
-            bool stacked = false;
-            while (pg.currentCell < pg.numCells)
-            {
-               // Get the offset to this cell using the offset in the cell pointer
-               // array.
-               //
-               // The cell pointer array starts immediately after the page header
-               // at offset 12 and the retrieved offset is from the beginning of
-               // the page.
-               int celloff = get2(&pg.data[12 + (pg.currentCell * 2)]);
-
-               // Bump to the next cell for the next iteration.
-               pg.currentCell++;
-
-               // Get the page number this cell describes
-               int pagenum = get4(&pg.data[celloff]);
-
-               // And the highest integer key, which starts at offset 4 within the cell.
-               int64_t intkey = 0;
-               get_varint(&pg.data[celloff + 4], &intkey);
-
-               //wxLogDebug("%*.*sinternal - right %lld celloff %d pagenum %d intkey %lld", (stack.size() - 1) * 2, (stack.size() - 1) * 2, " ", right, celloff, pagenum, intkey);
-
-               // Stack the described page if we're not looking for a specific blockid
-               // or if this page contains the given blockid.
-               if (!blockid || blockid <= intkey)
-               {
-                  stack.push_back({pagenum, 0, 0});
-                  stacked = true;
-                  break;
-               }
-            }
-
-            // If we pushed a new page onto the stack, we need to jump back up
-            // to read the page
-            if (stacked)
-            {
-               continue;
-            }
-         }
-
-         // We've exhausted all the cells with this page, so we stack the right-most
-         // leaf page.  Ensure we only process it once.
-         if (right)
-         {
-            stack.push_back({right, 0, 0});
-            right = 0;
-            continue;
-         }
-      }
-      // Process a leaf table b-tree page
-      else if (pg.data[0] == 0x0d)
-      {
-         // Iterate over the cells
-         //
-         // If we're not looking for a specific blockid, then just accumulate the
-         // payload sizes. We will be reading every leaf page in the sampleblocks
-         // table.
-         //
-         // Otherwise we break out when we find the matching blockid. In this case,
-         // we only ever look at 1 leaf page.
-         bool stop = false;
-         for (int i = 0; i < pg.numCells; i++)
-         {
-            // Get the offset to this cell using the offset in the cell pointer
-            // array.
-            //
-            // The cell pointer array starts immediately after the page header
-            // at offset 8 and the retrieved offset is from the beginning of
-            // the page.
-            int celloff = get2(&pg.data[8 + (i * 2)]);
-
-            // Get the total payload size in bytes of the described row.
-            int64_t payload = 0;
-            int digits = get_varint(&pg.data[celloff], &payload);
-
-            // Get the integer key for this row.
-            int64_t intkey = 0;
-            get_varint(&pg.data[celloff + digits], &intkey);
-
-            //wxLogDebug("%*.*sleaf - celloff %4d intkey %lld payload %lld", (stack.size() - 1) * 2, (stack.size() - 1) * 2, " ", celloff, intkey, payload);
-
-            // Add this payload size to the total if we're not looking for a specific
-            // blockid
-            if (!blockid)
-            {
-               total += payload;
-            }
-            // Otherwise, return the payload size for a matching row
-            else if (blockid == intkey)
-            {
-               return payload;
-            }
-         }
-      }
-
-      // Done with the current branch, so pop back up to the previous one (if any)
-      stack.pop_back();
-   } while (!stack.empty());
-
-   // Return the total used for all sample blocks
-   return total;
+   return sqlite3_column_int64(stmt, 0);
 }
 
-// Retrieves a 2-byte big-endian integer from the page data
-unsigned int ProjectFileIO::get2(const unsigned char *ptr)
+int64_t ProjectFileIO::GetBlockCount()
 {
-   return (ptr[0] << 8) | ptr[1];
-}
+   auto pConn = CurrConn().get();
+   if (!pConn)
+      return 0;
 
-// Retrieves a 4-byte big-endian integer from the page data
-unsigned int ProjectFileIO::get4(const unsigned char *ptr)
-{
-   return ((unsigned int) ptr[0] << 24) |
-          ((unsigned int) ptr[1] << 16) |
-          ((unsigned int) ptr[2] << 8)  |
-          ((unsigned int) ptr[3]);
-}
+   sqlite3_stmt *stmt = pConn->Prepare(DBConnection::GetBlockCount,
+      "SELECT ifnull(sum(blocks), 0) FROM sampleblockusage;");
 
-// Retrieves a variable length integer from the page data. Returns the
-// number of digits used to encode the integer and the stores the
-// value at the given location.
-int ProjectFileIO::get_varint(const unsigned char *ptr, int64_t *out)
-{
-   int64_t val = 0;
-   int i;
+   auto cleanup = finally([&]
+   {
+      sqlite3_reset(stmt);
+   });
 
-   for (i = 0; i < 8; ++i)
+   if (sqlite3_step(stmt) != SQLITE_ROW)
    {
-      val = (val << 7) + (ptr[i] & 0x7f);
-      if ((ptr[i] & 0x80) == 0)
-      {
-         *out = val;
-         return i + 1;
-      }
+      return 0;
    }
 
-   val = (val << 8) + (ptr[i] & 0xff);
-   *out = val;
-
-   return 9;
+   return sqlite3_column_int64(stmt, 0);
 }
 
 InvisibleTemporaryProject::InvisibleTemporaryProject()
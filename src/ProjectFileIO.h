@@ -11,6 +11,7 @@ Paul Licameli split from AudacityProject.h
 #ifndef __AUDACITY_PROJECT_FILE_IO__
 #define __AUDACITY_PROJECT_FILE_IO__
 
+#include <functional>
 #include <memory>
 #include <unordered_set>
 
@@ -28,6 +29,7 @@ class DBConnection;
 struct DBConnectionErrors;
 class ProjectSerializer;
 class SqliteSampleBlock;
+class Track;
 class TrackList;
 class WaveTrack;
 
@@ -95,7 +97,9 @@ public:
    bool LoadProject(const FilePath &fileName, bool ignoreAutosave);
    bool UpdateSaved(const TrackList *tracks = nullptr);
    bool SaveProject(const FilePath &fileName, const TrackList *lastSaved);
-   bool SaveCopy(const FilePath& fileName);
+   //! Copy the project to a file, keeping only the blocks used by the
+   //! given tracks, or else the project's tracks
+   bool SaveCopy(const FilePath& fileName, const TrackList *pTracks = nullptr);
 
    wxLongLong GetFreeDiskSpace() const;
 
@@ -110,10 +114,13 @@ public:
    // they are attached to the active tracks or held by the Undo manager.
    int64_t GetTotalUsage();
 
-   // Return the bytes used for the given block using the connection to a
-   // specific database. This is the workhorse for the above 3 methods.
+   // Return the bytes used for the given block, or all blocks if 0, using the
+   // connection to a specific database.
    static int64_t GetDiskUsage(DBConnection &conn, SampleBlockID blockid);
 
+   // Return the number of sample blocks in the project file
+   int64_t GetBlockCount();
+
    // Displays an error dialog with a button that offers help
    void ShowError(wxWindow *parent,
                   const TranslatableString &dlogTitle,
@@ -202,9 +209,14 @@ public:
 private:
    void OnCheckpointFailure();
 
+   using TrackWriter =
+      std::function< void(XMLWriter &xmlFile, const Track &track) >;
+
    void WriteXMLHeader(XMLWriter &xmlFile) const;
+   // writeTrack, if given, writes each track, or something in its place
    void WriteXML(XMLWriter &xmlFile, bool recording = false,
-      const TrackList *tracks = nullptr) /* not override */;
+      const TrackList *tracks = nullptr,
+      const TrackWriter &writeTrack = {}) /* not override */;
 
    // XMLTagHandler callback methods
    bool HandleXMLTag(const wxChar *tag, const wxChar **attrs) override;
@@ -242,11 +254,26 @@ private:
 
    bool CheckVersion();
    bool InstallSchema(sqlite3 *db, const char *schema = "main");
+   //! Add the codec column to sampleblocks, and mark the file version
+   bool InstallCodecSchema(sqlite3 *db, const char *schema = "main");
+   //! Add the table of block usage totals and the triggers that maintain
+   //! it, if missing
+   bool InstallBlockUsageSchema(sqlite3 *db, const char *schema = "main");
+   //! Add the table of block content hashes and the trigger that maintains
+   //! it, if missing
+   bool InstallBlockHashSchema(sqlite3 *db, const char *schema = "main");
    bool UpgradeSchema();
 
    // Write project or autosave XML (binary) documents
    bool WriteDoc(const char *table, const ProjectSerializer &autosave, const char *schema = "main");
 
+   //! Write the autosave document as a layout with separate fragments for
+   //! wave clips and other tracks, rewriting only the fragments that changed
+   bool AutoSaveFragments(bool recording);
+   bool WriteAutoSaveFragment(long long id, const ProjectSerializer &fragment);
+   //! Reassemble the document that AutoSaveFragments() wrote, if any
+   bool GetAutoSaveFragments(wxMemoryBuffer &buffer);
+
    // Application defined function to verify blockid exists is in set of blockids
    static void InSet(sqlite3_context *context, int argc, sqlite3_value **argv);
 
@@ -273,11 +300,6 @@ private:
 
    bool ShouldCompact(const std::vector<const TrackList *> &tracks);
 
-   // Gets values from SQLite B-tree structures
-   static unsigned int get2(const unsigned char *ptr);
-   static unsigned int get4(const unsigned char *ptr);
-   static int get_varint(const unsigned char *ptr, int64_t *out);
-
 private:
    Connection &CurrConn();
 
@@ -307,6 +329,11 @@ private:
    Connection mPrevConn;
    FilePath mPrevFileName;
    bool mPrevTemporary;
+
+   // What the rows of the autosave fragment tables hold, so that
+   // AutoSaveFragments() can skip what did not change
+   struct AutoSaveCache;
+   std::shared_ptr<AutoSaveCache> mpAutoSaveCache;
 };
 
 class wxTopLevelWindow;
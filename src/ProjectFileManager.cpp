@@ -45,6 +45,7 @@ Paul Licameli split from AudacityProject.cpp
 #include "widgets/AudacityMessageBox.h"
 #include "widgets/ErrorDialog.h"
 #include "widgets/FileHistory.h"
+#include "widgets/ProgressDialog.h"
 #include "widgets/Warning.h"
 #include "xml/XMLFileReader.h"
 
@@ -1181,7 +1182,9 @@ bool ImportProject(AudacityProject &dest, const FilePath &fileName)
 // If pNewTrackList is passed in non-NULL, it gets filled with the pointers to NEW tracks.
 bool ProjectFileManager::Import(
    const FilePath &fileName,
-   bool addToHistory /* = true */)
+   bool addToHistory /* = true */,
+   ImportPlugin *pOpenedBy /* = nullptr */,
+   std::shared_ptr<ImportFileHandle> pOpened /* = {} */)
 {
    auto &project = mProject;
    auto &projectFileIO = ProjectFileIO::Get(project);
@@ -1249,7 +1252,9 @@ bool ProjectFileManager::Import(
                                             &WaveTrackFactory::Get( project ),
                                             newTracks,
                                             newTags.get(),
-                                            errorMessage);
+                                            errorMessage,
+                                            pOpenedBy,
+                                            std::move(pOpened));
       if (!errorMessage.empty()) {
          // Error message derived from Importer::Import
          // Additional help via a Help button links to the manual.
@@ -1302,6 +1307,45 @@ bool ProjectFileManager::Import(
    return true;
 }
 
+// Import several files, decoding at once those that allow it; tracks are
+// added in the order of the names, as if each file were imported in turn
+void ProjectFileManager::ImportFiles(
+   const FilePaths &fileNames,
+   bool addToHistory /* = true */)
+{
+   auto &project = mProject;
+   std::vector<Importer::ConcurrentResult> results;
+   const auto result = Importer::Get().ImportConcurrently(project, fileNames,
+      &WaveTrackFactory::Get( project ), results);
+   if (result == ProgressResult::Cancelled)
+      return;
+
+   for (size_t ii = 0; ii < fileNames.size(); ++ii) {
+      const auto &fileName = fileNames[ii];
+      auto &fileResult = results[ii];
+      if (!fileResult.imported) {
+         // The file failed in the batch, or the user stopped the batch
+         // before this file was done
+         if (fileResult.failed || result == ProgressResult::Stopped)
+            continue;
+         Import(fileName, addToHistory,
+            fileResult.pOpenedBy, std::move(fileResult.pOpened));
+         continue;
+      }
+
+      auto newTags = Tags::Get( project ).Duplicate();
+      newTags->Merge( *fileResult.pTags );
+      Tags::Set( project, newTags );
+
+      if (addToHistory) {
+         FileHistory::Global().Append(fileName);
+      }
+
+      // PRL: Undo history is incremented inside this:
+      AddImportedTracks(fileName, std::move(fileResult.tracks));
+   }
+}
+
 #include "Clipboard.h"
 #include "ShuttleGui.h"
 #include "widgets/HelpSystem.h"
@@ -20,6 +20,8 @@ Paul Licameli split from AudacityProject.h
 class wxString;
 class wxFileName;
 class AudacityProject;
+class ImportFileHandle;
+class ImportPlugin;
 class Track;
 class TrackList;
 class WaveTrack;
@@ -93,7 +95,14 @@ public:
 
    void OpenFile(const FilePath &fileName, bool addtohistory = true);
 
+   //! pOpened, if not null, is the file as already opened by pOpenedBy
    bool Import(const FilePath &fileName,
+               bool addToHistory = true,
+               ImportPlugin *pOpenedBy = nullptr,
+               std::shared_ptr<ImportFileHandle> pOpened = {});
+
+   //! Import several files, decoding them concurrently where possible
+   void ImportFiles(const FilePaths &fileNames,
                bool addToHistory = true);
 
    void Compact();
@@ -328,14 +328,24 @@ public:
             ProjectWindow::Get( *mProject ).HandleResize(); // Adjust scrollers for NEW track sizes.
          } );
 
+         // Decode runs of audio files concurrently where possible, but keep
+         // the order of all tracks
+         FilePaths audioNames;
+         const auto importAudio = [&]{
+            ProjectFileManager::Get( *mProject ).ImportFiles(audioNames);
+            audioNames.clear();
+         };
          for (const auto &name : sortednames) {
 #ifdef USE_MIDI
-            if (FileNames::IsMidi(name))
+            if (FileNames::IsMidi(name)) {
+               importAudio();
                DoImportMIDI( *mProject, name );
+            }
             else
 #endif
-               ProjectFileManager::Get( *mProject ).Import(name);
+               audioNames.push_back(name);
          }
+         importAudio();
 
          auto &window = ProjectWindow::Get( *mProject );
          window.ZoomAfterImport(nullptr);
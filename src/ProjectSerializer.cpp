@@ -19,8 +19,11 @@
 #include <algorithm>
 #include <cstdint>
 #include <mutex>
+#include <vector>
 #include <wx/ustring.h>
 
+#include "Internat.h"
+
 ///
 /// ProjectSerializer class
 ///
@@ -382,12 +385,211 @@ bool ProjectSerializer::DictChanged() const
    return mDictChanged;
 }
 
-// See ProjectFileIO::LoadProject() for explanation of the blockids arg
 wxString ProjectSerializer::Decode(const wxMemoryBuffer &buffer)
 {
-   wxMemoryInputStream in(buffer.GetData(), buffer.GetDataLen());
-
    XMLStringWriter out;
+   if (!DecodeTo(buffer, out))
+   {
+      return {};
+   }
+
+   return out;
+}
+
+namespace {
+
+// Passes the decoded document to tag handlers, as XMLFileReader does with
+// the events from the parser, but without making and parsing the text
+class HandlerDispatcher final : public XMLWriter
+{
+public:
+   explicit HandlerDispatcher(XMLTagHandler *baseHandler)
+      : mBaseHandler{ baseHandler }
+   {
+      mHandlers.reserve(128);
+   }
+
+   void StartTag(const wxString &name) override
+   {
+      FlushTag();
+      mTag = name;
+      mInTag = true;
+   }
+
+   void EndTag(const wxString &name) override
+   {
+      FlushTag();
+      if (mHandlers.empty())
+      {
+         mError = true;
+         return;
+      }
+      if (XMLTagHandler *const handler = mHandlers.back())
+         handler->HandleXMLEndTag(name.wx_str());
+      mHandlers.pop_back();
+   }
+
+   void WriteAttr(const wxString &name, const wxString &value) override
+   {
+      mAttrs.emplace_back(name, value);
+   }
+
+   void WriteAttr(const wxString &name, const wxChar *value) override
+   {
+      WriteAttr(name, wxString(value));
+   }
+
+   // Format numbers as XMLWriter does, so that handlers see the same
+   // strings as from a parsed document
+
+   void WriteAttr(const wxString &name, int value) override
+   {
+      WriteAttr(name, wxString::Format(wxT("%d"), value));
+   }
+
+   void WriteAttr(const wxString &name, bool value) override
+   {
+      WriteAttr(name, wxString::Format(wxT("%d"), value));
+   }
+
+   void WriteAttr(const wxString &name, long value) override
+   {
+      WriteAttr(name, wxString::Format(wxT("%ld"), value));
+   }
+
+   void WriteAttr(const wxString &name, long long value) override
+   {
+      WriteAttr(name, wxString::Format(wxT("%lld"), value));
+   }
+
+   void WriteAttr(const wxString &name, size_t value) override
+   {
+      WriteAttr(name, wxString::Format(wxT("%lld"), (long long) value));
+   }
+
+   void WriteAttr(const wxString &name, float value, int digits) override
+   {
+      WriteAttr(name, Internat::ToString(value, digits));
+   }
+
+   void WriteAttr(const wxString &name, double value, int digits) override
+   {
+      WriteAttr(name, Internat::ToString(value, digits));
+   }
+
+   void WriteData(const wxString &value) override
+   {
+      FlushTag();
+      if (!mHandlers.empty())
+         if (XMLTagHandler *const handler = mHandlers.back())
+            handler->HandleXMLContent(value);
+   }
+
+   void Write(const wxString &) override
+   {
+      // Only the XML declaration and the DOCTYPE are written raw, before
+      // the root element, and there is nothing to do for them.  Raw text in
+      // an element can't be passed on without parsing it.
+      if (mInTag || !mHandlers.empty())
+         mError = true;
+   }
+
+   bool Finish()
+   {
+      FlushTag();
+      return !mError && mHandlers.empty() && mStarted && mBaseHandler;
+   }
+
+   //! Why Finish() failed
+   TranslatableString GetError() const
+   {
+      if (mError || !mHandlers.empty() || !mStarted)
+         return XO("Project document is malformed");
+      // The same as XMLFileReader reports when the handler rejects the root
+      return XO("Could not parse XML");
+   }
+
+private:
+   // Call the handler for the pending tag, now that all its attributes are
+   // known
+   void FlushTag()
+   {
+      if (!mInTag)
+         return;
+      mInTag = false;
+
+      if (mHandlers.empty())
+      {
+         if (mStarted)
+         {
+            // Junk after the root element
+            mError = true;
+            return;
+         }
+         mStarted = true;
+         mHandlers.push_back(mBaseHandler);
+      }
+      else if (XMLTagHandler *const handler = mHandlers.back())
+         mHandlers.push_back(handler->HandleXMLChild(mTag.wx_str()));
+      else
+         mHandlers.push_back(nullptr);
+
+      if (XMLTagHandler *&handler = mHandlers.back())
+      {
+         mAttrPointers.clear();
+         for (const auto &attr : mAttrs)
+         {
+            mAttrPointers.push_back(attr.first.wx_str());
+            mAttrPointers.push_back(attr.second.wx_str());
+         }
+         mAttrPointers.push_back(nullptr);
+
+         if (!handler->HandleXMLTag(mTag.wx_str(), mAttrPointers.data()))
+         {
+            handler = nullptr;
+            if (mHandlers.size() == 1)
+               mBaseHandler = nullptr;
+         }
+      }
+
+      mAttrs.clear();
+   }
+
+   XMLTagHandler *mBaseHandler;
+   std::vector<XMLTagHandler *> mHandlers;
+
+   wxString mTag;
+   std::vector< std::pair<wxString, wxString> > mAttrs;
+   std::vector<const wxChar *> mAttrPointers;
+
+   bool mStarted{ false };
+   bool mError{ false };
+};
+
+}
+
+bool ProjectSerializer::Decode(const wxMemoryBuffer &buffer,
+   XMLTagHandler *baseHandler, TranslatableString *pError)
+{
+   HandlerDispatcher out{ baseHandler };
+   if (!DecodeTo(buffer, out))
+   {
+      if (pError)
+         *pError = XO("Project document is corrupt");
+      return false;
+   }
+   if (!out.Finish())
+   {
+      if (pError)
+         *pError = out.GetError();
+      return false;
+   }
+   return true;
+}
+
+bool ProjectSerializer::DecodeTo(const wxMemoryBuffer &buffer, XMLWriter &out)
+{
+   wxMemoryInputStream in(buffer.GetData(), buffer.GetDataLen());
 
    std::vector<char> bytes;
    IdMap mIds;
@@ -592,8 +794,8 @@ wxString ProjectSerializer::Decode(const wxMemoryBuffer &buffer)
    {
       // Document was corrupt, or platform differences in size or endianness
       // were not well canonicalized
-      return {};
+      return false;
    }
 
-   return out;
+   return true;
 }
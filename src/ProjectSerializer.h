@@ -68,7 +68,16 @@ public:
    // Returns empty string if decoding fails
    static wxString Decode(const wxMemoryBuffer &buffer);
 
+   //! Pass the document directly to the handlers, as XMLFileReader would
+   //! after parsing the result of the other Decode()
+   /*! @return false if decoding fails, or baseHandler rejects the document,
+    and then sets *pError, if not null, to say which */
+   static bool Decode(const wxMemoryBuffer &buffer, XMLTagHandler *baseHandler,
+      TranslatableString *pError = nullptr);
+
 private:
+   static bool DecodeTo(const wxMemoryBuffer &buffer, XMLWriter &out);
+
    void WriteName(const wxString & name);
 
 private:
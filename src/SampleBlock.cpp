@@ -68,6 +68,37 @@ SampleBlockPtr SampleBlockFactory::CreateFromXML(
    return result;
 }
 
+bool SampleBlockFactory::GetSamples(const BlockReads &reads,
+   sampleFormat destformat, bool mayThrow)
+{
+   try {
+      return DoGetSamples(reads, destformat) == reads.size();
+   }
+   catch( ... ) {
+      if( mayThrow )
+         throw;
+   }
+
+   // Retry the reads singly, so that one bad block does not lose the others
+   bool result = true;
+   for (const auto &read : reads)
+      if (read.pBlock->GetSamples(read.dest, destformat,
+         read.sampleoffset, read.numsamples, false) != read.numsamples)
+         result = false;
+   return result;
+}
+
+size_t SampleBlockFactory::DoGetSamples(const BlockReads &reads,
+   sampleFormat destformat)
+{
+   size_t result = 0;
+   for (const auto &read : reads)
+      if (read.pBlock->GetSamples(read.dest, destformat,
+         read.sampleoffset, read.numsamples) == read.numsamples)
+         ++result;
+   return result;
+}
+
 SampleBlock::~SampleBlock() = default;
 
 size_t SampleBlock::GetSamples(samplePtr dest,
@@ -14,6 +14,7 @@ SampleBlock.h
 #include <functional>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 class AudacityProject;
 class ProjectFileIO;
@@ -131,6 +132,25 @@ public:
       sampleFormat srcformat,
       const wxChar **attrs);
 
+   //! One part of a request to read samples from several blocks at once
+   struct BlockRead
+   {
+      SampleBlock *pBlock;
+      samplePtr dest;
+      size_t sampleoffset;
+      size_t numsamples;
+   };
+   using BlockReads = std::vector<BlockRead>;
+
+   //! Fetch samples for a run of blocks, all made by this factory
+   /*! The implementation may need far fewer accesses to storage than reading
+    the blocks one at a time.
+    If !mayThrow and there is an error, ignores it, fills the destinations of
+    the reads that could not complete with zeroes, and returns false.
+    @return true if all reads completed */
+   bool GetSamples(const BlockReads &reads,
+      sampleFormat destformat, bool mayThrow = true);
+
    using SampleBlockIDs = std::unordered_set<SampleBlockID>;
    /*! @return ids of all sample blocks created by this factory and still extant */
    virtual SampleBlockIDs GetActiveBlockIDs() = 0;
@@ -160,6 +180,11 @@ protected:
    virtual SampleBlockPtr DoCreateFromXML(
       sampleFormat srcformat,
       const wxChar **attrs) = 0;
+
+   //! Default implementation calls SampleBlock::GetSamples once for each read
+   /*! @return how many reads completed */
+   virtual size_t DoGetSamples(const BlockReads &reads,
+      sampleFormat destformat);
 };
 
 #endif
@@ -0,0 +1,102 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleBlockCache.cpp
+
+**********************************************************************/
+
+#include "SampleBlockCache.h"
+
+SampleBlockCache &SampleBlockCache::Get()
+{
+   static SampleBlockCache cache;
+   return cache;
+}
+
+// The factory sets the budget from preferences
+SampleBlockCache::SampleBlockCache()
+   : mBudget{ DefaultBudgetMegabytes * 1024 * 1024 }
+{
+}
+
+SampleBlockCache::~SampleBlockCache()
+{
+}
+
+void SampleBlockCache::SetBudget(size_t bytes)
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   mBudget = bytes;
+   Evict();
+}
+
+auto SampleBlockCache::Find(const void *owner, SampleBlockID id)
+   -> ContentsPtr
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   auto iter = mIndex.find({ owner, id });
+   if (iter == mIndex.end()) {
+      ++mMisses;
+      return nullptr;
+   }
+   ++mHits;
+   // Move to the front without reallocating
+   mEntries.splice(mEntries.begin(), mEntries, iter->second);
+   return iter->second->pContents;
+}
+
+void SampleBlockCache::Insert(
+   const void *owner, SampleBlockID id, ContentsPtr pContents)
+{
+   if (!pContents)
+      return;
+   const auto bytes = pContents->count * SAMPLE_SIZE(pContents->format);
+
+   std::lock_guard<std::mutex> lock{ mMutex };
+   if (bytes > mBudget)
+      return;
+
+   // Another thread may have read the same block at the same time
+   const Key key{ owner, id };
+   if (mIndex.find(key) != mIndex.end())
+      return;
+
+   mEntries.push_front({ key, std::move(pContents), bytes });
+   mIndex.emplace(key, mEntries.begin());
+   mBytes += bytes;
+   Evict();
+}
+
+void SampleBlockCache::Erase(const void *owner, SampleBlockID id)
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   auto iter = mIndex.find({ owner, id });
+   if (iter == mIndex.end())
+      return;
+   mBytes -= iter->second->bytes;
+   mEntries.erase(iter->second);
+   mIndex.erase(iter);
+}
+
+void SampleBlockCache::Evict()
+{
+   while (mBytes > mBudget && !mEntries.empty()) {
+      auto &entry = mEntries.back();
+      mBytes -= entry.bytes;
+      mIndex.erase(entry.key);
+      mEntries.pop_back();
+   }
+}
+
+auto SampleBlockCache::GetStatistics() const -> Statistics
+{
+   std::lock_guard<std::mutex> lock{ mMutex };
+   return { mHits, mMisses, mEntries.size(), mBytes };
+}
+
+void SampleBlockCache::ResetStatistics()
+{
+   mHits = 0;
+   mMisses = 0;
+}
@@ -0,0 +1,111 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleBlockCache.h
+
+*******************************************************************//**
+
+\class SampleBlockCache
+\brief A process-wide cache of the decoded samples of whole sample blocks,
+bounded in size, that discards the least recently used first
+
+Blocks are identified by their factory (any pointer that is unique while
+the blocks exist) and their SampleBlockID.  Contents are immutable and
+shared, so that a reader may keep using what it found after another thread
+evicts it.  All member functions may be called from any thread.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_SAMPLE_BLOCK_CACHE__
+#define __AUDACITY_SAMPLE_BLOCK_CACHE__
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "SampleBlock.h"
+#include "SampleFormat.h"
+
+class AUDACITY_DLL_API SampleBlockCache final
+{
+public:
+   //! Decoded samples of one block
+   struct Contents
+   {
+      Contents(size_t count_, sampleFormat format_)
+         : format{ format_ }, count{ count_ }, samples{ count_, format_ }
+      {}
+
+      const sampleFormat format;
+      const size_t count;
+      SampleBuffer samples;
+   };
+   using ContentsPtr = std::shared_ptr<const Contents>;
+
+   struct Statistics
+   {
+      unsigned long long hits;
+      unsigned long long misses;
+      size_t entries;
+      size_t bytes;
+   };
+
+   //! Budget until the preference is read, and the default of the preference
+   static constexpr size_t DefaultBudgetMegabytes = 128;
+
+   static SampleBlockCache &Get();
+
+   SampleBlockCache();
+   SampleBlockCache(const SampleBlockCache&) = delete;
+   SampleBlockCache &operator=(const SampleBlockCache&) = delete;
+   ~SampleBlockCache();
+
+   //! Change the bound on bytes of samples, discarding as needed
+   /*! A bound of zero disables the cache */
+   void SetBudget(size_t bytes);
+   size_t GetBudget() const { return mBudget; }
+   bool IsEnabled() const { return mBudget > 0; }
+
+   //! Find contents and make them the most recently used; counts a hit or a
+   //! miss
+   /*! @return null if absent */
+   ContentsPtr Find(const void *owner, SampleBlockID id);
+
+   //! Add contents as the most recently used, unless they alone exceed the
+   //! budget; contents already present for the block are kept instead
+   void Insert(const void *owner, SampleBlockID id, ContentsPtr pContents);
+
+   //! Forget a block, which must be done before its id can be reused
+   void Erase(const void *owner, SampleBlockID id);
+
+   Statistics GetStatistics() const;
+   void ResetStatistics();
+
+private:
+   using Key = std::pair<const void *, SampleBlockID>;
+   struct Entry
+   {
+      Key key;
+      ContentsPtr pContents;
+      size_t bytes;
+   };
+   using Entries = std::list<Entry>;
+
+   //! @pre mMutex is locked
+   void Evict();
+
+   mutable std::mutex mMutex;
+   // Most recently used first
+   Entries mEntries;
+   std::map<Key, Entries::iterator> mIndex;
+   size_t mBytes{ 0 };
+
+   std::atomic<size_t> mBudget;
+   std::atomic<unsigned long long> mHits{ 0 };
+   std::atomic<unsigned long long> mMisses{ 0 };
+};
+
+#endif
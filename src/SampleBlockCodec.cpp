@@ -0,0 +1,379 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleBlockCodec.cpp
+
+**********************************************************************/
+
+#include "SampleBlockCodec.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace SampleBlockCoding {
+
+namespace {
+
+// Layout of an encoding:
+//    byte 0      Mode, below
+//    byte 1      Shift: low bits that are zero in all values, not coded
+//    bytes 2-3   zero
+//    bytes 4-7   sample count, little-endian
+//    then, for each partition of PartitionSize samples (the last may be
+//    shorter):  2 bits of predictor order, 6 bits of Rice parameter, and a
+//    Rice code for each residual.
+// Bits are packed starting from the most significant bit of each byte.
+// The predictor's history carries across partitions, starting from zeroes.
+enum Mode : unsigned char {
+   IntegerMode = 1, // int16 or int24 samples
+   ScaledMode = 2,  // float samples that are all exact int24 values / 2^23
+   BitsMode = 3,    // other float samples, by monotonic bit patterns
+};
+
+constexpr size_t PartitionSize = 1024;
+
+// Quotients this large are followed by the value in full
+constexpr unsigned EscapeLength = 32;
+
+constexpr float Scale24 = 1 << 23;
+
+class BitWriter
+{
+public:
+   explicit BitWriter(std::vector<unsigned char> &dest) : mDest{ dest } {}
+
+   // Write the low n bits of value, n <= 32
+   void Write(uint32_t value, unsigned n)
+   {
+      mAccum = (mAccum << n) | (n < 32 ? value & ((1u << n) - 1) : value);
+      mCount += n;
+      while (mCount >= 8) {
+         mCount -= 8;
+         mDest.push_back((unsigned char)(mAccum >> mCount));
+      }
+   }
+
+   void WriteOnes(unsigned n)
+   {
+      for (; n >= 16; n -= 16)
+         Write(0xFFFF, 16);
+      Write((1u << n) - 1, n);
+   }
+
+   void Flush()
+   {
+      if (mCount)
+         mDest.push_back((unsigned char)(mAccum << (8 - mCount)));
+      mCount = 0;
+   }
+
+private:
+   std::vector<unsigned char> &mDest;
+   uint64_t mAccum = 0;
+   unsigned mCount = 0;
+};
+
+class BitReader
+{
+public:
+   BitReader(const unsigned char *begin, const unsigned char *end)
+      : mPtr{ begin }, mEnd{ end } {}
+
+   // Read n bits, n <= 32; false if the data run out
+   bool Read(unsigned n, uint32_t &value)
+   {
+      while (mCount < n) {
+         if (mPtr == mEnd)
+            return false;
+         mAccum = (mAccum << 8) | *mPtr++;
+         mCount += 8;
+      }
+      mCount -= n;
+      value = (uint32_t)(mAccum >> mCount) &
+         (n < 32 ? (1u << n) - 1 : 0xFFFFFFFFu);
+      return true;
+   }
+
+   // Count ones up to a zero (consumed) or up to limit (not followed by zero)
+   bool ReadUnary(unsigned limit, unsigned &count)
+   {
+      count = 0;
+      uint32_t bit;
+      while (count < limit) {
+         if (!Read(1, bit))
+            return false;
+         if (!bit)
+            return true;
+         ++count;
+      }
+      return true;
+   }
+
+private:
+   const unsigned char *mPtr, *mEnd;
+   uint64_t mAccum = 0;
+   unsigned mCount = 0;
+};
+
+inline uint64_t ZigZag(int64_t r)
+{
+   return ((uint64_t)r << 1) ^ (uint64_t)(r >> 63);
+}
+
+inline int64_t UnZigZag(uint64_t u)
+{
+   return (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+}
+
+// Fixed polynomial predictors of orders 0 to 3, from the last three values
+inline int64_t Predict(unsigned order, int64_t x1, int64_t x2, int64_t x3)
+{
+   switch (order) {
+   case 0: return 0;
+   case 1: return x1;
+   case 2: return 2 * x1 - x2;
+   default: return 3 * x1 - 3 * x2 + x3;
+   }
+}
+
+// Make float bit patterns increase with the value; this is its own inverse
+inline int32_t OrderBits(int32_t bits)
+{
+   return bits ^ ((bits >> 31) & 0x7FFFFFFF);
+}
+
+void EncodeValues(const std::vector<int64_t> &values, BitWriter &writer)
+{
+   int64_t x1 = 0, x2 = 0, x3 = 0;
+   const auto size = values.size();
+   for (size_t start = 0; start < size; start += PartitionSize) {
+      const auto end = std::min(size, start + PartitionSize);
+
+      // Choose the order with the least total magnitude of residuals
+      uint64_t sums[4] = {};
+      {
+         auto y1 = x1, y2 = x2, y3 = x3;
+         for (auto ii = start; ii < end; ++ii) {
+            const auto x = values[ii];
+            for (unsigned order = 0; order < 4; ++order)
+               sums[order] += ZigZag(x - Predict(order, y1, y2, y3));
+            y3 = y2, y2 = y1, y1 = x;
+         }
+      }
+      unsigned order = 0;
+      for (unsigned ii = 1; ii < 4; ++ii)
+         if (sums[ii] < sums[order])
+            order = ii;
+
+      // Rice parameter near the log of the mean
+      const uint64_t mean = sums[order] / (end - start);
+      unsigned k = 0;
+      while (k < 63 && (mean >> (k + 1)) > 0)
+         ++k;
+
+      writer.Write(order, 2);
+      writer.Write(k, 6);
+      for (auto ii = start; ii < end; ++ii) {
+         const auto x = values[ii];
+         const auto u = ZigZag(x - Predict(order, x1, x2, x3));
+         x3 = x2, x2 = x1, x1 = x;
+
+         const auto q = u >> k;
+         if (q < EscapeLength) {
+            writer.WriteOnes((unsigned)q);
+            writer.Write(0, 1);
+            if (k > 32) {
+               writer.Write((uint32_t)(u >> 32), k - 32);
+               writer.Write((uint32_t)u, 32);
+            }
+            else
+               writer.Write((uint32_t)u, k);
+         }
+         else {
+            writer.WriteOnes(EscapeLength);
+            writer.Write((uint32_t)(u >> 32), 32);
+            writer.Write((uint32_t)u, 32);
+         }
+      }
+   }
+   writer.Flush();
+}
+
+bool DecodeValues(BitReader &reader, size_t count, std::vector<int64_t> &values)
+{
+   values.resize(count);
+   int64_t x1 = 0, x2 = 0, x3 = 0;
+   for (size_t start = 0; start < count; start += PartitionSize) {
+      const auto end = std::min(count, start + PartitionSize);
+      uint32_t order, k;
+      if (!reader.Read(2, order) || !reader.Read(6, k))
+         return false;
+      for (auto ii = start; ii < end; ++ii) {
+         unsigned q;
+         if (!reader.ReadUnary(EscapeLength, q))
+            return false;
+         uint32_t hi = 0, lo = 0;
+         uint64_t u;
+         if (q < EscapeLength) {
+            if (k > 32) {
+               if (!reader.Read(k - 32, hi) || !reader.Read(32, lo))
+                  return false;
+            }
+            else if (!reader.Read(k, lo))
+               return false;
+            u = ((uint64_t)q << k) | ((uint64_t)hi << 32) | lo;
+         }
+         else {
+            if (!reader.Read(32, hi) || !reader.Read(32, lo))
+               return false;
+            u = ((uint64_t)hi << 32) | lo;
+         }
+         const auto x = UnZigZag(u) + Predict(order, x1, x2, x3);
+         values[ii] = x;
+         x3 = x2, x2 = x1, x1 = x;
+      }
+   }
+   return true;
+}
+
+}
+
+bool Encode(constSamplePtr src, size_t numsamples, sampleFormat format,
+   std::vector<unsigned char> &dest)
+{
+   if (numsamples == 0 || numsamples > UINT32_MAX)
+      return false;
+
+   std::vector<int64_t> values(numsamples);
+   Mode mode = IntegerMode;
+   switch (format) {
+   case int16Sample: {
+      auto samples = reinterpret_cast<const short*>(src);
+      std::copy(samples, samples + numsamples, values.begin());
+      break;
+   }
+   case int24Sample: {
+      auto samples = reinterpret_cast<const int*>(src);
+      std::copy(samples, samples + numsamples, values.begin());
+      break;
+   }
+   case floatSample:
+   default: {
+      auto samples = reinterpret_cast<const float*>(src);
+      mode = ScaledMode;
+      for (size_t ii = 0; ii < numsamples; ++ii) {
+         const float scaled = samples[ii] * Scale24;
+         // Negative zero, NaN and fractions don't survive the round trip
+         if (!(scaled == std::floor(scaled)) ||
+             scaled < -Scale24 || scaled >= Scale24 ||
+             (scaled == 0 && std::signbit(scaled))) {
+            mode = BitsMode;
+            break;
+         }
+         values[ii] = (int64_t)scaled;
+      }
+      if (mode == BitsMode)
+         for (size_t ii = 0; ii < numsamples; ++ii) {
+            int32_t bits;
+            memcpy(&bits, &samples[ii], sizeof bits);
+            values[ii] = OrderBits(bits);
+         }
+      break;
+   }
+   }
+
+   // Converted 16 bit samples have eight such bits in each value
+   unsigned char shift = 0;
+   if (mode != BitsMode) {
+      uint64_t bits = 0;
+      for (auto value : values)
+         bits |= (uint64_t)value;
+      if (bits) {
+         while (!(bits & 1))
+            bits >>= 1, ++shift;
+         if (shift)
+            for (auto &value : values)
+               value /= (int64_t(1) << shift);
+      }
+   }
+
+   dest.clear();
+   dest.reserve(numsamples * SAMPLE_SIZE(format));
+   dest.push_back(mode);
+   dest.push_back(shift);
+   dest.insert(dest.end(), 2, 0);
+   for (unsigned shift = 0; shift < 32; shift += 8)
+      dest.push_back((unsigned char)(numsamples >> shift));
+
+   BitWriter writer{ dest };
+   EncodeValues(values, writer);
+
+   return dest.size() < numsamples * SAMPLE_SIZE(format);
+}
+
+size_t DecodedCount(const void *header, size_t headerbytes)
+{
+   auto bytes = static_cast<const unsigned char*>(header);
+   if (headerbytes < HeaderBytes ||
+       bytes[0] < IntegerMode || bytes[0] > BitsMode || bytes[1] > 31)
+      return 0;
+   size_t count = 0;
+   for (unsigned ii = 0; ii < 4; ++ii)
+      count |= size_t(bytes[4 + ii]) << (8 * ii);
+   return count;
+}
+
+bool Decode(const void *src, size_t srcbytes, sampleFormat format,
+   samplePtr dest)
+{
+   const auto count = DecodedCount(src, srcbytes);
+   if (count == 0)
+      return false;
+   auto bytes = static_cast<const unsigned char*>(src);
+   const auto mode = bytes[0];
+   const auto shift = bytes[1];
+   if ((mode == IntegerMode) != (format != floatSample))
+      return false;
+
+   BitReader reader{ bytes + HeaderBytes, bytes + srcbytes };
+   std::vector<int64_t> values;
+   if (!DecodeValues(reader, count, values))
+      return false;
+   if (shift)
+      for (auto &value : values)
+         value = (int64_t)((uint64_t)value << shift);
+
+   switch (format) {
+   case int16Sample: {
+      auto samples = reinterpret_cast<short*>(dest);
+      for (size_t ii = 0; ii < count; ++ii)
+         samples[ii] = (short)values[ii];
+      break;
+   }
+   case int24Sample: {
+      auto samples = reinterpret_cast<int*>(dest);
+      for (size_t ii = 0; ii < count; ++ii)
+         samples[ii] = (int)values[ii];
+      break;
+   }
+   case floatSample:
+   default: {
+      auto samples = reinterpret_cast<float*>(dest);
+      if (mode == ScaledMode)
+         for (size_t ii = 0; ii < count; ++ii)
+            samples[ii] = (float)values[ii] / Scale24;
+      else
+         for (size_t ii = 0; ii < count; ++ii) {
+            const int32_t bits = OrderBits((int32_t)values[ii]);
+            memcpy(&samples[ii], &bits, sizeof bits);
+         }
+      break;
+   }
+   }
+   return true;
+}
+
+}
@@ -0,0 +1,56 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleBlockCodec.h
+
+*******************************************************************//**
+
+\file SampleBlockCodec.h
+\brief Lossless compression of the contents of sample blocks
+
+Samples are predicted from the previous ones with the fixed polynomial
+predictors of FLAC, and the residuals are Rice coded.  Float samples that
+are all exact 24 bit values, as after import of 16 or 24 bit files, are
+coded as integers; other floats are coded by their bit patterns.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_SAMPLE_BLOCK_CODEC__
+#define __AUDACITY_SAMPLE_BLOCK_CODEC__
+
+#include <cstddef>
+#include <vector>
+
+#include "audacity/Types.h"
+
+//! Values stored in the codec column of the sampleblocks table
+enum class SampleBlockCodec : int {
+   None = 0,      //!< Raw little-endian samples
+   Lossless = 1,  //!< As described above
+};
+
+namespace SampleBlockCoding {
+
+//! Number of bytes at the start of an encoding that give the sample count
+constexpr size_t HeaderBytes = 8;
+
+//! Compress samples
+/*! @return false, leaving dest unspecified, if the result would be no
+    smaller than the raw samples */
+bool Encode(constSamplePtr src, size_t numsamples, sampleFormat format,
+   std::vector<unsigned char> &dest);
+
+//! @return the number of samples in an encoding, reading only its header,
+//! or zero if the header is not valid
+size_t DecodedCount(const void *header, size_t headerbytes);
+
+//! Decompress all of an encoding into dest, which must hold
+//! DecodedCount() samples of the format that was encoded
+/*! @return false if the encoding is corrupt */
+bool Decode(const void *src, size_t srcbytes, sampleFormat format,
+   samplePtr dest);
+
+}
+
+#endif
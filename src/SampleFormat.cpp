@@ -48,7 +48,8 @@
 
 static DitherType gLowQualityDither = DitherType::none;
 static DitherType gHighQualityDither = DitherType::none;
-static Dither gDitherAlgorithm;
+// One for each thread, so that threads may convert samples at once
+static thread_local Dither gDitherAlgorithm;
 
 void InitDitherers()
 {
@@ -41,6 +41,7 @@
 #include <wx/log.h>
 
 #include "SampleBlock.h"
+#include "ThreadPool.h"
 #include "InconsistencyException.h"
 #include "widgets/AudacityMessageBox.h"
 
@@ -73,6 +74,22 @@ Sequence::~Sequence()
 {
 }
 
+bool Sequence::HasSameContents(const Sequence &other) const
+{
+   if (mpFactory != other.mpFactory ||
+       mSampleFormat != other.mSampleFormat ||
+       mNumSamples != other.mNumSamples ||
+       mMinSamples != other.mMinSamples ||
+       mMaxSamples != other.mMaxSamples)
+      return false;
+
+   // Comparing pointers suffices, because blocks are immutable
+   return std::equal( mBlock.begin(), mBlock.end(),
+      other.mBlock.begin(), other.mBlock.end(),
+      []( const SeqBlock &a, const SeqBlock &b ){
+         return a.sb == b.sb && a.start == b.start; } );
+}
+
 size_t Sequence::GetMaxBlockSize() const
 {
    return mMaxSamples;
@@ -171,38 +188,49 @@ bool Sequence::ConvertToSampleFormat(sampleFormat format,
       (1 + mBlock.size() * ((float)oldMaxSamples / (float)mMaxSamples));
 
    {
-      size_t oldSize = oldMaxSamples;
-      SampleBuffer bufferOld(oldSize, oldFormat);
-      size_t newSize = oldMaxSamples;
-      SampleBuffer bufferNew(newSize, format);
-
-      for (size_t i = 0, nn = mBlock.size(); i < nn; i++)
+      // Read and convert a batch of blocks at once on all cores, then make
+      // the new blocks in order, in this thread
+      auto &pool = ThreadPool::Get();
+      const size_t batchSize = 2 * (pool.GetThreadCount() + 1);
+      ArrayOf<SampleBuffer> buffersOld{ batchSize }, buffersNew{ batchSize };
+      std::vector<size_t> oldSizes(batchSize, 0), newSizes(batchSize, 0);
+
+      for (size_t first = 0, nn = mBlock.size(); first < nn; first += batchSize)
       {
-         SeqBlock &oldSeqBlock = mBlock[i];
-         const auto &oldBlockFile = oldSeqBlock.sb;
-         const auto len = oldBlockFile->GetSampleCount();
-         ensureSampleBufferSize(bufferOld, oldFormat, oldSize, len);
-         Read(bufferOld.ptr(), oldFormat, oldSeqBlock, 0, len, true);
-
-         ensureSampleBufferSize(bufferNew, format, newSize, len);
-         CopySamples(bufferOld.ptr(), oldFormat, bufferNew.ptr(), format, len);
-
-         // Note this fix for http://bugzilla.audacityteam.org/show_bug.cgi?id=451,
-         // using Blockify, allows (len < mMinSamples).
-         // This will happen consistently when going from more bytes per sample to fewer...
-         // This will create a block that's smaller than mMinSamples, which
-         // shouldn't be allowed, but we agreed it's okay for now.
-         //vvv ANSWER-ME: Does this cause any bugs, or failures on write, elsewhere?
-         //    If so, need to special-case (len < mMinSamples) and start combining data
-         //    from the old blocks... Oh no!
-
-         // Using Blockify will handle the cases where len > the NEW mMaxSamples. Previous code did not.
-         const auto blockstart = oldSeqBlock.start;
-         Blockify(*mpFactory, mMaxSamples, mSampleFormat,
-                  newBlockArray, blockstart, bufferNew.ptr(), len);
-
-         if (progressReport)
-            progressReport(len);
+         const auto count = std::min(batchSize, nn - first);
+         pool.ParallelFor(count, [&](size_t ii) {
+            const SeqBlock &oldSeqBlock = mBlock[first + ii];
+            const auto len = oldSeqBlock.sb->GetSampleCount();
+            ensureSampleBufferSize(buffersOld[ii], oldFormat, oldSizes[ii], len);
+            Read(buffersOld[ii].ptr(), oldFormat, oldSeqBlock, 0, len, true);
+
+            ensureSampleBufferSize(buffersNew[ii], format, newSizes[ii], len);
+            CopySamples(buffersOld[ii].ptr(), oldFormat,
+               buffersNew[ii].ptr(), format, len);
+         } );
+
+         for (size_t ii = 0; ii < count; ++ii)
+         {
+            const SeqBlock &oldSeqBlock = mBlock[first + ii];
+            const auto len = oldSeqBlock.sb->GetSampleCount();
+
+            // Note this fix for http://bugzilla.audacityteam.org/show_bug.cgi?id=451,
+            // using Blockify, allows (len < mMinSamples).
+            // This will happen consistently when going from more bytes per sample to fewer...
+            // This will create a block that's smaller than mMinSamples, which
+            // shouldn't be allowed, but we agreed it's okay for now.
+            //vvv ANSWER-ME: Does this cause any bugs, or failures on write, elsewhere?
+            //    If so, need to special-case (len < mMinSamples) and start combining data
+            //    from the old blocks... Oh no!
+
+            // Using Blockify will handle the cases where len > the NEW mMaxSamples. Previous code did not.
+            const auto blockstart = oldSeqBlock.start;
+            Blockify(*mpFactory, mMaxSamples, mSampleFormat,
+                     newBlockArray, blockstart, buffersNew[ii].ptr(), len);
+
+            if (progressReport)
+               progressReport(len);
+         }
       }
    }
 
@@ -1088,7 +1116,9 @@ bool Sequence::Get(samplePtr buffer, sampleFormat format,
 bool Sequence::Get(int b, samplePtr buffer, sampleFormat format,
    sampleCount start, size_t len, bool mayThrow) const
 {
-   bool result = true;
+   // Gather the parts of all blocks in the range, so that the factory may
+   // fetch them together
+   SampleBlockFactory::BlockReads reads;
    while (len) {
       const SeqBlock &block = mBlock[b];
       // start is in block
@@ -1096,15 +1126,25 @@ bool Sequence::Get(int b, samplePtr buffer, sampleFormat format,
       // bstart is not more than block length
       const auto blen = std::min(len, block.sb->GetSampleCount() - bstart);
 
-      if (! Read(buffer, format, block, bstart, blen, mayThrow) )
-         result = false;
+      reads.push_back({ block.sb.get(), buffer, bstart, blen });
 
       len -= blen;
       buffer += (blen * SAMPLE_SIZE(format));
       b++;
       start += blen;
    }
-   return result;
+
+   if (reads.size() == 1) {
+      const auto &read = reads[0];
+      return Read(read.dest, format, mBlock[b - 1],
+         read.sampleoffset, read.numsamples, mayThrow);
+   }
+
+   if (! mpFactory->GetSamples(reads, format, mayThrow) ) {
+      wxLogWarning(wxT("Failed to read some of %ld blocks."), (long)reads.size());
+      return false;
+   }
+   return true;
 }
 
 // Pass NULL to set silence
@@ -69,6 +69,9 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    Sequence( const Sequence& ) = delete;
    Sequence& operator= (const Sequence&) PROHIBITED;
 
+   //! Whether the other would serve as a copy of this, sharing all blocks
+   bool HasSameContents(const Sequence &other) const;
+
    ~Sequence();
 
    //
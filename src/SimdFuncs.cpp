@@ -0,0 +1,355 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SimdFuncs.cpp
+
+**********************************************************************/
+
+#include "SimdFuncs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <float.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+   defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+   #define SIMD_FUNCS_SSE2
+   #include <emmintrin.h>
+#endif
+
+#if defined(SIMD_FUNCS_SSE2) && \
+   (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+   #define SIMD_FUNCS_AVX2
+   #include <immintrin.h>
+   #if defined(_MSC_VER)
+      #include <intrin.h>
+      // MSVC compiles AVX2 intrinsics without any special options
+      #define SIMD_FUNCS_TARGET_AVX2
+   #else
+      #define SIMD_FUNCS_TARGET_AVX2 __attribute__((target("avx2")))
+   #endif
+#endif
+
+namespace {
+
+// Scale factors that CopySamples uses to convert to float
+template< typename Sample > struct SampleScale;
+template<> struct SampleScale< short >
+   { static constexpr float value = 1.0f / (1 << 15); };
+template<> struct SampleScale< int >
+   { static constexpr float value = 1.0f / (1 << 23); };
+template<> struct SampleScale< float >
+   { static constexpr float value = 1.0f; };
+
+template< typename Sample >
+void MinMaxSumsqScalar(
+   constSamplePtr src, size_t len, float &min, float &max, float &sumsq)
+{
+   auto samples = reinterpret_cast< const Sample* >( src );
+   float lo = FLT_MAX, hi = -FLT_MAX, sum = 0;
+   for (size_t ii = 0; ii < len; ++ii) {
+      const float sample = samples[ii] * SampleScale< Sample >::value;
+      lo = std::min(lo, sample);
+      hi = std::max(hi, sample);
+      sum += sample * sample;
+   }
+   min = lo, max = hi, sumsq = sum;
+}
+
+void MixAddScalar(const float *src, const double *envelope,
+   float gain, float *dest, size_t stride, size_t len)
+{
+   if (envelope)
+      for (size_t ii = 0; ii < len; ++ii)
+         dest[ii * stride] += src[ii] * float(envelope[ii]) * gain;
+   else
+      for (size_t ii = 0; ii < len; ++ii)
+         dest[ii * stride] += src[ii] * gain;
+}
+
+#ifdef SIMD_FUNCS_SSE2
+
+inline void ReduceSSE2(__m128 lo, __m128 hi, __m128 sum,
+   float &min, float &max, float &sumsq)
+{
+   // Fold the four lanes onto the first one
+   lo = _mm_min_ps(lo, _mm_movehl_ps(lo, lo));
+   lo = _mm_min_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+   hi = _mm_max_ps(hi, _mm_movehl_ps(hi, hi));
+   hi = _mm_max_ss(hi, _mm_shuffle_ps(hi, hi, 1));
+   sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+   sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+   min = _mm_cvtss_f32(lo);
+   max = _mm_cvtss_f32(hi);
+   sumsq = _mm_cvtss_f32(sum);
+}
+
+// Load four samples at a time, converted to float
+template< typename Sample > struct LoadSSE2;
+template<> struct LoadSSE2< float > {
+   static __m128 Load(const float *p) { return _mm_loadu_ps(p); }
+};
+template<> struct LoadSSE2< int > {
+   static __m128 Load(const int *p) {
+      return _mm_mul_ps(
+         _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)p)),
+         _mm_set1_ps(SampleScale< int >::value));
+   }
+};
+template<> struct LoadSSE2< short > {
+   static __m128 Load(const short *p) {
+      // Sign-extend four shorts into the high halves of 32 bit lanes
+      const auto packed = _mm_loadl_epi64((const __m128i*)p);
+      const auto wide = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+      return _mm_mul_ps(_mm_cvtepi32_ps(wide),
+         _mm_set1_ps(SampleScale< short >::value));
+   }
+};
+
+template< typename Sample >
+void MinMaxSumsqSSE2(
+   constSamplePtr src, size_t len, float &min, float &max, float &sumsq)
+{
+   auto samples = reinterpret_cast< const Sample* >( src );
+   auto lo = _mm_set1_ps(FLT_MAX), hi = _mm_set1_ps(-FLT_MAX),
+      sum = _mm_setzero_ps();
+   size_t ii = 0;
+   for (; ii + 4 <= len; ii += 4) {
+      const auto x = LoadSSE2< Sample >::Load(samples + ii);
+      lo = _mm_min_ps(lo, x);
+      hi = _mm_max_ps(hi, x);
+      sum = _mm_add_ps(sum, _mm_mul_ps(x, x));
+   }
+   ReduceSSE2(lo, hi, sum, min, max, sumsq);
+
+   // Remainder
+   float tailMin, tailMax, tailSumsq;
+   MinMaxSumsqScalar< Sample >( (constSamplePtr)(samples + ii), len - ii,
+      tailMin, tailMax, tailSumsq );
+   min = std::min(min, tailMin);
+   max = std::max(max, tailMax);
+   sumsq += tailSumsq;
+}
+
+// Load four envelope values, converted to float
+inline __m128 LoadEnvelopeSSE2(const double *p)
+{
+   return _mm_movelh_ps(
+      _mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+}
+
+void MixAddSSE2(const float *src, const double *envelope,
+   float gain, float *dest, size_t stride, size_t len)
+{
+   const auto g = _mm_set1_ps(gain);
+   size_t ii = 0;
+   if (stride == 1) {
+      for (; ii + 4 <= len; ii += 4) {
+         auto y = _mm_mul_ps(_mm_loadu_ps(src + ii), g);
+         if (envelope)
+            y = _mm_mul_ps(y, LoadEnvelopeSSE2(envelope + ii));
+         _mm_storeu_ps(dest + ii, _mm_add_ps(_mm_loadu_ps(dest + ii), y));
+      }
+   }
+   else if (stride == 2) {
+      // Interleaved stereo:  add to every other value of eight, leaving the
+      // other channel unchanged.  Stop short by one, so that the eighth is
+      // never past the end of the buffer.
+      const auto zero = _mm_setzero_ps();
+      for (; ii + 5 <= len; ii += 4) {
+         auto y = _mm_mul_ps(_mm_loadu_ps(src + ii), g);
+         if (envelope)
+            y = _mm_mul_ps(y, LoadEnvelopeSSE2(envelope + ii));
+         const auto p = dest + 2 * ii;
+         _mm_storeu_ps(p,
+            _mm_add_ps(_mm_loadu_ps(p), _mm_unpacklo_ps(y, zero)));
+         _mm_storeu_ps(p + 4,
+            _mm_add_ps(_mm_loadu_ps(p + 4), _mm_unpackhi_ps(y, zero)));
+      }
+   }
+
+   // Remainder, or any other stride
+   MixAddScalar(src + ii, envelope ? envelope + ii : nullptr,
+      gain, dest + ii * stride, stride, len - ii);
+}
+
+#endif
+
+#ifdef SIMD_FUNCS_AVX2
+
+// Load eight samples at a time, converted to float
+template< typename Sample > struct LoadAVX2;
+template<> struct LoadAVX2< float > {
+   SIMD_FUNCS_TARGET_AVX2
+   static __m256 Load(const float *p) { return _mm256_loadu_ps(p); }
+};
+template<> struct LoadAVX2< int > {
+   SIMD_FUNCS_TARGET_AVX2
+   static __m256 Load(const int *p) {
+      return _mm256_mul_ps(
+         _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)p)),
+         _mm256_set1_ps(SampleScale< int >::value));
+   }
+};
+template<> struct LoadAVX2< short > {
+   SIMD_FUNCS_TARGET_AVX2
+   static __m256 Load(const short *p) {
+      return _mm256_mul_ps(
+         _mm256_cvtepi32_ps(
+            _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)p))),
+         _mm256_set1_ps(SampleScale< short >::value));
+   }
+};
+
+template< typename Sample >
+SIMD_FUNCS_TARGET_AVX2
+void MinMaxSumsqAVX2(
+   constSamplePtr src, size_t len, float &min, float &max, float &sumsq)
+{
+   auto samples = reinterpret_cast< const Sample* >( src );
+   auto lo = _mm256_set1_ps(FLT_MAX), hi = _mm256_set1_ps(-FLT_MAX),
+      sum = _mm256_setzero_ps();
+   size_t ii = 0;
+   for (; ii + 8 <= len; ii += 8) {
+      const auto x = LoadAVX2< Sample >::Load(samples + ii);
+      lo = _mm256_min_ps(lo, x);
+      hi = _mm256_max_ps(hi, x);
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(x, x));
+   }
+   ReduceSSE2(
+      _mm_min_ps(_mm256_castps256_ps128(lo), _mm256_extractf128_ps(lo, 1)),
+      _mm_max_ps(_mm256_castps256_ps128(hi), _mm256_extractf128_ps(hi, 1)),
+      _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1)),
+      min, max, sumsq);
+
+   // Remainder
+   float tailMin, tailMax, tailSumsq;
+   MinMaxSumsqScalar< Sample >( (constSamplePtr)(samples + ii), len - ii,
+      tailMin, tailMax, tailSumsq );
+   min = std::min(min, tailMin);
+   max = std::max(max, tailMax);
+   sumsq += tailSumsq;
+}
+
+SIMD_FUNCS_TARGET_AVX2
+void MixAddAVX2(const float *src, const double *envelope,
+   float gain, float *dest, size_t stride, size_t len)
+{
+   if (stride != 1) {
+      MixAddSSE2(src, envelope, gain, dest, stride, len);
+      return;
+   }
+
+   const auto g = _mm256_set1_ps(gain);
+   size_t ii = 0;
+   for (; ii + 8 <= len; ii += 8) {
+      auto y = _mm256_mul_ps(_mm256_loadu_ps(src + ii), g);
+      if (envelope)
+         y = _mm256_mul_ps(y, _mm256_insertf128_ps(
+            _mm256_castps128_ps256(
+               _mm256_cvtpd_ps(_mm256_loadu_pd(envelope + ii))),
+            _mm256_cvtpd_ps(_mm256_loadu_pd(envelope + ii + 4)), 1));
+      _mm256_storeu_ps(dest + ii, _mm256_add_ps(_mm256_loadu_ps(dest + ii), y));
+   }
+
+   // Remainder
+   MixAddScalar(src + ii, envelope ? envelope + ii : nullptr,
+      gain, dest + ii, 1, len - ii);
+}
+
+#endif
+
+SimdLevel DetectSimdLevel()
+{
+#if defined(SIMD_FUNCS_AVX2) && defined(_MSC_VER)
+   int info[4];
+   __cpuid(info, 0);
+   if (info[0] >= 7) {
+      __cpuid(info, 1);
+      // The OS must also save the AVX registers
+      const bool osxsave = (info[2] & (1 << 27)) != 0;
+      const bool avx = (info[2] & (1 << 28)) != 0;
+      if (osxsave && avx && (_xgetbv(0) & 6) == 6) {
+         __cpuidex(info, 7, 0);
+         if (info[1] & (1 << 5))
+            return SimdLevel::AVX2;
+      }
+   }
+   return SimdLevel::SSE2;
+#elif defined(SIMD_FUNCS_AVX2)
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2"))
+      return SimdLevel::AVX2;
+   return SimdLevel::SSE2;
+#elif defined(SIMD_FUNCS_SSE2)
+   return SimdLevel::SSE2;
+#else
+   return SimdLevel::None;
+#endif
+}
+
+std::atomic< SimdLevel > &CurrentSimdLevel()
+{
+   static std::atomic< SimdLevel > level{ DetectSimdLevel() };
+   return level;
+}
+
+template< typename Sample >
+MinMaxSumsqFunction ChooseMinMaxSumsq(SimdLevel level)
+{
+   switch (level) {
+#ifdef SIMD_FUNCS_AVX2
+   case SimdLevel::AVX2:
+      return MinMaxSumsqAVX2< Sample >;
+#endif
+#ifdef SIMD_FUNCS_SSE2
+   case SimdLevel::SSE2:
+      return MinMaxSumsqSSE2< Sample >;
+#endif
+   default:
+      return MinMaxSumsqScalar< Sample >;
+   }
+}
+
+}
+
+SimdLevel GetSimdLevel()
+{
+   return CurrentSimdLevel();
+}
+
+void SetSimdLevel(SimdLevel level)
+{
+   CurrentSimdLevel() = std::min(level, DetectSimdLevel());
+}
+
+MinMaxSumsqFunction GetMinMaxSumsqFunction(sampleFormat format)
+{
+   const auto level = GetSimdLevel();
+   switch (format) {
+   case int16Sample:
+      return ChooseMinMaxSumsq< short >(level);
+   case int24Sample:
+      return ChooseMinMaxSumsq< int >(level);
+   case floatSample:
+   default:
+      return ChooseMinMaxSumsq< float >(level);
+   }
+}
+
+MixAddFunction GetMixAddFunction()
+{
+   switch (GetSimdLevel()) {
+#ifdef SIMD_FUNCS_AVX2
+   case SimdLevel::AVX2:
+      return MixAddAVX2;
+#endif
+#ifdef SIMD_FUNCS_SSE2
+   case SimdLevel::SSE2:
+      return MixAddSSE2;
+#endif
+   default:
+      return MixAddScalar;
+   }
+}
@@ -0,0 +1,68 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SimdFuncs.h
+
+*******************************************************************//**
+
+\file SimdFuncs.h
+\brief Sample-crunching kernels with SSE2 and AVX2 variants, chosen at
+run time according to what the CPU supports
+
+Like the functions in SseMathFuncs.h, these process four (or eight)
+floats at a time; unlike those, each has a plain C++ fallback, so callers
+need not test for processor features.  They are not built on that file,
+which includes the x86 headers unconditionally, needs MMX unless USE_SSE2
+is defined, and offers only transcendental functions of floats, while
+these kernels must also build on other processors and need integer and
+AVX2 operations.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_SIMD_FUNCS__
+#define __AUDACITY_SIMD_FUNCS__
+
+#include <cstddef>
+
+#include "audacity/Types.h"
+
+//! Instruction set extensions that kernels may use
+enum class SimdLevel : int {
+   None,
+   SSE2,
+   AVX2,
+};
+
+//! Best instruction set available on this CPU, detected once
+SimdLevel GetSimdLevel();
+
+//! Override the detected level (for benchmarking); a level above what the
+//! CPU supports is lowered to that
+void SetSimdLevel(SimdLevel level);
+
+//! Computes the minimum, maximum, and sum of squares of len samples
+/*!
+ Integer samples are scaled to floats as CopySamples does, without first
+ copying them to a buffer.
+ If len is zero, min is FLT_MAX, max is -FLT_MAX, and sumsq is zero.
+ */
+using MinMaxSumsqFunction = void (*)(
+   constSamplePtr src, size_t len, float &min, float &max, float &sumsq);
+
+//! @return the fastest implementation for the format at the current level
+MinMaxSumsqFunction GetMinMaxSumsqFunction(sampleFormat format);
+
+//! Adds src[i] * envelope[i] * gain to dest[i * stride], for i < len
+/*!
+ This is the inner loop of mixing one track channel into one output
+ channel, with the envelope, the track gain, and the pan applied in the
+ same pass.  envelope may be null, meaning all ones.
+ */
+using MixAddFunction = void (*)(const float *src, const double *envelope,
+   float gain, float *dest, size_t stride, size_t len);
+
+//! @return the fastest implementation at the current level
+MixAddFunction GetMixAddFunction();
+
+#endif
@@ -11,9 +11,21 @@ Paul Licameli -- split from SampleBlock.cpp and SampleBlock.h
 #include <float.h>
 #include <sqlite3.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include "DBConnection.h"
+#include "Prefs.h"
 #include "ProjectFileIO.h"
+#include "SampleBlockCache.h"
+#include "SampleBlockCodec.h"
 #include "SampleFormat.h"
+#include "SimdFuncs.h"
+#include "prefs/QualityPrefs.h"
 #include "xml/XMLTagHandler.h"
 
 #include "SampleBlock.h" // to inherit
@@ -67,17 +79,56 @@ public:
 private:
    bool IsSilent() const { return mBlockID <= 0; }
    void Load(SampleBlockID sbid);
+   //! Set the fields that Load() sets, from the columns of a row that start
+   //! at the given one, as selected by LoadColumns
+   void LoadFromRow(sqlite3_stmt *stmt, int column, bool hasCodecs);
    bool GetSummary(float *dest,
                    size_t frameoffset,
                    size_t numframes,
                    DBConnection::StatementID id,
-                   const char *sql);
+                   const char *sql,
+                   const char *column,
+                   size_t columnbytes,
+                   const ArrayOf<char> &summary);
    size_t GetBlob(void *dest,
                   sampleFormat destformat,
                   sqlite3_stmt *stmt,
                   sampleFormat srcformat,
                   size_t srcoffset,
+                  size_t srcbytes,
+                  SampleBlockCodec codec = SampleBlockCodec::None);
+   //! Like GetBlob, but reads only the pages of the column that are needed
+   size_t GetBlobRange(void *dest,
+                  sampleFormat destformat,
+                  const char *column,
+                  sampleFormat srcformat,
+                  size_t srcoffset,
                   size_t srcbytes);
+   //! Whether to prefer GetBlobRange to GetBlob
+   static bool IsPartialRead(size_t srcbytes, size_t blobbytes)
+   {
+      return srcbytes < blobbytes / 2;
+   }
+   //! Copy from a fetched blob, zero-filling what lies beyond its end
+   /*! @return false if the blob is encoded and corrupt */
+   static bool CopyFromBlob(void *dest,
+                  sampleFormat destformat,
+                  constSamplePtr src,
+                  size_t blobbytes,
+                  sampleFormat srcformat,
+                  size_t srcoffset,
+                  size_t srcbytes,
+                  SampleBlockCodec codec);
+
+   //! Read and decode the samples of the whole block, and put them in the
+   //! cache
+   /*! @pre the cache is enabled */
+   SampleBlockCache::ContentsPtr ReadIntoCache();
+   //! Copy part of cached samples, zero-filling what lies beyond their end
+   /*! @return numsamples */
+   static size_t CopyFromCache(void *dest, sampleFormat destformat,
+      const SampleBlockCache::Contents &contents,
+      size_t sampleoffset, size_t numsamples);
 
    enum {
       fields = 3, /* min, max, rms */
@@ -86,6 +137,14 @@ private:
    Sizes SetSizes( size_t numsamples, sampleFormat srcformat );
    void CalcSummary(Sizes sizes);
 
+   //! Compute pending summaries into memory, if not done already
+   /*! @pre mSummaryMutex is locked */
+   void CalcPendingSummary();
+   //! Store pending summaries into the database row
+   /*! @param track whether to make them pending again if a savepoint that
+    was open rolls back */
+   void WriteSummary( bool track = true );
+
 private:
    //! This must never be called for silent blocks
    /*! @post return value is not null */
@@ -107,6 +166,11 @@ private:
    size_t mSampleBytes;
    size_t mSampleCount;
    sampleFormat mSampleFormat;
+   //! How the samples column is encoded; mSampleBytes is the decoded size
+   SampleBlockCodec mCodec{ SampleBlockCodec::None };
+   //! Bytes of the samples and summary columns as stored, which change when
+   //! pending summaries are written
+   std::atomic<size_t> mStoredBytes{ 0 };
 
    ArrayOf<char> mSummary256;
    ArrayOf<char> mSummary64k;
@@ -114,6 +178,13 @@ private:
    double mSumMax;
    double mSumRms;
 
+   //! The row was committed without summaries, which are computed later
+   std::atomic<bool> mSummaryPending{ false };
+   //! Pending summaries are in memory but not yet in the database
+   bool mSummaryCalculated{ false };
+   //! Guards the summary fields while they are pending
+   std::mutex mSummaryMutex;
+
 #if defined(WORDS_BIGENDIAN)
 #error All sample block data is little endian...big endian not yet supported
 #endif
@@ -149,14 +220,57 @@ public:
       sampleFormat srcformat,
       const wxChar **attrs) override;
 
+   size_t DoGetSamples(const BlockReads &reads,
+      sampleFormat destformat) override;
+
    BlockDeletionCallback SetBlockDeletionCallback(
       BlockDeletionCallback callback ) override;
 
 private:
    friend SqliteSampleBlock;
 
+   //! Schedule computation of summaries in the worker thread
+   void EnqueueSummary( SqliteSampleBlock *pBlock );
+   //! Cancel any scheduled computation, waiting if it is in progress, and
+   //! forget summaries written inside savepoints
+   void DequeueSummary( SqliteSampleBlock *pBlock );
+   void SummaryThread();
+   //! Summaries were written inside a savepoint, which has now ended; if it
+   //! rolled back, make them pending again
+   void SummarySavepointEnded( SqliteSampleBlock *pBlock, bool rolledBack );
+
+   //! Find a live block of this factory with exactly the given samples
+   /*! @return null if there is none */
+   std::shared_ptr<SqliteSampleBlock> FindDuplicate( unsigned long long hash,
+      constSamplePtr src, size_t numsamples, sampleFormat srcformat );
+   //! Record the content hash of a newly committed block
+   void StoreHash( SampleBlockID sbid, unsigned long long hash );
+
    const std::shared_ptr<ConnectionPtr> mppConnection;
 
+   // Whether new blocks are committed before their summaries are computed
+   const bool mDeferSummaries;
+
+   // How new blocks are encoded, if the project has the codec column
+   const SampleBlockCodec mCodec;
+
+   // Whether new blocks share the rows of live blocks with the same samples;
+   // off unless chosen, because each new block then costs a lookup of its
+   // hash, perhaps a comparison of samples, and another INSERT
+   const bool mDeduplicate;
+
+   // Worker thread and its queue of blocks awaiting summaries
+   // (Not owning pointers; blocks remove themselves at destruction)
+   std::thread mSummaryThread;
+   std::mutex mSummaryMutex;
+   std::condition_variable mSummaryCondition;
+   std::deque< SqliteSampleBlock* > mSummaryQueue;
+   SqliteSampleBlock *mSummarizing{ nullptr };
+   bool mSummaryStop{ false };
+   // Blocks whose summaries were written inside a savepoint not yet ended,
+   // with the bytes written
+   std::map< SqliteSampleBlock*, size_t > mSummariesInSavepoint;
+
    // Track all blocks that this factory has created, but don't control
    // their lifetimes (so use weak_ptr)
    // (Must also use weak pointers because the blocks have shared pointers
@@ -170,22 +284,253 @@ private:
 
 SqliteSampleBlockFactory::SqliteSampleBlockFactory( AudacityProject &project )
    : mppConnection{ ConnectionPtr::Get(project).shared_from_this() }
+   , mDeferSummaries{
+      gPrefs->ReadBool(wxT("/SampleBlocks/DeferSummaries"), false) }
+   , mCodec{ QualityPrefs::SampleBlockCodecChoice() }
+   , mDeduplicate{
+      gPrefs->ReadBool(wxT("/SampleBlocks/Deduplicate"), false) }
+{
+   // The cache is shared by all projects; zero disables it
+   SampleBlockCache::Get().SetBudget( 1024 * 1024 *
+      std::max(0L, gPrefs->Read(wxT("/SampleBlocks/CacheMegabytes"),
+         (long)SampleBlockCache::DefaultBudgetMegabytes)) );
+}
+
+SqliteSampleBlockFactory::~SqliteSampleBlockFactory()
+{
+   // All blocks are gone, because they hold this factory alive; so the
+   // queue is empty
+   {
+      std::lock_guard<std::mutex> guard(mSummaryMutex);
+      mSummaryStop = true;
+      mSummaryCondition.notify_all();
+   }
+
+   if (mSummaryThread.joinable())
+   {
+      mSummaryThread.join();
+   }
+
+   const auto stats = SampleBlockCache::Get().GetStatistics();
+   wxLogDebug(wxT("Sample block cache: %llu hits, %llu misses, %llu blocks, %llu bytes"),
+      stats.hits, stats.misses,
+      (unsigned long long) stats.entries, (unsigned long long) stats.bytes);
+}
+
+void SqliteSampleBlockFactory::EnqueueSummary( SqliteSampleBlock *pBlock )
+{
+   std::lock_guard<std::mutex> guard(mSummaryMutex);
+   if (!mSummaryThread.joinable())
+      mSummaryThread = std::thread( [this]{ SummaryThread(); } );
+   mSummaryQueue.push_back( pBlock );
+   mSummaryCondition.notify_all();
+}
+
+void SqliteSampleBlockFactory::DequeueSummary( SqliteSampleBlock *pBlock )
+{
+   std::unique_lock<std::mutex> lock(mSummaryMutex);
+   auto end = mSummaryQueue.end(),
+      iter = std::find( mSummaryQueue.begin(), end, pBlock );
+   if (iter != end)
+      mSummaryQueue.erase( iter );
+   mSummaryCondition.wait( lock, [&]{ return mSummarizing != pBlock; } );
+   mSummariesInSavepoint.erase( pBlock );
+}
+
+void SqliteSampleBlockFactory::SummarySavepointEnded(
+   SqliteSampleBlock *pBlock, bool rolledBack )
+{
+   // Don't lock the block, which the worker thread may hold while waiting
+   // for the savepoint; the fields changed here are atomic, and the block
+   // can't be destroyed while the factory's mutex is held
+   std::lock_guard<std::mutex> guard(mSummaryMutex);
+   auto iter = mSummariesInSavepoint.find( pBlock );
+   if (iter == mSummariesInSavepoint.end())
+      return;
+   const auto summaryBytes = iter->second;
+   mSummariesInSavepoint.erase( iter );
+   if (!rolledBack)
+      return;
+   // The UPDATE was undone, so compute and write the summaries again
+   pBlock->mStoredBytes -= summaryBytes;
+   pBlock->mSummaryPending = true;
+   mSummaryQueue.push_back( pBlock );
+   mSummaryCondition.notify_all();
+}
+
+void SqliteSampleBlockFactory::SummaryThread()
 {
-   
+   std::unique_lock<std::mutex> lock(mSummaryMutex);
+   while (true)
+   {
+      mSummaryCondition.wait( lock,
+         [this]{ return mSummaryStop || !mSummaryQueue.empty(); } );
+      if (mSummaryStop)
+         break;
+
+      auto pBlock = mSummarizing = mSummaryQueue.front();
+      mSummaryQueue.pop_front();
+      lock.unlock();
+
+      // On failure, leave the summaries pending; readers compute them as
+      // needed, and loading the project again will retry.  Don't bother the
+      // user with a message.
+      GuardedCall( [pBlock]{ pBlock->WriteSummary(); },
+         MakeSimpleGuard(), [](AudacityException*){} );
+
+      lock.lock();
+      mSummarizing = nullptr;
+      mSummaryCondition.notify_all();
+   }
 }
 
-SqliteSampleBlockFactory::~SqliteSampleBlockFactory() = default;
+// 64 bit MurmurHash of the samples, seeded with their format; it only
+// narrows the search for duplicates, which are then compared in full
+static unsigned long long HashSamples(
+   constSamplePtr src, size_t numbytes, sampleFormat format )
+{
+   const unsigned long long m = 0xc6a4a7935bd1e995ULL;
+   const int r = 47;
+   unsigned long long h = format ^ (numbytes * m);
+
+   const auto end = src + numbytes - numbytes % 8;
+   for (; src != end; src += 8) {
+      unsigned long long k;
+      memcpy(&k, src, 8);
+      k *= m;
+      k ^= k >> r;
+      k *= m;
+      h ^= k;
+      h *= m;
+   }
+
+   if (auto rest = numbytes % 8) {
+      unsigned long long k = 0;
+      memcpy(&k, src, rest);
+      h ^= k;
+      h *= m;
+   }
+
+   h ^= h >> r;
+   h *= m;
+   h ^= h >> r;
+   return h;
+}
 
 SampleBlockPtr SqliteSampleBlockFactory::DoCreate(
    constSamplePtr src, size_t numsamples, sampleFormat srcformat )
 {
+   unsigned long long hash = 0;
+   if (mDeduplicate) {
+      hash = HashSamples(src, numsamples * SAMPLE_SIZE(srcformat), srcformat);
+      // Share the block, and so its row; the row is deleted only when the
+      // last reference to the block goes away
+      if (auto sb = FindDuplicate(hash, src, numsamples, srcformat))
+         return sb;
+   }
+
    auto sb = std::make_shared<SqliteSampleBlock>(shared_from_this());
    sb->SetSamples(src, numsamples, srcformat);
    // block id has now been assigned
    mAllBlocks[ sb->GetBlockID() ] = sb;
+   if (mDeduplicate)
+      StoreHash(sb->GetBlockID(), hash);
    return sb;
 }
 
+std::shared_ptr<SqliteSampleBlock> SqliteSampleBlockFactory::FindDuplicate(
+   unsigned long long hash,
+   constSamplePtr src, size_t numsamples, sampleFormat srcformat )
+{
+   auto &pConnection = mppConnection->mpConnection;
+   if (!pConnection)
+      return nullptr;
+   auto db = pConnection->DB();
+
+   // Prepare and cache statement...automatically finalized at DB close
+   sqlite3_stmt *stmt = pConnection->Prepare(DBConnection::FindSampleBlockHash,
+      "SELECT blockid FROM sampleblockhashes WHERE hash = ?1;");
+
+   // Bind statement parameters
+   // Might return SQLITE_MISUSE which means it's our mistake that we violated
+   // preconditions; should return SQL_OK which is 0
+   if (sqlite3_bind_int64(stmt, 1, (sqlite3_int64) hash))
+   {
+      wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
+   }
+
+   // Usually none or one, but hashes may collide
+   std::vector<SampleBlockID> ids;
+   int rc;
+   while ((rc = sqlite3_step(stmt)) == SQLITE_ROW)
+      ids.push_back(sqlite3_column_int64(stmt, 0));
+
+   // Clear statement bindings and rewind statement
+   sqlite3_clear_bindings(stmt);
+   sqlite3_reset(stmt);
+
+   if (rc != SQLITE_DONE)
+   {
+      // Not fatal; the block is simply stored again
+      wxLogDebug(wxT("SqliteSampleBlockFactory::FindDuplicate - SQLITE error %s"), sqlite3_errmsg(db));
+      return nullptr;
+   }
+
+   SampleBuffer buffer;
+   for (auto id : ids) {
+      // A row with no live block may be an orphan, about to be deleted with
+      // the others, so only rows of live blocks are shared
+      auto iter = mAllBlocks.find(id);
+      if (iter == mAllBlocks.end())
+         continue;
+      auto sb = iter->second.lock();
+      if (!sb || sb->GetSampleFormat() != srcformat ||
+          sb->GetSampleCount() != numsamples)
+         continue;
+
+      if (!buffer.ptr())
+         buffer.Allocate(numsamples, srcformat);
+      // A failure to read is not fatal either
+      if (sb->GetSamples(buffer.ptr(), srcformat, 0, numsamples, false)
+             == numsamples &&
+          memcmp(buffer.ptr(), src, numsamples * SAMPLE_SIZE(srcformat)) == 0)
+         return sb;
+   }
+
+   return nullptr;
+}
+
+void SqliteSampleBlockFactory::StoreHash(
+   SampleBlockID sbid, unsigned long long hash )
+{
+   auto &pConnection = mppConnection->mpConnection;
+   if (!pConnection)
+      return;
+   auto db = pConnection->DB();
+
+   // Prepare and cache statement...automatically finalized at DB close
+   sqlite3_stmt *stmt = pConnection->Prepare(DBConnection::InsertSampleBlockHash,
+      "INSERT INTO sampleblockhashes (blockid, hash) VALUES(?1,?2);");
+
+   // Bind statement parameters
+   // Might return SQLITE_MISUSE which means it's our mistake that we violated
+   // preconditions; should return SQL_OK which is 0
+   if (sqlite3_bind_int64(stmt, 1, sbid) ||
+       sqlite3_bind_int64(stmt, 2, (sqlite3_int64) hash))
+   {
+      wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
+   }
+
+   // Execute the statement
+   // Not fatal if it fails; the block just can't be shared later
+   if (sqlite3_step(stmt) != SQLITE_DONE)
+      wxLogDebug(wxT("SqliteSampleBlockFactory::StoreHash - SQLITE error %s"), sqlite3_errmsg(db));
+
+   // Clear statement bindings and rewind statement
+   sqlite3_clear_bindings(stmt);
+   sqlite3_reset(stmt);
+}
+
 auto SqliteSampleBlockFactory::GetActiveBlockIDs() -> SampleBlockIDs
 {
    SampleBlockIDs result;
@@ -264,6 +609,9 @@ SampleBlockPtr SqliteSampleBlockFactory::DoCreateFromXML(
                // This may throw database errors
                // It initializes the rest of the fields
                ssb->Load((SampleBlockID) nValue);
+               // Finish the work of a session that deferred summaries
+               if (ssb->mSummaryPending)
+                  EnqueueSummary( ssb.get() );
             }
          }
          found++;
@@ -279,6 +627,159 @@ SampleBlockPtr SqliteSampleBlockFactory::DoCreateFromXML(
    return sb;
 }
 
+// Columns that SqliteSampleBlock::LoadFromRow() reads, in order; then those
+// for projects with sample block codecs
+static const char *const LoadColumns =
+   "sampleformat, summin, summax, sumrms,"
+   " length(samples), length(summary64k),"
+   " ifnull(length(summary256), 0) + ifnull(length(summary64k), 0)";
+static const char *const LoadCodecColumns = ", codec, samplecount";
+
+size_t SqliteSampleBlockFactory::DoGetSamples(
+   const BlockReads &reads, sampleFormat destformat )
+{
+   // Number of blocks fetched by one execution of the statement
+   enum { BatchSize = 32 };
+
+   size_t result = 0;
+
+   auto &cache = SampleBlockCache::Get();
+   const bool useCache = cache.IsEnabled();
+
+   // Silent blocks, and any blocks not from this factory, are read singly,
+   // and so are blocks already in the cache; gather the rest
+   using Pending = std::pair< SqliteSampleBlock*, const BlockRead* >;
+   std::vector< Pending > pending;
+   pending.reserve( reads.size() );
+   for (const auto &read : reads) {
+      auto pBlock = dynamic_cast< SqliteSampleBlock* >( read.pBlock );
+      if (!pBlock || pBlock->IsSilent() || pBlock->mpFactory.get() != this) {
+         if (read.pBlock->GetSamples(read.dest, destformat,
+            read.sampleoffset, read.numsamples) == read.numsamples)
+            ++result;
+      }
+      else if (auto pContents =
+         useCache ? cache.Find(this, pBlock->mBlockID) : nullptr) {
+         SqliteSampleBlock::CopyFromCache(read.dest, destformat, *pContents,
+            read.sampleoffset, read.numsamples);
+         ++result;
+      }
+      else
+         pending.emplace_back( pBlock, &read );
+   }
+
+   if (pending.empty())
+      return result;
+
+   if (pending.size() == 1) {
+      auto &read = *pending[0].second;
+      if (pending[0].first->DoGetSamples(read.dest, destformat,
+         read.sampleoffset, read.numsamples) == read.numsamples)
+         ++result;
+      return result;
+   }
+
+   // Blocks not yet loaded are loaded from the same rows as their samples
+   const auto makeSql = [](bool hasCodecs){
+      std::string sql{ "SELECT blockid, samples, " };
+      sql += LoadColumns;
+      if (hasCodecs)
+         sql += LoadCodecColumns;
+      sql += " FROM sampleblocks WHERE blockid IN (";
+      for (int ii = 1; ii <= BatchSize; ++ii)
+         sql += (ii > 1 ? ",?" : "?") + std::to_string(ii);
+      return sql + ");";
+   };
+   static const std::string sql = makeSql(false);
+   static const std::string sqlCodec = makeSql(true);
+
+   // All the blocks share one connection
+   auto pConn = pending[0].first->Conn();
+   auto db = pConn->DB();
+   const bool hasCodecs = pConn->HasSampleBlockCodecs();
+
+   for (auto first = pending.begin(), end = pending.end(); first != end;) {
+      auto last = first + std::min< ptrdiff_t >( BatchSize, end - first );
+
+      // Prepare and cache statement...automatically finalized at DB close
+      sqlite3_stmt *stmt = hasCodecs
+         ? pConn->Prepare(DBConnection::GetSamplesBatchCodec, sqlCodec.c_str())
+         : pConn->Prepare(DBConnection::GetSamplesBatch, sql.c_str());
+
+      // Bind statement parameters; unbound ones remain NULL and match nothing
+      // Might return SQLITE_MISUSE which means it's our mistake that we violated
+      // preconditions; should return SQL_OK which is 0
+      int param = 0;
+      for (auto it = first; it != last; ++it) {
+         if (sqlite3_bind_int64(stmt, ++param, it->first->mBlockID))
+         {
+            wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
+         }
+      }
+
+      // Rows come in no particular order, and a block may be read more than
+      // once in the same request
+      size_t found = 0;
+      bool corrupt = false;
+      int rc;
+      while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+         auto id = sqlite3_column_int64(stmt, 0);
+         auto src = (constSamplePtr) sqlite3_column_blob(stmt, 1);
+         size_t blobbytes = (size_t) sqlite3_column_bytes(stmt, 1);
+         std::shared_ptr<SampleBlockCache::Contents> pContents;
+         for (auto it = first; it != last; ++it) {
+            auto pBlock = it->first;
+            if (pBlock->mBlockID != id)
+               continue;
+            if (!pBlock->mValid)
+               pBlock->LoadFromRow(stmt, 2, hasCodecs);
+            auto &read = *it->second;
+            const auto format = pBlock->mSampleFormat;
+            const auto size = SAMPLE_SIZE(format);
+            if (useCache) {
+               // Decode the whole block once, for the cache
+               if (!pContents) {
+                  pContents = std::make_shared<SampleBlockCache::Contents>(
+                     pBlock->mSampleCount, format);
+                  if (SqliteSampleBlock::CopyFromBlob(
+                     pContents->samples.ptr(), format, src, blobbytes, format,
+                     0, pBlock->mSampleBytes, pBlock->mCodec))
+                     cache.Insert(this, id, pContents);
+                  else
+                     corrupt = true;
+               }
+               SqliteSampleBlock::CopyFromCache(read.dest, destformat,
+                  *pContents, read.sampleoffset, read.numsamples);
+            }
+            else if (!SqliteSampleBlock::CopyFromBlob(read.dest, destformat,
+               src, blobbytes, format,
+               read.sampleoffset * size, read.numsamples * size,
+               pBlock->mCodec))
+               corrupt = true;
+            ++found;
+         }
+      }
+
+      // Clear statement bindings and rewind statement
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+
+      if (rc != SQLITE_DONE || found != size_t(last - first) || corrupt)
+      {
+         wxLogDebug(wxT("SqliteSampleBlockFactory::DoGetSamples - SQLITE error %s"), sqlite3_errmsg(db));
+
+         // Just showing the user a simple message, not the library error too
+         // which isn't internationalized
+         pConn->ThrowException( false );
+      }
+
+      result += found;
+      first = last;
+   }
+
+   return result;
+}
+
 auto SqliteSampleBlockFactory::SetBlockDeletionCallback(
    BlockDeletionCallback callback ) -> BlockDeletionCallback
 {
@@ -318,6 +819,17 @@ SqliteSampleBlock::~SqliteSampleBlock()
       return;
    }
 
+   SampleBlockCache::Get().Erase( mpFactory.get(), mBlockID );
+
+   if (mSummaryPending)
+      // A row that outlives this object should be complete
+      GuardedCall( [this]{
+         if (mLocked && !Conn()->ShouldBypass())
+            WriteSummary( false );
+      } );
+   // Even if summaries are not pending now, a rollback could make them so
+   mpFactory->DequeueSummary( this );
+
    // See ProjectFileIO::Bypass() for a description of mIO.mBypass
    GuardedCall( [this]{
       if (!mLocked && !Conn()->ShouldBypass())
@@ -380,6 +892,36 @@ size_t SqliteSampleBlock::DoGetSamples(samplePtr dest,
       return numsamples;
    }
 
+   if (!mValid)
+   {
+      Load(mBlockID);
+   }
+
+   auto &cache = SampleBlockCache::Get();
+   const bool useCache = cache.IsEnabled();
+   if (useCache)
+      if (auto pContents = cache.Find(mpFactory.get(), mBlockID))
+         return CopyFromCache(dest, destformat, *pContents,
+            sampleoffset, numsamples);
+
+   // A small part of a block not in the cache is read alone, and not
+   // cached; encoded samples can only be decoded from the start
+   const auto size = SAMPLE_SIZE(mSampleFormat);
+   if (mCodec == SampleBlockCodec::None &&
+       IsPartialRead(numsamples * size, mSampleBytes))
+      return GetBlobRange(dest,
+                          destformat,
+                          "samples",
+                          mSampleFormat,
+                          sampleoffset * size,
+                          numsamples * size) / size;
+
+   // Otherwise decode the whole block once, so that the reads of
+   // neighboring parts that usually follow are served from memory
+   if (useCache)
+      return CopyFromCache(dest, destformat, *ReadIntoCache(),
+         sampleoffset, numsamples);
+
    // Prepare and cache statement...automatically finalized at DB close
    sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::GetSamples,
       "SELECT samples FROM sampleblocks WHERE blockid = ?1;");
@@ -388,8 +930,9 @@ size_t SqliteSampleBlock::DoGetSamples(samplePtr dest,
                   destformat,
                   stmt,
                   mSampleFormat,
-                  sampleoffset * SAMPLE_SIZE(mSampleFormat),
-                  numsamples * SAMPLE_SIZE(mSampleFormat)) / SAMPLE_SIZE(mSampleFormat);
+                  sampleoffset * size,
+                  numsamples * size,
+                  mCodec) / size;
 }
 
 void SqliteSampleBlock::SetSamples(constSamplePtr src,
@@ -400,6 +943,15 @@ void SqliteSampleBlock::SetSamples(constSamplePtr src,
    mSamples.reinit(mSampleBytes);
    memcpy(mSamples.get(), src, mSampleBytes);
 
+   if (mpFactory->mDeferSummaries) {
+      // Insert the row without summaries, keeping the samples in memory
+      // for the worker thread
+      mSummaryPending = true;
+      Commit( { 0, 0 } );
+      mpFactory->EnqueueSummary( this );
+      return;
+   }
+
    CalcSummary( sizes );
 
    Commit( sizes );
@@ -409,29 +961,64 @@ bool SqliteSampleBlock::GetSummary256(float *dest,
                                       size_t frameoffset,
                                       size_t numframes)
 {
+   const auto frames64k = (mSampleCount + 65535) / 65536;
    return GetSummary(dest, frameoffset, numframes, DBConnection::GetSummary256,
-      "SELECT summary256 FROM sampleblocks WHERE blockid = ?1;");
+      "SELECT summary256 FROM sampleblocks WHERE blockid = ?1;",
+      "summary256", frames64k * 256 * bytesPerFrame, mSummary256);
 }
 
 bool SqliteSampleBlock::GetSummary64k(float *dest,
                                       size_t frameoffset,
                                       size_t numframes)
 {
+   const auto frames64k = (mSampleCount + 65535) / 65536;
    return GetSummary(dest, frameoffset, numframes, DBConnection::GetSummary64k,
-      "SELECT summary64k FROM sampleblocks WHERE blockid = ?1;");
+      "SELECT summary64k FROM sampleblocks WHERE blockid = ?1;",
+      "summary64k", frames64k * bytesPerFrame, mSummary64k);
 }
 
 bool SqliteSampleBlock::GetSummary(float *dest,
                                    size_t frameoffset,
                                    size_t numframes,
                                    DBConnection::StatementID id,
-                                   const char *sql)
+                                   const char *sql,
+                                   const char *column,
+                                   size_t columnbytes,
+                                   const ArrayOf<char> &summary)
 {
    // Non-throwing, it returns true for success
    bool silent = IsSilent();
    if (!silent) {
       // Not a silent block
       try {
+         if (mSummaryPending) {
+            std::lock_guard<std::mutex> guard(mSummaryMutex);
+            // Check again, now that the worker thread can't intervene
+            if (mSummaryPending) {
+               // Compute on the fly until the row is complete
+               CalcPendingSummary();
+               const auto srcoffset = std::min(columnbytes,
+                  frameoffset * bytesPerFrame);
+               const auto srcbytes = numframes * bytesPerFrame;
+               const auto minbytes =
+                  std::min(srcbytes, columnbytes - srcoffset);
+               memcpy(dest, summary.get() + srcoffset, minbytes);
+               memset((char *)dest + minbytes, 0, srcbytes - minbytes);
+               return true;
+            }
+         }
+
+         const auto srcbytes = numframes * fields * SAMPLE_SIZE(floatSample);
+         if (IsPartialRead(srcbytes, columnbytes)) {
+            GetBlobRange(dest,
+                         floatSample,
+                         column,
+                         floatSample,
+                         frameoffset * fields * SAMPLE_SIZE(floatSample),
+                         srcbytes);
+            return true;
+         }
+
          // Prepare and cache statement...automatically finalized at DB close
          auto stmt = Conn()->Prepare(id, sql);
          // Note GetBlob returns a size_t, not a bool
@@ -491,26 +1078,13 @@ MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS(size_t start, size_t len)
       len = std::min(len, mSampleCount - start);
 
       // TODO: actually use summaries
-      SampleBuffer blockData(len, floatSample);
-      float *samples = (float *) blockData.ptr();
-
-      size_t copied = DoGetSamples((samplePtr) samples, floatSample, start, len);
-      for (size_t i = 0; i < copied; ++i, ++samples)
-      {
-         float sample = *samples;
-
-         if (sample > max)
-         {
-            max = sample;
-         }
-
-         if (sample < min)
-         {
-            min = sample;
-         }
+      // Read without conversion; the kernel converts on the fly
+      SampleBuffer blockData(len, mSampleFormat);
 
-         sumsq += (sample * sample);
-      }
+      size_t copied =
+         DoGetSamples(blockData.ptr(), mSampleFormat, start, len);
+      GetMinMaxSumsqFunction(mSampleFormat)(
+         blockData.ptr(), copied, min, max, sumsq);
    }
 
    return { min, max, (float) sqrt(sumsq / len) };
@@ -521,6 +1095,14 @@ MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS(size_t start, size_t len)
 /// these values are already computed.
 MinMaxRMS SqliteSampleBlock::DoGetMinMaxRMS() const
 {
+   if (mSummaryPending) {
+      // Logically const:  the summary values are determined by the samples
+      auto &self = const_cast<SqliteSampleBlock&>(*this);
+      std::lock_guard<std::mutex> guard(self.mSummaryMutex);
+      if (mSummaryPending)
+         self.CalcPendingSummary();
+   }
+
    return { (float) mSumMin, (float) mSumMax, (float) mSumRms };
 }
 
@@ -529,7 +1111,7 @@ size_t SqliteSampleBlock::GetSpaceUsage() const
    if (IsSilent())
       return 0;
    else
-      return ProjectFileIO::GetDiskUsage(*Conn(), mBlockID);
+      return mStoredBytes;
 }
 
 size_t SqliteSampleBlock::GetBlob(void *dest,
@@ -537,7 +1119,8 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
                                   sqlite3_stmt *stmt,
                                   sampleFormat srcformat,
                                   size_t srcoffset,
-                                  size_t srcbytes)
+                                  size_t srcbytes,
+                                  SampleBlockCodec codec)
 {
    auto db = DB();
 
@@ -549,7 +1132,6 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
    }
 
    int rc;
-   size_t minbytes = 0;
 
    // Bind statement parameters
    // Might return SQLITE_MISUSE which means it's our mistake that we violated
@@ -582,35 +1164,178 @@ size_t SqliteSampleBlock::GetBlob(void *dest,
    }
 
    // Retrieve returned data
-   samplePtr src = (samplePtr) sqlite3_column_blob(stmt, 0);
-   size_t blobbytes = (size_t) sqlite3_column_bytes(stmt, 0);
+   const bool copied = CopyFromBlob(dest,
+                destformat,
+                (constSamplePtr) sqlite3_column_blob(stmt, 0),
+                (size_t) sqlite3_column_bytes(stmt, 0),
+                srcformat,
+                srcoffset,
+                srcbytes,
+                codec);
+
+   // Clear statement bindings and rewind statement
+   sqlite3_clear_bindings(stmt);
+   sqlite3_reset(stmt);
+
+   if (!copied)
+   {
+      wxLogDebug(wxT("SqliteSampleBlock::GetBlob - corrupt encoding of block %lld"), (long long) mBlockID);
+
+      Conn()->ThrowException( false );
+   }
+
+   return srcbytes;
+}
+
+size_t SqliteSampleBlock::GetBlobRange(void *dest,
+                                       sampleFormat destformat,
+                                       const char *column,
+                                       sampleFormat srcformat,
+                                       size_t srcoffset,
+                                       size_t srcbytes)
+{
+   auto db = DB();
+
+   wxASSERT(!IsSilent());
+
+   if (!mValid)
+   {
+      Load(mBlockID);
+   }
+
+   // Not cached like prepared statements:  an open blob handle would keep a
+   // read transaction open and so hold back checkpoints
+   sqlite3_blob *blob = nullptr;
+   auto cleanup = finally( [&blob]{ sqlite3_blob_close(blob); } );
+
+   int rc = sqlite3_blob_open(db, "main", "sampleblocks", column, mBlockID,
+      0, &blob);
+   if (rc != SQLITE_OK)
+   {
+      wxLogDebug(wxT("SqliteSampleBlock::GetBlobRange - SQLITE error %s"), sqlite3_errmsg(db));
 
+      // Just showing the user a simple message, not the library error too
+      // which isn't internationalized
+      Conn()->ThrowException( false );
+   }
+
+   const auto srcsize = SAMPLE_SIZE(srcformat);
+   const size_t blobbytes = sqlite3_blob_bytes(blob);
    srcoffset = std::min(srcoffset, blobbytes);
-   minbytes = std::min(srcbytes, blobbytes - srcoffset);
+   const auto minbytes = std::min(srcbytes, blobbytes - srcoffset);
+
+   // Read straight into the destination when no conversion is needed
+   SampleBuffer buffer;
+   auto src = (srcformat == destformat)
+      ? (samplePtr) dest
+      : buffer.Allocate(minbytes / srcsize, srcformat).ptr();
+
+   if (minbytes)
+   {
+      rc = sqlite3_blob_read(blob, src, minbytes, srcoffset);
+      if (rc != SQLITE_OK)
+      {
+         wxLogDebug(wxT("SqliteSampleBlock::GetBlobRange - SQLITE error %s"), sqlite3_errmsg(db));
+
+         Conn()->ThrowException( false );
+      }
+   }
+
+   if (src != dest)
+   {
+      CopySamples(src,
+                  srcformat,
+                  (samplePtr) dest,
+                  destformat,
+                  minbytes / srcsize);
+   }
+
+   if (srcbytes - minbytes)
+   {
+      ClearSamples((samplePtr) dest,
+                   destformat,
+                   minbytes / srcsize,
+                   (srcbytes - minbytes) / srcsize);
+   }
+
+   return srcbytes;
+}
+
+bool SqliteSampleBlock::CopyFromBlob(void *dest,
+                                     sampleFormat destformat,
+                                     constSamplePtr src,
+                                     size_t blobbytes,
+                                     sampleFormat srcformat,
+                                     size_t srcoffset,
+                                     size_t srcbytes,
+                                     SampleBlockCodec codec)
+{
+   const auto srcsize = SAMPLE_SIZE(srcformat);
 
-   if (srcoffset != 0)
+   SampleBuffer decoded;
+   if (codec != SampleBlockCodec::None)
    {
-      srcoffset += 0;
+      // Decode all, then copy the part wanted
+      const auto count = SampleBlockCoding::DecodedCount(src, blobbytes);
+      if (count == 0)
+         return false;
+      decoded.Allocate(count, srcformat);
+      if (!SampleBlockCoding::Decode(src, blobbytes, srcformat, decoded.ptr()))
+         return false;
+      src = decoded.ptr();
+      blobbytes = count * srcsize;
    }
 
+   srcoffset = std::min(srcoffset, blobbytes);
+   const auto minbytes = std::min(srcbytes, blobbytes - srcoffset);
+
    CopySamples(src + srcoffset,
                srcformat,
                (samplePtr) dest,
                destformat,
-               minbytes / SAMPLE_SIZE(srcformat));
-
-   dest = ((samplePtr) dest) + minbytes;
+               minbytes / srcsize);
 
    if (srcbytes - minbytes)
    {
-      memset(dest, 0, srcbytes - minbytes);
+      ClearSamples((samplePtr) dest,
+                   destformat,
+                   minbytes / srcsize,
+                   (srcbytes - minbytes) / srcsize);
    }
 
-   // Clear statement bindings and rewind statement
-   sqlite3_clear_bindings(stmt);
-   sqlite3_reset(stmt);
+   return true;
+}
 
-   return srcbytes;
+auto SqliteSampleBlock::ReadIntoCache() -> SampleBlockCache::ContentsPtr
+{
+   auto pContents = std::make_shared<SampleBlockCache::Contents>(
+      mSampleCount, mSampleFormat);
+
+   // Prepare and cache statement...automatically finalized at DB close
+   sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::GetSamples,
+      "SELECT samples FROM sampleblocks WHERE blockid = ?1;");
+
+   GetBlob(pContents->samples.ptr(),
+           mSampleFormat,
+           stmt,
+           mSampleFormat,
+           0,
+           mSampleBytes,
+           mCodec);
+
+   SampleBlockCache::Get().Insert(mpFactory.get(), mBlockID, pContents);
+   return pContents;
+}
+
+size_t SqliteSampleBlock::CopyFromCache(void *dest, sampleFormat destformat,
+   const SampleBlockCache::Contents &contents,
+   size_t sampleoffset, size_t numsamples)
+{
+   const auto size = SAMPLE_SIZE(contents.format);
+   CopyFromBlob(dest, destformat, contents.samples.ptr(),
+      contents.count * size, contents.format,
+      sampleoffset * size, numsamples * size, SampleBlockCodec::None);
+   return numsamples;
 }
 
 void SqliteSampleBlock::Load(SampleBlockID sbid)
@@ -628,10 +1353,14 @@ void SqliteSampleBlock::Load(SampleBlockID sbid)
    mSumMin = 0.0;
 
    // Prepare and cache statement...automatically finalized at DB close
-   sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::LoadSampleBlock,
-      "SELECT sampleformat, summin, summax, sumrms,"
-      "       length(samples)"
-      "  FROM sampleblocks WHERE blockid = ?1;");
+   const bool hasCodecs = Conn()->HasSampleBlockCodecs();
+   static const std::string sql = std::string{ "SELECT " } +
+      LoadColumns + " FROM sampleblocks WHERE blockid = ?1;";
+   static const std::string sqlCodec = std::string{ "SELECT " } +
+      LoadColumns + LoadCodecColumns + " FROM sampleblocks WHERE blockid = ?1;";
+   sqlite3_stmt *stmt = hasCodecs
+      ? Conn()->Prepare(DBConnection::LoadSampleBlockCodec, sqlCodec.c_str())
+      : Conn()->Prepare(DBConnection::LoadSampleBlock, sql.c_str());
 
    // Bind statement parameters
    // Might return SQLITE_MISUSE which means it's our mistake that we violated
@@ -658,16 +1387,38 @@ void SqliteSampleBlock::Load(SampleBlockID sbid)
 
    // Retrieve returned data
    mBlockID = sbid;
-   mSampleFormat = (sampleFormat) sqlite3_column_int(stmt, 0);
-   mSumMin = sqlite3_column_double(stmt, 1);
-   mSumMax = sqlite3_column_double(stmt, 2);
-   mSumRms = sqlite3_column_double(stmt, 3);
-   mSampleBytes = sqlite3_column_int(stmt, 4);
-   mSampleCount = mSampleBytes / SAMPLE_SIZE(mSampleFormat);
+   LoadFromRow(stmt, 0, hasCodecs);
 
    // Clear statement bindings and rewind statement
    sqlite3_clear_bindings(stmt);
    sqlite3_reset(stmt);
+}
+
+void SqliteSampleBlock::LoadFromRow(
+   sqlite3_stmt *stmt, int column, bool hasCodecs)
+{
+   mSampleFormat = (sampleFormat) sqlite3_column_int(stmt, column);
+   mSumMin = sqlite3_column_double(stmt, column + 1);
+   mSumMax = sqlite3_column_double(stmt, column + 2);
+   mSumRms = sqlite3_column_double(stmt, column + 3);
+   mSampleBytes = sqlite3_column_int(stmt, column + 4);
+   mSampleCount = mSampleBytes / SAMPLE_SIZE(mSampleFormat);
+   mStoredBytes = mSampleBytes + sqlite3_column_int64(stmt, column + 6);
+   mCodec = hasCodecs
+      ? (SampleBlockCodec) sqlite3_column_int(stmt, column + 7)
+      : SampleBlockCodec::None;
+
+   // Summaries may be missing if they were deferred and never written
+   mSummaryPending =
+      mSampleBytes > 0 && sqlite3_column_int(stmt, column + 5) == 0;
+   mSummaryCalculated = false;
+
+   if (mCodec != SampleBlockCodec::None)
+   {
+      // The length of the column is not that of the decoded samples
+      mSampleCount = sqlite3_column_int64(stmt, column + 8);
+      mSampleBytes = mSampleCount * SAMPLE_SIZE(mSampleFormat);
+   }
 
    mValid = true;
 }
@@ -680,11 +1431,33 @@ void SqliteSampleBlock::Commit(Sizes sizes)
    auto db = DB();
    int rc;
 
+   // Encode if the project allows it, keeping raw samples when that
+   // doesn't save space
+   const bool hasCodecs = Conn()->HasSampleBlockCodecs();
+   std::vector<unsigned char> encoded;
+   mCodec = SampleBlockCodec::None;
+   if (hasCodecs && mpFactory->mCodec != SampleBlockCodec::None &&
+       SampleBlockCoding::Encode(
+          mSamples.get(), mSampleCount, mSampleFormat, encoded))
+      mCodec = mpFactory->mCodec;
+   const void *samples = mCodec == SampleBlockCodec::None
+      ? (const void *) mSamples.get()
+      : encoded.data();
+   const size_t samplesBytes = mCodec == SampleBlockCodec::None
+      ? mSampleBytes
+      : encoded.size();
+
    // Prepare and cache statement...automatically finalized at DB close
-   sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::InsertSampleBlock,
-      "INSERT INTO sampleblocks (sampleformat, summin, summax, sumrms,"
-      "                          summary256, summary64k, samples)"
-      "                         VALUES(?1,?2,?3,?4,?5,?6,?7);");
+   sqlite3_stmt *stmt = hasCodecs
+      ? Conn()->Prepare(DBConnection::InsertSampleBlockCodec,
+         "INSERT INTO sampleblocks (sampleformat, summin, summax, sumrms,"
+         "                          summary256, summary64k, samples, codec,"
+         "                          samplecount)"
+         "                         VALUES(?1,?2,?3,?4,?5,?6,?7,?8,?9);")
+      : Conn()->Prepare(DBConnection::InsertSampleBlock,
+         "INSERT INTO sampleblocks (sampleformat, summin, summax, sumrms,"
+         "                          summary256, summary64k, samples)"
+         "                         VALUES(?1,?2,?3,?4,?5,?6,?7);");
 
    // Bind statement parameters
    // Might return SQLITE_MISUSE which means it's our mistake that we violated
@@ -695,7 +1468,9 @@ void SqliteSampleBlock::Commit(Sizes sizes)
        sqlite3_bind_double(stmt, 4, mSumRms) ||
        sqlite3_bind_blob(stmt, 5, mSummary256.get(), mSummary256Bytes, SQLITE_STATIC) ||
        sqlite3_bind_blob(stmt, 6, mSummary64k.get(), mSummary64kBytes, SQLITE_STATIC) ||
-       sqlite3_bind_blob(stmt, 7, mSamples.get(), mSampleBytes, SQLITE_STATIC))
+       sqlite3_bind_blob(stmt, 7, samples, samplesBytes, SQLITE_STATIC) ||
+       (hasCodecs && (sqlite3_bind_int(stmt, 8, (int) mCodec) ||
+          sqlite3_bind_int64(stmt, 9, mSampleCount))))
    {
       wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
    }
@@ -717,11 +1492,15 @@ void SqliteSampleBlock::Commit(Sizes sizes)
 
    // Retrieve returned data
    mBlockID = sqlite3_last_insert_rowid(db);
+   mStoredBytes = samplesBytes + mSummary256Bytes + mSummary64kBytes;
 
-   // Reset local arrays
-   mSamples.reset();
-   mSummary256.reset();
-   mSummary64k.reset();
+   // Reset local arrays, unless still needed for pending summaries
+   if (!mSummaryPending)
+   {
+      mSamples.reset();
+      mSummary256.reset();
+      mSummary64k.reset();
+   }
 
    // Clear statement bindings and rewind statement
    sqlite3_clear_bindings(stmt);
@@ -796,24 +1575,11 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
    const auto mSummary256Bytes = sizes.first;
    const auto mSummary64kBytes = sizes.second;
 
-   Floats samplebuffer;
-   float *samples;
+   // Integer samples are converted as they are scanned, without a buffer
+   const auto minMaxSumsq = GetMinMaxSumsqFunction(mSampleFormat);
+   const auto sampleSize = SAMPLE_SIZE(mSampleFormat);
+   constSamplePtr samples = mSamples.get();
 
-   if (mSampleFormat == floatSample)
-   {
-      samples = (float *) mSamples.get();
-   }
-   else
-   {
-      samplebuffer.reinit((unsigned) mSampleCount);
-      CopySamples(mSamples.get(),
-                  mSampleFormat,
-                  (samplePtr) samplebuffer.get(),
-                  floatSample,
-                  mSampleCount);
-      samples = samplebuffer.get();
-   }
-   
    mSummary256.reinit(mSummary256Bytes);
    mSummary64k.reinit(mSummary64kBytes);
 
@@ -832,10 +1598,6 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
 
    for (int i = 0; i < sumLen; ++i)
    {
-      min = samples[i * 256];
-      max = samples[i * 256];
-      sumsq = min * min;
-
       int jcount = 256;
       if (jcount > mSampleCount - i * 256)
       {
@@ -843,20 +1605,7 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
          fraction = 1.0 - (jcount / 256.0);
       }
 
-      for (int j = 1; j < jcount; ++j)
-      {
-         float f1 = samples[i * 256 + j];
-         sumsq += f1 * f1;
-
-         if (f1 < min)
-         {
-            min = f1;
-         }
-         else if (f1 > max)
-         {
-            max = f1;
-         }
-      }
+      minMaxSumsq(samples + i * 256 * sampleSize, jcount, min, max, sumsq);
 
       totalSquares += sumsq;
 
@@ -947,6 +1696,110 @@ void SqliteSampleBlock::CalcSummary(Sizes sizes)
    mSumMax = max;
 }
 
+void SqliteSampleBlock::CalcPendingSummary()
+{
+   if (mSummaryCalculated)
+      return;
+
+   if (!mSamples)
+   {
+      // Loaded from the database, not created in this session
+      ArrayOf<char> samples{ mSampleBytes };
+
+      // Prepare and cache statement...automatically finalized at DB close
+      sqlite3_stmt *stmt = Conn()->Prepare(DBConnection::GetSamples,
+         "SELECT samples FROM sampleblocks WHERE blockid = ?1;");
+      GetBlob(samples.get(),
+              mSampleFormat,
+              stmt,
+              mSampleFormat,
+              0,
+              mSampleBytes,
+              mCodec);
+      mSamples = std::move(samples);
+   }
+
+   CalcSummary( SetSizes(mSampleCount, mSampleFormat) );
+   mSummaryCalculated = true;
+}
+
+void SqliteSampleBlock::WriteSummary( bool track )
+{
+   std::lock_guard<std::mutex> guard(mSummaryMutex);
+   if (!mSummaryPending)
+      return;
+
+   CalcPendingSummary();
+   const auto sizes = SetSizes(mSampleCount, mSampleFormat);
+   const auto summaryBytes = sizes.first + sizes.second;
+
+   auto pConn = Conn();
+   auto db = pConn->DB();
+
+   // Another thread may have a savepoint open on the shared connection, and
+   // roll it back, undoing the UPDATE too
+   std::weak_ptr<SqliteSampleBlockFactory> wFactory = mpFactory;
+   pConn->WriteInSavepoints( [&]( bool inSavepoint ){
+      int rc;
+
+      // Prepare and cache statement...automatically finalized at DB close
+      sqlite3_stmt *stmt = pConn->Prepare(DBConnection::UpdateSummary,
+         "UPDATE sampleblocks SET summin = ?1, summax = ?2, sumrms = ?3,"
+         "                        summary256 = ?4, summary64k = ?5"
+         "                    WHERE blockid = ?6;");
+
+      // Bind statement parameters
+      // Might return SQLITE_MISUSE which means it's our mistake that we violated
+      // preconditions; should return SQL_OK which is 0
+      if (sqlite3_bind_double(stmt, 1, mSumMin) ||
+          sqlite3_bind_double(stmt, 2, mSumMax) ||
+          sqlite3_bind_double(stmt, 3, mSumRms) ||
+          sqlite3_bind_blob(stmt, 4, mSummary256.get(), sizes.first, SQLITE_STATIC) ||
+          sqlite3_bind_blob(stmt, 5, mSummary64k.get(), sizes.second, SQLITE_STATIC) ||
+          sqlite3_bind_int64(stmt, 6, mBlockID))
+      {
+         wxASSERT_MSG(false, wxT("Binding failed...bug!!!"));
+      }
+
+      // Execute the statement
+      rc = sqlite3_step(stmt);
+      if (rc != SQLITE_DONE)
+      {
+         wxLogDebug(wxT("SqliteSampleBlock::WriteSummary - SQLITE error %s"), sqlite3_errmsg(db));
+
+         // Clear statement bindings and rewind statement
+         sqlite3_clear_bindings(stmt);
+         sqlite3_reset(stmt);
+
+         // Just showing the user a simple message, not the library error too
+         // which isn't internationalized
+         pConn->ThrowException( true );
+      }
+
+      // Clear statement bindings and rewind statement
+      sqlite3_clear_bindings(stmt);
+      sqlite3_reset(stmt);
+
+      // Update the state before the savepoint can end
+      mStoredBytes += summaryBytes;
+      mSummaryPending = false;
+      if (inSavepoint && track) {
+         std::lock_guard<std::mutex> factoryGuard(mpFactory->mSummaryMutex);
+         mpFactory->mSummariesInSavepoint[ this ] = summaryBytes;
+      }
+   },
+   [wFactory, pBlock = this]( bool rolledBack ){
+      if (auto pFactory = wFactory.lock())
+         pFactory->SummarySavepointEnded( pBlock, rolledBack );
+   } );
+
+   // Reset local arrays
+   mSamples.reset();
+   mSummary256.reset();
+   mSummary64k.reset();
+   mSummaryCalculated = false;
+}
+
 // Inject our database implementation at startup
 static struct Injector
 {
@@ -0,0 +1,240 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ThreadPool.cpp
+
+**********************************************************************/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+struct ThreadPool::Batch
+{
+   Batch(const Task &task_, size_t nQueues, size_t count)
+      : task{ task_ }, queues(nQueues), remaining{ count }
+   {
+      // Give each queue a contiguous run of indices
+      for (size_t ii = 0; ii < count; ++ii)
+         queues[ii * nQueues / count].indices.push_back(ii);
+   }
+
+   struct Queue
+   {
+      std::mutex mutex;
+      std::deque<size_t> indices;
+   };
+
+   // Find an index in the given slot's queue, or else steal one
+   bool Take(size_t slot, size_t &index)
+   {
+      const auto nQueues = queues.size();
+      for (size_t ii = 0; ii < nQueues; ++ii) {
+         auto &queue = queues[(slot + ii) % nQueues];
+         std::lock_guard<std::mutex> lock{ queue.mutex };
+         if (!queue.indices.empty()) {
+            if (ii == 0) {
+               index = queue.indices.front();
+               queue.indices.pop_front();
+            }
+            else {
+               index = queue.indices.back();
+               queue.indices.pop_back();
+            }
+            return true;
+         }
+      }
+      return false;
+   }
+
+   const Task &task;
+   std::vector<Queue> queues;
+   std::atomic<size_t> nextSlot{ 1 };
+
+   // Count of tasks not yet finished or skipped
+   std::atomic<size_t> remaining;
+   std::atomic<bool> stop{ false };
+
+   std::mutex doneMutex;
+   std::condition_variable done;
+   std::exception_ptr error;
+};
+
+ThreadPool &ThreadPool::Get()
+{
+   static ThreadPool pool{
+      std::max(1u, std::thread::hardware_concurrency()) };
+   return pool;
+}
+
+ThreadPool::ThreadPool(unsigned nThreads)
+{
+   for (unsigned ii = 0; ii < nThreads; ++ii)
+      mThreads.emplace_back([this]{ Run(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mStop = true;
+   }
+   mAvailable.notify_all();
+   for (auto &thread : mThreads)
+      thread.join();
+}
+
+void ThreadPool::Run()
+{
+   while (true) {
+      std::shared_ptr<Batch> pBatch;
+      {
+         std::unique_lock<std::mutex> lock{ mMutex };
+         mAvailable.wait(lock, [this]{ return mStop || !mBatches.empty(); });
+         if (mStop)
+            return;
+         pBatch = mBatches.front();
+      }
+
+      Work(*pBatch, pBatch->nextSlot++ % pBatch->queues.size());
+
+      // No more tasks to take from this batch
+      std::lock_guard<std::mutex> lock{ mMutex };
+      auto end = mBatches.end(),
+         found = std::find(mBatches.begin(), end, pBatch);
+      if (found != end)
+         mBatches.erase(found);
+   }
+}
+
+void ThreadPool::Work(Batch &batch, size_t slot)
+{
+   size_t index;
+   while (batch.Take(slot, index)) {
+      if (!batch.stop) {
+         try {
+            batch.task(index);
+         }
+         catch (...) {
+            std::lock_guard<std::mutex> lock{ batch.doneMutex };
+            if (!batch.error)
+               batch.error = std::current_exception();
+            batch.stop = true;
+         }
+      }
+      if (--batch.remaining == 0) {
+         std::lock_guard<std::mutex> lock{ batch.doneMutex };
+         batch.done.notify_all();
+      }
+   }
+}
+
+bool ThreadPool::ParallelFor(size_t count, const Task &task, const Poll &poll)
+{
+   if (count == 0)
+      return true;
+
+   if (mThreads.empty()) {
+      for (size_t ii = 0; ii < count; ++ii) {
+         if (poll && !poll())
+            return false;
+         task(ii);
+      }
+      return true;
+   }
+
+   // Slot 0 is for the calling thread
+   const auto pBatch =
+      std::make_shared<Batch>(task, mThreads.size() + 1, count);
+   auto &batch = *pBatch;
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mBatches.push_back(pBatch);
+   }
+   mAvailable.notify_all();
+
+   bool result = true;
+   if (!poll)
+      Work(batch, 0);
+   {
+      std::unique_lock<std::mutex> lock{ batch.doneMutex };
+      while (batch.remaining > 0) {
+         if (!poll)
+            batch.done.wait(lock);
+         else if (!batch.done.wait_for(lock, std::chrono::milliseconds(50),
+               [&]{ return batch.remaining == 0; })) {
+            lock.unlock();
+            if (result && !poll()) {
+               result = false;
+               batch.stop = true;
+            }
+            lock.lock();
+         }
+      }
+   }
+
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      auto end = mBatches.end(),
+         found = std::find(mBatches.begin(), end, pBatch);
+      if (found != end)
+         mBatches.erase(found);
+   }
+
+   if (batch.error)
+      std::rethrow_exception(batch.error);
+
+   return result;
+}
+
+ReusedThreads &ReusedThreads::Get()
+{
+   static ReusedThreads threads;
+   return threads;
+}
+
+ReusedThreads::~ReusedThreads()
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mStop = true;
+   }
+   mAvailable.notify_all();
+   for (auto &thread : mThreads)
+      thread.join();
+}
+
+std::future<void> ReusedThreads::Run(std::function<void()> job)
+{
+   std::packaged_task<void()> task{ std::move(job) };
+   auto result = task.get_future();
+   std::lock_guard<std::mutex> lock{ mMutex };
+   mJobs.push_back(std::move(task));
+   if (mIdle < mJobs.size()) {
+      ++mIdle;
+      mThreads.emplace_back( [this]{ Work(); } );
+   }
+   mAvailable.notify_one();
+   return result;
+}
+
+void ReusedThreads::Work()
+{
+   std::unique_lock<std::mutex> lock{ mMutex };
+   while (true) {
+      mAvailable.wait(lock, [this]{ return mStop || !mJobs.empty(); });
+      if (mStop)
+         break;
+      auto task = std::move(mJobs.front());
+      mJobs.pop_front();
+      --mIdle;
+      lock.unlock();
+      task();
+      lock.lock();
+      ++mIdle;
+   }
+}
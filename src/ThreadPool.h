@@ -0,0 +1,116 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ThreadPool.h
+
+*******************************************************************//**
+
+\class ThreadPool
+\brief A fixed set of worker threads that share out batches of
+independent tasks
+
+Each batch divides its tasks among one queue for each participating
+thread.  A thread takes tasks from the front of its own queue, and when
+that is empty, steals from the back of the others, so that tasks of
+unequal cost still keep all threads busy.
+
+*//****************************************************************//**
+
+\class ReusedThreads
+\brief Long-lived threads for jobs that run beside the caller for a while,
+such as mixing ahead for an export, or writing the samples of an import
+
+A thread is added only when all are busy, so that their number stays
+bounded by the jobs ever running at once.  Threads are reused, and so are
+the statements that DBConnection prepares for each.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_THREAD_POOL__
+#define __AUDACITY_THREAD_POOL__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class AUDACITY_DLL_API ThreadPool final
+{
+public:
+   //! The pool shared by the whole application, with a thread per core
+   static ThreadPool &Get();
+
+   explicit ThreadPool(unsigned nThreads);
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool &operator=(const ThreadPool&) = delete;
+   ~ThreadPool();
+
+   //! Number of worker threads, not counting the callers of ParallelFor
+   unsigned GetThreadCount() const { return mThreads.size(); }
+
+   using Task = std::function<void(size_t index)>;
+   using Poll = std::function<bool()>;
+
+   //! Call task(0) ... task(count - 1) in any order on any threads, and
+   //! return when all calls are done
+   /*!
+    Without poll, the calling thread takes tasks too, so that a task may
+    itself call ParallelFor.  With poll, the calling thread only calls poll
+    at intervals, which suits the main thread, updating a progress
+    indicator; tasks not yet started are skipped once poll returns false.
+
+    If a task throws, tasks not yet started are skipped, and the first
+    exception is rethrown here.
+
+    @return false if poll stopped the batch early
+    */
+   bool ParallelFor(size_t count, const Task &task, const Poll &poll = {});
+
+private:
+   struct Batch;
+
+   void Run();
+   static void Work(Batch &batch, size_t slot);
+
+   std::vector<std::thread> mThreads;
+
+   std::mutex mMutex;
+   std::condition_variable mAvailable;
+   // Batches that may have tasks not yet taken
+   std::deque< std::shared_ptr<Batch> > mBatches;
+   bool mStop{ false };
+};
+
+class AUDACITY_DLL_API ReusedThreads final
+{
+public:
+   //! The threads shared by the whole application
+   static ReusedThreads &Get();
+
+   ReusedThreads() = default;
+   ReusedThreads(const ReusedThreads&) = delete;
+   ReusedThreads &operator=(const ReusedThreads&) = delete;
+   ~ReusedThreads();
+
+   //! Start job on an idle thread, or on a new one if none is idle
+   //! @return ready when the job is done
+   std::future<void> Run(std::function<void()> job);
+
+private:
+   void Work();
+
+   std::mutex mMutex;
+   std::condition_variable mAvailable;
+   std::deque< std::packaged_task<void()> > mJobs;
+   std::vector<std::thread> mThreads;
+   // Threads not running a job
+   size_t mIdle{ 0 };
+   bool mStop{ false };
+};
+
+#endif
@@ -122,6 +122,22 @@ Track::Holder Track::Duplicate() const
    return result;
 }
 
+Track::Holder Track::SharingDuplicate(const Track *pPrevious) const
+{
+   auto result = pPrevious ? SharingClone(pPrevious) : Clone();
+
+   if (mpView)
+      // Copy view state that might be important to undo/redo
+      mpView->CopyTo( *result );
+
+   return result;
+}
+
+Track::Holder Track::SharingClone(const Track *) const
+{
+   return Clone();
+}
+
 Track::~Track()
 {
 }
@@ -402,6 +402,12 @@ private:
    // public nonvirtual duplication function that invokes Clone():
    virtual Holder Duplicate() const;
 
+   // Like Duplicate(), but the copy may share unchanged parts with
+   // pPrevious, an earlier copy of this track made the same way.
+   // The copy, and pPrevious, must not be modified afterward.  This is
+   // meant for undo history.
+   Holder SharingDuplicate(const Track *pPrevious) const;
+
    // Called when this track is merged to stereo with another, and should
    // take on some parameters of its partner.
    virtual void Merge(const Track &orig);
@@ -463,6 +469,9 @@ private:
    // the track data proper (not associated data such as for groups and views):
    virtual Holder Clone() const = 0;
 
+   // Implements part of SharingDuplicate(); the default ignores pPrevious
+   virtual Holder SharingClone(const Track *pPrevious) const;
+
    virtual TrackKind GetKind() const { return TrackKind::None; }
 
    template<typename T>
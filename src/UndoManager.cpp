@@ -38,6 +38,7 @@ UndoManager
 #include "widgets/ProgressDialog.h"
 
 
+#include <map>
 #include <unordered_set>
 
 wxDEFINE_EVENT(EVT_UNDO_PUSHED, wxCommandEvent);
@@ -277,6 +278,29 @@ bool UndoManager::RedoAvailable()
    return (current < (int)stack.size() - 1);
 }
 
+// Copy the tracks for an undo state.  Copies may share unchanged parts,
+// such as wave clips, with the same tracks in a previous state, so that the
+// cost is in proportion to what changed.
+static std::shared_ptr<TrackList> SnapshotTracks(
+   const TrackList &tracks, const TrackList *pPrevious)
+{
+   std::map< TrackId, const Track* > previous;
+   if (pPrevious)
+      for (auto t : *pPrevious)
+         previous.emplace( t->GetId(), t );
+
+   auto tracksCopy = TrackList::Create( nullptr );
+   for (auto t : tracks) {
+      if ( t->GetId() == TrackId{} )
+         // Don't copy a pending added track
+         continue;
+      auto iter = previous.find( t->GetId() );
+      tracksCopy->Add( t->SharingDuplicate(
+         iter == previous.end() ? nullptr : iter->second ) );
+   }
+   return tracksCopy;
+}
+
 void UndoManager::ModifyState(const TrackList * l,
                               const SelectedRegion &selectedRegion,
                               const std::shared_ptr<Tags> &tags)
@@ -286,17 +310,8 @@ void UndoManager::ModifyState(const TrackList * l,
    }
 
 //   SonifyBeginModifyState();
-   // Delete current -- not necessary, but let's reclaim space early
-   stack[current]->state.tracks.reset();
-
-   // Duplicate
-   auto tracksCopy = TrackList::Create( nullptr );
-   for (auto t : *l) {
-      if ( t->GetId() == TrackId{} )
-         // Don't copy a pending added track
-         continue;
-      tracksCopy->Add(t->Duplicate());
-   }
+   // Duplicate, sharing with the current state what didn't change
+   auto tracksCopy = SnapshotTracks( *l, stack[current]->state.tracks.get() );
 
    // Replace
    stack[current]->state.tracks = std::move(tracksCopy);
@@ -343,13 +358,8 @@ void UndoManager::PushState(const TrackList * l,
       return;
    }
 
-   auto tracksCopy = TrackList::Create( nullptr );
-   for (auto t : *l) {
-      if ( t->GetId() == TrackId{} )
-         // Don't copy a pending added track
-         continue;
-      tracksCopy->Add(t->Duplicate());
-   }
+   auto tracksCopy = SnapshotTracks( *l,
+      current >= 0 ? stack[current]->state.tracks.get() : nullptr );
 
    mayConsolidate = true;
 
@@ -8,8 +8,9 @@
 
   After each operation, call UndoManager's PushState, pass it
   the entire track hierarchy.  The UndoManager makes a duplicate
-  of every single track using its Duplicate method, which should
-  increment reference counts.  If we were not at the top of
+  of every single track using its SharingDuplicate method, which should
+  increment reference counts, and may share unchanged parts with the
+  previous state.  If we were not at the top of
   the stack when this is called, DELETE above first.
 
   If a minor change is made, for example changing the visual
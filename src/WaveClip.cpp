@@ -23,6 +23,8 @@
 
 #include "Experimental.h"
 
+#include <algorithm>
+#include <atomic>
 #include <math.h>
 #include <vector>
 #include <wx/log.h>
@@ -32,6 +34,7 @@
 #include "Prefs.h"
 #include "Envelope.h"
 #include "Resample.h"
+#include "ThreadPool.h"
 #include "WaveTrack.h"
 #include "Profiler.h"
 #include "InconsistencyException.h"
@@ -159,6 +162,21 @@ WaveClip::WaveClip(const WaveClip& orig,
    mIsPlaceholder = orig.GetIsPlaceholder();
 }
 
+bool WaveClip::HasSameContents(const WaveClip &other) const
+{
+   // Compare what the copy constructor copies; caches don't matter
+   return mOffset == other.mOffset &&
+      mRate == other.mRate &&
+      mColourIndex == other.mColourIndex &&
+      mIsPlaceholder == other.mIsPlaceholder &&
+      mSequence->HasSameContents( *other.mSequence ) &&
+      mEnvelope->HasSameContents( *other.mEnvelope ) &&
+      std::equal( mCutLines.begin(), mCutLines.end(),
+         other.mCutLines.begin(), other.mCutLines.end(),
+         []( const WaveClipHolder &a, const WaveClipHolder &b ){
+            return a->HasSameContents( *b ); } );
+}
+
 WaveClip::WaveClip(const WaveClip& orig,
                    const SampleBlockFactoryPtr &factory,
                    bool copyCutlines,
@@ -215,6 +233,7 @@ void WaveClip::SetOffset(double offset)
 {
     mOffset = offset;
     mEnvelope->SetOffset(mOffset);
+    LayoutChanged();
 }
 
 bool WaveClip::GetSamples(samplePtr buffer, sampleFormat format,
@@ -1175,6 +1194,8 @@ void WaveClip::UpdateEnvelopeTrackLen()
    auto len = (mSequence->GetNumSamples().as_double()) / mRate;
    if (len != mEnvelope->GetTrackLen())
       mEnvelope->SetTrackLen(len, 1.0 / GetRate());
+   // Appending and loading change the length
+   LayoutChanged();
 }
 
 void WaveClip::TimeToSamplesClip(double t0, sampleCount *s0) const
@@ -1189,15 +1210,18 @@ void WaveClip::TimeToSamplesClip(double t0, sampleCount *s0) const
 
 /*! @excsafety{Strong} */
 std::shared_ptr<SampleBlock> WaveClip::AppendNewBlock(
-   samplePtr buffer, sampleFormat format, size_t len)
+   constSamplePtr buffer, sampleFormat format, size_t len)
 {
-   return mSequence->AppendNewBlock( buffer, format, len );
+   auto result = mSequence->AppendNewBlock( buffer, format, len );
+   LayoutChanged();
+   return result;
 }
 
 /*! @excsafety{Strong} */
 void WaveClip::AppendSharedBlock(const std::shared_ptr<SampleBlock> &pBlock)
 {
    mSequence->AppendSharedBlock( pBlock );
+   LayoutChanged();
 }
 
 /*! @excsafety{Partial}
@@ -1413,6 +1437,7 @@ void WaveClip::Paste(double t0, const WaveClip* other)
 
    // Assume No-fail-guarantee in the remaining
    MarkChanged();
+   LayoutChanged();
    auto sampleTime = 1.0 / GetRate();
    mEnvelope->PasteEnvelope
       (s0.as_double()/mRate + mOffset, pastedClip->mEnvelope.get(), sampleTime);
@@ -1453,6 +1478,7 @@ void WaveClip::InsertSilence( double t, double len, double *pEnvelopeValue )
       pEnvelope->InsertSpace( t, len );
 
    MarkChanged();
+   LayoutChanged();
 }
 
 /*! @excsafety{Strong} */
@@ -1521,6 +1547,7 @@ void WaveClip::Clear(double t0, double t1)
       Offset(-(GetStartTime() - t0));
 
    MarkChanged();
+   LayoutChanged();
 }
 
 /*! @excsafety{Weak}
@@ -1574,6 +1601,7 @@ void WaveClip::ClearAndAddCutLine(double t0, double t1)
       Offset(-(GetStartTime() - t0));
 
    MarkChanged();
+   LayoutChanged();
 
    mCutLines.push_back(std::move(newClip));
 }
@@ -1668,6 +1696,113 @@ void WaveClip::SetRate(int rate)
    auto newLength = mSequence->GetNumSamples().as_double() / mRate;
    mEnvelope->RescaleTimes( newLength );
    MarkChanged();
+   LayoutChanged();
+}
+
+// Resample segments of a long sequence at once on all cores, and append the
+// results in order.  Each segment begins and ends at a multiple of the period
+// of input samples that corresponds exactly to a whole number of output
+// samples.  The resampler for each segment is also fed some input before and
+// after, so that its filter is full at the seams; the output for that input
+// is discarded.
+// Returns false if there are too few segments to be worth it.
+static bool ResampleInSegments(const Sequence &sequence, Sequence &newSequence,
+   int fromRate, int toRate, ProgressDialog *progress)
+{
+   auto &pool = ThreadPool::Get();
+   if (pool.GetThreadCount() == 0)
+      return false;
+
+   // Reduce the ratio of rates
+   size_t a = fromRate, b = toRate;
+   while (b != 0) {
+      const auto r = a % b;
+      a = b, b = r;
+   }
+   const size_t period = fromRate / a, outPeriod = toRate / a;
+
+   // Many times longer than the filter, which is much shorter than warmUp
+   const size_t segmentLen = std::max<size_t>(1, (1 << 20) / period) * period;
+   const size_t warmUp = (((1 << 15) + period - 1) / period) * period;
+
+   const auto numSamples = sequence.GetNumSamples();
+   const auto nSegments =
+      ((numSamples + segmentLen - 1) / segmentLen).as_size_t();
+   if (nSegments < 2)
+      return false;
+
+   const double factor = (double)toRate / (double)fromRate;
+   std::vector< std::vector<float> > outputs;
+   std::atomic<long long> done{ 0 };
+   const auto resampleSegment = [&](size_t ii, std::vector<float> &output) {
+      const sampleCount start = ii * segmentLen;
+      const auto end = std::min(start + segmentLen, numSamples);
+      const auto readStart = (ii == 0) ? start : start - warmUp;
+      const auto readEnd = std::min(end + warmUp, numSamples);
+
+      const auto inLen = (readEnd - readStart).as_size_t();
+      Floats input{ inLen };
+      if (!sequence.Get((samplePtr)input.get(), floatSample,
+            readStart, inLen, true))
+         throw SimpleMessageBoxException{
+            XO("Resampling failed."),
+            XO("Warning"),
+            "Error:_Resampling"
+         };
+
+      ::Resample resample(true, factor, factor); // constant rate resampling
+      const size_t bufsize = 65536;
+      Floats outBuffer{ bufsize };
+      output.clear();
+      output.reserve(size_t(inLen * factor) + bufsize);
+      size_t pos = 0, outGenerated = 0;
+      while (pos < inLen || outGenerated > 0) {
+         const auto len = std::min(bufsize, inLen - pos);
+         const auto results = resample.Process(factor, input.get() + pos,
+            len, pos + len == inLen, outBuffer.get(), bufsize);
+         pos += results.first;
+         outGenerated = results.second;
+         output.insert(output.end(),
+            outBuffer.get(), outBuffer.get() + outGenerated);
+      }
+
+      // Keep only the output for [start, end), or to the end of all output
+      // for the last segment
+      const auto skip =
+         std::min(output.size(), (start - readStart).as_size_t() / period * outPeriod);
+      output.erase(output.begin(), output.begin() + skip);
+      if (end < numSamples)
+         output.resize(std::min(output.size(),
+            (end - start).as_size_t() / period * outPeriod));
+
+      done += (end - start).as_long_long();
+   };
+
+   // Process a few segments for each thread at a time, to bound the memory
+   const size_t batchSize = 2 * (pool.GetThreadCount() + 1);
+   for (size_t first = 0; first < nSegments; first += batchSize) {
+      const auto count = std::min(batchSize, nSegments - first);
+      outputs.resize(count);
+      const auto task = [&](size_t ii){
+         resampleSegment(first + ii, outputs[ii]);
+      };
+      if (progress) {
+         if (!pool.ParallelFor(count, task, [&]{
+               return progress->Update(
+                  done.load(), numSamples.as_long_long() ) ==
+                     ProgressResult::Success; }))
+            throw UserException{};
+      }
+      else
+         pool.ParallelFor(count, task);
+
+      // Make the new blocks in order, in this thread
+      for (auto &output : outputs)
+         newSequence.Append(
+            (samplePtr)output.data(), floatSample, output.size());
+   }
+
+   return true;
 }
 
 /*! @excsafety{Strong} */
@@ -1693,12 +1828,16 @@ void WaveClip::Resample(int rate, ProgressDialog *progress)
    auto newSequence =
       std::make_unique<Sequence>(mSequence->GetFactory(), mSequence->GetSampleFormat());
 
+   // Long clips are resampled on all cores
+   const bool segmented =
+      ResampleInSegments(*mSequence, *newSequence, mRate, rate, progress);
+
    /**
     * We want to keep going as long as we have something to feed the resampler
     * with OR as long as the resampler spews out samples (which could continue
     * for a few iterations after we stop feeding it)
     */
-   while (pos < numSamples || outGenerated > 0)
+   while (!segmented && (pos < numSamples || outGenerated > 0))
    {
       const auto inLen = limitSampleBufferSize( bufsize, numSamples - pos );
 
@@ -1754,6 +1893,7 @@ void WaveClip::Resample(int rate, ProgressDialog *progress)
 
       mSequence = std::move(newSequence);
       mRate = rate;
+      LayoutChanged();
    }
 }
 
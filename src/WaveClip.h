@@ -19,6 +19,7 @@
 
 #include <wx/longlong.h>
 
+#include <atomic>
 #include <vector>
 #include <functional>
 
@@ -197,6 +198,10 @@ public:
 
    virtual ~WaveClip();
 
+   //! Whether a copy of this (including cutlines) could share the other,
+   //! which has the same contents, instead
+   bool HasSameContents(const WaveClip &other) const;
+
    void ConvertToSampleFormat(sampleFormat format,
       const std::function<void(size_t)> & progressReport = {});
 
@@ -257,6 +262,19 @@ public:
    void MarkChanged()
       { mDirty++; }
 
+   //! A number, kept by the track that holds clips, that changes whenever
+   //! the offset, rate, or length of one of them may have changed, or a
+   //! clip was added or removed
+   /*! The track compares it to decide whether the index of its clips is
+    stale */
+   using LayoutGeneration = std::atomic<unsigned long>;
+   //! The track that holds this clip gives its number; null for none
+   void SetLayoutGeneration(std::shared_ptr<LayoutGeneration> pGeneration)
+      { mpLayoutGeneration = std::move(pGeneration); }
+   /*! @excsafety{No-fail} */
+   void LayoutChanged()
+      { if (mpLayoutGeneration) ++*mpLayoutGeneration; }
+
    /** Getting high-level data for screen display and clipping
     * calculations and Contrast */
    bool GetWaveDisplay(WaveDisplay &display,
@@ -275,9 +293,10 @@ public:
     * function to tell the envelope about it. */
    void UpdateEnvelopeTrackLen();
 
-   //! For use in importing pre-version-3 projects to preserve sharing of blocks
+   //! For use in importing pre-version-3 projects to preserve sharing of
+   //! blocks, and in importing whole blocks of uncompressed files
    std::shared_ptr<SampleBlock> AppendNewBlock(
-      samplePtr buffer, sampleFormat format, size_t len);
+      constSamplePtr buffer, sampleFormat format, size_t len);
 
    //! For use in importing pre-version-3 projects to preserve sharing of blocks
    void AppendSharedBlock(const std::shared_ptr<SampleBlock> &pBlock);
@@ -359,6 +378,9 @@ public:
 
 protected:
    double mOffset { 0 };
+
+   // Not copied with the clip; shared, in case the clip outlives the track
+   std::shared_ptr<LayoutGeneration> mpLayoutGeneration;
    int mRate;
    int mDirty { 0 };
    int mColourIndex;
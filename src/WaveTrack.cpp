@@ -39,6 +39,7 @@ from the project that will own the track.
 #include <float.h>
 #include <math.h>
 #include <algorithm>
+#include <map>
 
 #include "float_cast.h"
 
@@ -133,9 +134,60 @@ WaveTrack::WaveTrack(const WaveTrack &orig):
 
    Init(orig);
 
-   for (const auto &clip : orig.mClips)
+   for (const auto &clip : orig.mClips) {
       mClips.push_back
          ( std::make_unique<WaveClip>( *clip, mpFactory, true ) );
+      LayoutChanged( mClips.back().get() );
+   }
+}
+
+WaveTrack::WaveTrack(const WaveTrack &orig, const WaveTrack &previous):
+   PlayableTrack(orig)
+   , mpFactory( orig.mpFactory )
+   , mpSpectrumSettings(orig.mpSpectrumSettings
+      ? std::make_unique<SpectrogramSettings>(*orig.mpSpectrumSettings)
+      : nullptr
+   )
+   , mpWaveformSettings(orig.mpWaveformSettings 
+      ? std::make_unique<WaveformSettings>(*orig.mpWaveformSettings)
+      : nullptr
+   )
+{
+   mLastScaleType = -1;
+   mLastdBRange = -1;
+
+   mLegacyProjectFileOffset = 0;
+
+   Init(orig);
+
+   // Usually an edit changes few clips and leaves the others in place;
+   // otherwise look the clip up by its offset
+   const auto &prevClips = previous.mClips;
+   std::multimap< double, const WaveClipHolder* > byOffset;
+   auto findSame = [&]( size_t ii ) -> WaveClipHolder {
+      const auto &clip = *orig.mClips[ii];
+      if (ii < prevClips.size() && clip.HasSameContents( *prevClips[ii] ))
+         return prevClips[ii];
+      if (byOffset.empty())
+         for (const auto &prevClip : prevClips)
+            byOffset.emplace( prevClip->GetOffset(), &prevClip );
+      auto range = byOffset.equal_range( clip.GetOffset() );
+      for (auto iter = range.first; iter != range.second; ++iter)
+         if (clip.HasSameContents( **iter->second ))
+            return *iter->second;
+      return {};
+   };
+
+   for (size_t ii = 0, nClips = orig.mClips.size(); ii < nClips; ++ii) {
+      // Shared clips never change, so they need not bump this track's count
+      auto pClip = findSame( ii );
+      const bool made = !pClip;
+      if (made)
+         pClip = std::make_unique<WaveClip>( *orig.mClips[ii], mpFactory, true );
+      mClips.push_back( std::move( pClip ) );
+      if (made)
+         LayoutChanged( mClips.back().get() );
+   }
 }
 
 // Copy the track metadata but not the contents.
@@ -357,6 +409,13 @@ Track::Holder WaveTrack::Clone() const
    return std::make_shared<WaveTrack>( *this );
 }
 
+Track::Holder WaveTrack::SharingClone(const Track *pPrevious) const
+{
+   if (auto pWaveTrack = dynamic_cast<const WaveTrack*>( pPrevious ))
+      return std::make_shared<WaveTrack>( *this, *pWaveTrack );
+   return Clone();
+}
+
 double WaveTrack::GetRate() const
 {
    return mRate;
@@ -602,6 +661,7 @@ Track::Holder WaveTrack::Copy(double t0, double t1, bool forClipboard) const
          newTrack->mClips.push_back
             (std::make_unique<WaveClip>(*clip, mpFactory, ! forClipboard));
          WaveClip *const newClip = newTrack->mClips.back().get();
+         newTrack->LayoutChanged(newClip);
          newClip->Offset(-t0);
       }
       else if (t1 > clip->GetStartTime() && t0 < clip->GetEndTime())
@@ -622,6 +682,7 @@ Track::Holder WaveTrack::Copy(double t0, double t1, bool forClipboard) const
             newClip->SetOffset(0);
 
          newTrack->mClips.push_back(std::move(newClip)); // transfer ownership
+         newTrack->LayoutChanged(newTrack->mClips.back().get());
       }
    }
 
@@ -640,6 +701,7 @@ Track::Holder WaveTrack::Copy(double t0, double t1, bool forClipboard) const
       placeholder->InsertSilence(0, (t1 - t0) - newTrack->GetEndTime());
       placeholder->Offset(newTrack->GetEndTime());
       newTrack->mClips.push_back(std::move(placeholder)); // transfer ownership
+      newTrack->LayoutChanged(newTrack->mClips.back().get());
    }
 
    return result;
@@ -972,6 +1034,9 @@ std::shared_ptr<WaveClip> WaveTrack::RemoveAndReturnClip(WaveClip* clip)
    if (it != mClips.end()) {
       auto result = std::move(*it); // Array stops owning the clip, before we shrink it
       mClips.erase(it);
+      LayoutChanged();
+      // The clip no longer changes the layout of this track
+      result->SetLayoutGeneration(nullptr);
       return result;
    }
    else
@@ -986,6 +1051,7 @@ bool WaveTrack::AddClip(const std::shared_ptr<WaveClip> &clip)
    // Uncomment the following line after we correct the problem of zero-length clips
    //if (CanInsertClip(clip))
       mClips.push_back(clip); // transfer ownership
+   LayoutChanged(clip.get());
 
    return true;
 }
@@ -1123,8 +1189,12 @@ void WaveTrack::HandleClear(double t0, double t1,
          wxASSERT(false);
    }
 
-   for (auto &clip: clipsToAdd)
+   for (auto &clip: clipsToAdd) {
       mClips.push_back(std::move(clip)); // transfer ownership
+      LayoutChanged(mClips.back().get());
+   }
+
+   LayoutChanged();
 }
 
 void WaveTrack::SyncLockAdjust(double oldT1, double newT1)
@@ -1319,6 +1389,7 @@ void WaveTrack::Paste(double t0, const Track *src)
             newClip->Offset(t0);
             newClip->MarkChanged();
             mClips.push_back(std::move(newClip)); // transfer ownership
+            LayoutChanged(mClips.back().get());
          }
       }
       return true;
@@ -1380,6 +1451,7 @@ void WaveTrack::InsertSilence(double t, double len)
       clip->InsertSilence(0, len);
       // use No-fail-guarantee
       mClips.push_back( std::move( clip ) );
+      LayoutChanged(mClips.back().get());
       return;
    }
    else {
@@ -1532,6 +1604,7 @@ void WaveTrack::Join(double t0, double t1)
 
       auto it = FindClip(mClips, clip);
       mClips.erase(it); // deletes the clip
+      LayoutChanged();
    }
 }
 
@@ -1727,6 +1800,14 @@ XMLTagHandler *WaveTrack::HandleXMLChild(const wxChar *tag)
 
 void WaveTrack::WriteXML(XMLWriter &xmlFile) const
 // may throw
+{
+   WriteXML( xmlFile, []( XMLWriter &xmlFile, const WaveClip &clip ){
+      clip.WriteXML( xmlFile );
+   } );
+}
+
+void WaveTrack::WriteXML(XMLWriter &xmlFile, const ClipWriter &writeClip) const
+// may throw
 {
    xmlFile.StartTag(wxT("wavetrack"));
    this->Track::WriteCommonXMLAttributes( xmlFile );
@@ -1741,7 +1822,7 @@ void WaveTrack::WriteXML(XMLWriter &xmlFile) const
 
    for (const auto &clip : mClips)
    {
-      clip->WriteXML(xmlFile);
+      writeClip(xmlFile, *clip);
    }
 
    xmlFile.EndTag(wxT("wavetrack"));
@@ -1774,44 +1855,116 @@ double WaveTrack::LongSamplesToTime(sampleCount pos) const
    return pos.as_double() / mRate;
 }
 
-double WaveTrack::GetStartTime() const
+struct WaveTrack::ClipIndex
 {
-   bool found = false;
-   double best = 0.0;
+   unsigned long generation;
+   int rate;
+   // Whether all clips have the track's rate, so that sample positions of
+   // the track and of the clips agree
+   bool uniformRate{ true };
 
-   if (mClips.empty())
-      return 0;
+   // Sorted by start time; ties keep the order of mClips
+   std::vector<WaveClip*> clips;
+   std::vector<double> starts;
+   std::vector<double> ends;
+   // Running maximum of ends, which is nondecreasing, though ends may not be
+   std::vector<double> maxEnds;
 
-   for (const auto &clip : mClips)
-      if (!found)
-      {
-         found = true;
-         best = clip->GetStartTime();
+   //! Call visit for each clip whose closed interval of time might meet
+   //! [t0, t1], in order of start time, until visit returns false
+   /*! There are no false negatives; visit must test each clip exactly */
+   template< typename Visit >
+   void VisitTimes(double t0, double t1, const Visit &visit) const
+   {
+      const auto hi = std::upper_bound(starts.begin(), starts.end(), t1)
+         - starts.begin();
+      const auto lo = std::lower_bound(maxEnds.begin(), maxEnds.end(), t0)
+         - maxEnds.begin();
+      for (auto ii = lo; ii < hi; ++ii)
+         if (ends[ii] >= t0 && !visit(clips[ii]))
+            break;
+   }
+
+   //! Like VisitTimes, for clips whose samples might meet [s0, s1)
+   template< typename Visit >
+   void VisitSamples(sampleCount s0, sampleCount s1, const Visit &visit) const
+   {
+      if (!uniformRate) {
+         for (auto pClip : clips)
+            if (!visit(pClip))
+               break;
+         return;
       }
-      else if (clip->GetStartTime() < best)
-         best = clip->GetStartTime();
+      // Sample positions of a clip are its times rounded, so widen by a
+      // sample
+      const auto margin = 1.0 / rate;
+      VisitTimes(s0.as_double() / rate - margin,
+         s1.as_double() / rate + margin, visit);
+   }
+};
 
-   return best;
+void WaveTrack::LayoutChanged(WaveClip *pAddedClip)
+{
+   ++*mpLayoutGeneration;
+   if (pAddedClip)
+      pAddedClip->SetLayoutGeneration(mpLayoutGeneration);
 }
 
-double WaveTrack::GetEndTime() const
+auto WaveTrack::GetClipIndex() const -> std::shared_ptr<const ClipIndex>
 {
-   bool found = false;
-   double best = 0.0;
+   // Fetch the generation first, so that changes during the rebuild will
+   // cause another
+   const auto generation = mpLayoutGeneration->load();
+
+   std::lock_guard<std::mutex> lock{ mClipIndexMutex };
+   if (mpClipIndex &&
+       mpClipIndex->generation == generation && mpClipIndex->rate == mRate)
+      return mpClipIndex;
+
+   auto pIndex = std::make_shared<ClipIndex>();
+   auto &index = *pIndex;
+   index.generation = generation;
+   index.rate = mRate;
 
+   const auto nClips = mClips.size();
+   index.clips.reserve(nClips);
+   for (const auto &clip : mClips)
+      index.clips.push_back(clip.get());
+   std::stable_sort(index.clips.begin(), index.clips.end(),
+      [](const WaveClip *a, const WaveClip *b)
+   { return a->GetStartTime() < b->GetStartTime(); });
+
+   index.starts.reserve(nClips);
+   index.ends.reserve(nClips);
+   index.maxEnds.reserve(nClips);
+   for (auto pClip : index.clips) {
+      const auto end = pClip->GetEndTime();
+      index.starts.push_back(pClip->GetStartTime());
+      index.ends.push_back(end);
+      index.maxEnds.push_back(
+         index.maxEnds.empty() ? end : std::max(index.maxEnds.back(), end));
+      if (pClip->GetRate() != mRate)
+         index.uniformRate = false;
+   }
+
+   mpClipIndex = pIndex;
+   return pIndex;
+}
+
+double WaveTrack::GetStartTime() const
+{
    if (mClips.empty())
       return 0;
 
-   for (const auto &clip : mClips)
-      if (!found)
-      {
-         found = true;
-         best = clip->GetEndTime();
-      }
-      else if (clip->GetEndTime() > best)
-         best = clip->GetEndTime();
+   return GetClipIndex()->starts.front();
+}
 
-   return best;
+double WaveTrack::GetEndTime() const
+{
+   if (mClips.empty())
+      return 0;
+
+   return GetClipIndex()->maxEnds.back();
 }
 
 //
@@ -1837,7 +1990,7 @@ std::pair<float, float> WaveTrack::GetMinMax(
    if (t0 == t1)
       return results;
 
-   for (const auto &clip: mClips)
+   GetClipIndex()->VisitTimes(t0, t1, [&](const WaveClip *clip)
    {
       if (t1 >= clip->GetStartTime() && t0 <= clip->GetEndTime())
       {
@@ -1848,7 +2001,8 @@ std::pair<float, float> WaveTrack::GetMinMax(
          if (clipResults.second > results.second)
             results.second = clipResults.second;
       }
-   }
+      return true;
+   });
 
    if(!clipFound)
    {
@@ -1872,7 +2026,7 @@ float WaveTrack::GetRMS(double t0, double t1, bool mayThrow) const
    double sumsq = 0.0;
    sampleCount length = 0;
 
-   for (const auto &clip: mClips)
+   GetClipIndex()->VisitTimes(t0, t1, [&](const WaveClip *clip)
    {
       // If t1 == clip->GetStartTime() or t0 == clip->GetEndTime(), then the clip
       // is not inside the selection, so we don't want it.
@@ -1888,7 +2042,8 @@ float WaveTrack::GetRMS(double t0, double t1, bool mayThrow) const
          sumsq += cliprms * cliprms * (clipEnd - clipStart).as_float();
          length += (clipEnd - clipStart);
       }
-   }
+      return true;
+   });
    return length > 0 ? sqrt(sumsq / length.as_double()) : 0.0;
 }
 
@@ -1902,14 +2057,16 @@ bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
    bool doClear = true;
    bool result = true;
    sampleCount samplesCopied = 0;
-   for (const auto &clip: mClips)
+   const auto pIndex = GetClipIndex();
+   pIndex->VisitSamples(start, start + len, [&](const WaveClip *clip)
    {
       if (start >= clip->GetStartSample() && start+len <= clip->GetEndSample())
       {
          doClear = false;
-         break;
+         return false;
       }
-   }
+      return true;
+   });
    if (doClear)
    {
       // Usually we fill in empty space with zero
@@ -1929,8 +2086,8 @@ bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
       }
    }
 
-   // Iterate the clips.  They are not necessarily sorted by time.
-   for (const auto &clip: mClips)
+   // Visit only the clips near the region, in order of time
+   pIndex->VisitSamples(start, start + len, [&](const WaveClip *clip)
    {
       auto clipStart = clip->GetStartSample();
       auto clipEnd = clip->GetEndSample();
@@ -1968,7 +2125,8 @@ bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
          else
             samplesCopied += samplesToCopy;
       }
-   }
+      return true;
+   });
    if( pNumWithinClips )
       *pNumWithinClips = samplesCopied;
    return result;
@@ -1978,7 +2136,7 @@ bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
 void WaveTrack::Set(constSamplePtr buffer, sampleFormat format,
                     sampleCount start, size_t len)
 {
-   for (const auto &clip: mClips)
+   GetClipIndex()->VisitSamples(start, start + len, [&](WaveClip *clip)
    {
       auto clipStart = clip->GetStartSample();
       auto clipEnd = clip->GetEndSample();
@@ -2014,10 +2172,11 @@ void WaveTrack::Set(constSamplePtr buffer, sampleFormat format,
                           format, inclipDelta, samplesToCopy.as_size_t() );
          clip->MarkChanged();
       }
-   }
+      return true;
+   });
 }
 
-void WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
+bool WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
                                   double t0) const
 {
    // The output buffer corresponds to an unbroken span of time which the callers expect
@@ -2027,18 +2186,16 @@ void WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
    // to initialize the entire buffer to a default value.
    //
    // This does mean that, in the cases where a usable clip is located, the buffer value will
-   // be set twice.  Unfortunately, there is no easy way around this since the clips are not
-   // stored in increasing time order.  If they were, we could just track the time as the
-   // buffer is filled.
-   for (decltype(bufferLen) i = 0; i < bufferLen; i++)
-   {
-      buffer[i] = 1.0;
-   }
+   // be set twice.
+   std::fill(buffer, buffer + bufferLen, 1.0);
+
+   // Whether any value was set other than 1
+   bool result = false;
 
    double startTime = t0;
    auto tstep = 1.0 / mRate;
    double endTime = t0 + tstep * bufferLen;
-   for (const auto &clip: mClips)
+   GetClipIndex()->VisitTimes(startTime, endTime, [&](const WaveClip *clip)
    {
       // IF clip intersects startTime..endTime THEN...
       auto dClipStartTime = clip->GetStartTime();
@@ -2066,7 +2223,7 @@ void WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
             auto nClipLen = clip->GetEndSample() - clip->GetStartSample();
 
             if (nClipLen <= 0) // Testing for bug 641, this problem is consistently '== 0', but doesn't hurt to check <.
-               return;
+               return false;
 
             // This check prevents problem cited in http://bugzilla.audacityteam.org/show_bug.cgi?id=528#c11,
             // Gale's cross_fade_out project, which was already corrupted by bug 528.
@@ -2076,48 +2233,74 @@ void WaveTrack::GetEnvelopeValues(double *buffer, size_t bufferLen,
             rlen = limitSampleBufferSize( rlen, nClipLen );
             rlen = std::min(rlen, size_t(floor(0.5 + (dClipEndTime - rt0) / tstep)));
          }
+         // The usual envelope without points leaves the ones in place
+         double value;
+         const auto envelope = clip->GetEnvelope();
+         if (envelope->IsConstant(&value) && value == 1.0)
+            return true;
+
          // Samples are obtained for the purpose of rendering a wave track,
          // so quantize time
-         clip->GetEnvelope()->GetValues(rbuf, rlen, rt0, tstep);
+         envelope->GetValues(rbuf, rlen, rt0, tstep);
+         result = true;
       }
-   }
+      return true;
+   });
+
+   return result;
 }
 
 WaveClip* WaveTrack::GetClipAtSample(sampleCount sample)
 {
-   for (const auto &clip: mClips)
+   WaveClip *result = NULL;
+   GetClipIndex()->VisitSamples(sample, sample + 1, [&](WaveClip *clip)
    {
       auto start = clip->GetStartSample();
       auto len   = clip->GetNumSamples();
 
       if (sample >= start && sample < start + len)
-         return clip.get();
-   }
+      {
+         result = clip;
+         return false;
+      }
+      return true;
+   });
 
-   return NULL;
+   return result;
 }
 
 // When the time is both the end of a clip and the start of the next clip, the
 // latter clip is returned.
 WaveClip* WaveTrack::GetClipAtTime(double time)
 {
-   
-   const auto clips = SortedClipArray();
-   auto p = std::find_if(clips.rbegin(), clips.rend(), [&] (WaveClip* const& clip) {
-      return time >= clip->GetStartTime() && time <= clip->GetEndTime(); });
+   const auto pIndex = GetClipIndex();
+   const auto &index = *pIndex;
+
+   // Find the last clip in order of start time that contains the time,
+   // searching back from the last that starts at or before it, until no
+   // earlier clip can reach it
+   auto ii = std::upper_bound(index.starts.begin(), index.starts.end(), time)
+      - index.starts.begin();
+   while (ii > 0 && index.maxEnds[ii - 1] >= time &&
+      index.ends[ii - 1] < time)
+      --ii;
+   if (ii == 0 || index.maxEnds[ii - 1] < time)
+      return nullptr;
+   --ii;
 
    // When two clips are immediately next to each other, the GetEndTime() of the first clip
    // and the GetStartTime() of the second clip may not be exactly equal due to rounding errors.
    // If "time" is the end time of the first of two such clips, and the end time is slightly
    // less than the start time of the second clip, then the first rather than the
    // second clip is found by the above code. So correct this.
-   if (p != clips.rend() && p != clips.rbegin() &&
-      time == (*p)->GetEndTime() &&
-      (*p)->SharesBoundaryWithNextClip(*(p-1))) {
-      p--;
+   const auto &clips = index.clips;
+   if (ii + 1 < (ptrdiff_t)clips.size() &&
+      time == index.ends[ii] &&
+      clips[ii]->SharesBoundaryWithNextClip(clips[ii + 1])) {
+      ++ii;
    }
 
-   return p != clips.rend() ? *p : nullptr;
+   return clips[ii];
 }
 
 Envelope* WaveTrack::GetEnvelopeAtTime(double time)
@@ -2141,6 +2324,7 @@ Sequence* WaveTrack::GetSequenceAtTime(double time)
 WaveClip* WaveTrack::CreateClip()
 {
    mClips.push_back(std::make_unique<WaveClip>(mpFactory, mFormat, mRate, GetWaveColorIndex()));
+   LayoutChanged(mClips.back().get());
    return mClips.back().get();
 }
 
@@ -2322,6 +2506,7 @@ void WaveTrack::SplitAt(double t)
          // This could invalidate the iterators for the loop!  But we return
          // at once so it's okay
          mClips.push_back(std::move(newClip)); // transfer ownership
+         LayoutChanged(mClips.back().get());
          return;
       }
    }
@@ -2473,6 +2658,7 @@ void WaveTrack::MergeClips(int clipidx1, int clipidx2)
    // Delete second clip
    auto it = FindClip(mClips, clip2);
    mClips.erase(it);
+   LayoutChanged();
 }
 
 /*! @excsafety{Weak} -- Partial completion may leave clips at differing sample rates!
@@ -2485,28 +2671,15 @@ void WaveTrack::Resample(int rate, ProgressDialog *progress)
    mRate = rate;
 }
 
-namespace {
-   template < typename Cont1, typename Cont2 >
-   Cont1 FillSortedClipArray(const Cont2& mClips)
-   {
-      Cont1 clips;
-      for (const auto &clip : mClips)
-         clips.push_back(clip.get());
-      std::sort(clips.begin(), clips.end(),
-         [](const WaveClip *a, const WaveClip *b)
-      { return a->GetStartTime() < b->GetStartTime(); });
-      return clips;
-   }
-}
-
 WaveClipPointers WaveTrack::SortedClipArray()
 {
-   return FillSortedClipArray<WaveClipPointers>(mClips);
+   return GetClipIndex()->clips;
 }
 
 WaveClipConstPointers WaveTrack::SortedClipArray() const
 {
-   return FillSortedClipArray<WaveClipConstPointers>(mClips);
+   const auto pIndex = GetClipIndex();
+   return { pIndex->clips.begin(), pIndex->clips.end() };
 }
 
 ///Deletes all clips' wavecaches.  Careful, This may not be threadsafe.
@@ -13,8 +13,11 @@
 
 #include "Track.h"
 
+#include <atomic>
 #include <vector>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <wx/longlong.h>
 
 #include "WaveTrackLocation.h"
@@ -75,6 +78,8 @@ public:
    WaveTrack(
       const SampleBlockFactoryPtr &pFactory, sampleFormat format, double rate);
    WaveTrack(const WaveTrack &orig);
+   // Copy, but share the clips of previous that are the same as this track's
+   WaveTrack(const WaveTrack &orig, const WaveTrack &previous);
 
    // overwrite data excluding the sample sequence but including display
    // settings
@@ -84,6 +89,7 @@ private:
    void Init(const WaveTrack &orig);
 
    Track::Holder Clone() const override;
+   Track::Holder SharingClone(const Track *pPrevious) const override;
 
    friend class WaveTrackFactory;
 
@@ -259,7 +265,9 @@ private:
 
    // Fetch envelope values corresponding to uniformly separated sample times
    // starting at the given time.
-   void GetEnvelopeValues(double *buffer, size_t bufferLen,
+   // Returns false if all the values are 1, so that applying them can be
+   // skipped.
+   bool GetEnvelopeValues(double *buffer, size_t bufferLen,
                          double t0) const;
 
    // May assume precondition: t0 <= t1
@@ -302,6 +310,11 @@ private:
    XMLTagHandler *HandleXMLChild(const wxChar *tag) override;
    void WriteXML(XMLWriter &xmlFile) const override;
 
+   using ClipWriter =
+      std::function< void(XMLWriter &xmlFile, const WaveClip &clip) >;
+   //! Like WriteXML(), but writeClip writes each clip, or something in its place
+   void WriteXML(XMLWriter &xmlFile, const ClipWriter &writeClip) const;
+
    // Returns true if an error occurred while reading from XML
    bool GetErrorOpening() override;
 
@@ -336,6 +349,7 @@ private:
 
    // Get access to the (visible) clips in the tracks, in unspecified order
    // (not necessarily sequenced in time).
+   //! WaveTrack, when it adds or removes clips, must call LayoutChanged()
    WaveClipHolders &GetClips() { return mClips; }
    const WaveClipConstHolders &GetClips() const
       { return reinterpret_cast< const WaveClipConstHolders& >( mClips ); }
@@ -590,6 +604,20 @@ private:
 
    std::unique_ptr<SpectrogramSettings> mpSpectrumSettings;
    std::unique_ptr<WaveformSettings> mpWaveformSettings;
+
+   //! The clips sorted by time, so that those meeting an interval are found
+   //! by binary search; rebuilt on demand when the layout has changed
+   struct ClipIndex;
+   std::shared_ptr<const ClipIndex> GetClipIndex() const;
+   //! Count a change to the set of clips; an added clip is also given the
+   //! count, to bump when its own offset, rate, or length changes
+   void LayoutChanged(WaveClip *pAddedClip = nullptr);
+   // The same type as WaveClip::LayoutGeneration
+   std::shared_ptr< std::atomic<unsigned long> > mpLayoutGeneration{
+      std::make_shared< std::atomic<unsigned long> >(0) };
+   // Readers in different threads may rebuild it
+   mutable std::mutex mClipIndexMutex;
+   mutable std::shared_ptr<const ClipIndex> mpClipIndex;
 };
 
 // This is meant to be a short-lived object, during whose lifetime,
@@ -132,6 +132,27 @@ size_t EffectAmplify::ProcessBlock(float **inBlock, float **outBlock, size_t blo
 
    return blockLen;
 }
+
+bool EffectAmplify::RealtimeInitialize()
+{
+   SetBlockSize(512);
+
+   return true;
+}
+
+size_t EffectAmplify::RealtimeProcess(int WXUNUSED(group),
+                                      float **inbuf,
+                                      float **outbuf,
+                                      size_t numSamples)
+{
+   // No state, so all processors are the same
+   return ProcessBlock(inbuf, outbuf, numSamples);
+}
+
+bool EffectAmplify::SupportsParallelProcessing()
+{
+   return true;
+}
 bool EffectAmplify::DefineParams( ShuttleParams & S ){
    S.SHUTTLE_PARAM( mRatio, Ratio );
    if (!IsBatchProcessing())
@@ -46,6 +46,9 @@ public:
    unsigned GetAudioInCount() override;
    unsigned GetAudioOutCount() override;
    size_t ProcessBlock(float **inBlock, float **outBlock, size_t blockLen) override;
+   bool RealtimeInitialize() override;
+   size_t RealtimeProcess(int group, float **inbuf, float **outbuf, size_t numSamples) override;
+   bool SupportsParallelProcessing() override;
    bool DefineParams( ShuttleParams & S ) override;
    bool GetAutomationParameters(CommandParameters & parms) override;
    bool SetAutomationParameters(CommandParameters & parms) override;
@@ -65,6 +65,7 @@ public:
                                float **inbuf,
                                float **outbuf,
                                size_t numSamples) override;
+   bool SupportsParallelProcessing() override;
    bool DefineParams( ShuttleParams & S ) override;
    bool GetAutomationParameters(CommandParameters & parms) override;
    bool SetAutomationParameters(CommandParameters & parms) override;
@@ -37,6 +37,7 @@
 #include "../ProjectSettings.h"
 #include "../ShuttleGui.h"
 #include "../Shuttle.h"
+#include "../ThreadPool.h"
 #include "../ViewInfo.h"
 #include "../WaveTrack.h"
 #include "../wxFileNameWrapper.h"
@@ -479,6 +480,16 @@ bool Effect::RealtimeProcessEnd()
    return true;
 }
 
+bool Effect::SupportsParallelProcessing()
+{
+   if (mClient)
+   {
+      return mClient->SupportsParallelProcessing();
+   }
+
+   return false;
+}
+
 bool Effect::ShowInterface(wxWindow &parent,
    const EffectDialogFactory &factory, bool forceModal)
 {
@@ -1411,6 +1422,11 @@ bool Effect::ProcessPass()
    int count = 0;
    bool clear = false;
 
+   // Groups of channels to be processed all at once, if the effect allows
+   const bool parallel =
+      GetType() == EffectTypeProcess && SupportsParallelProcessing();
+   std::vector<ChannelGroup> groups;
+
    const bool multichannel = mNumAudioIn > 1;
    auto range = multichannel
       ? mOutputTracks->Leaders()
@@ -1461,6 +1477,12 @@ bool Effect::ProcessPass()
          else
             mSampleCnt = left->TimeToLongSamples(mDuration);
 
+         if (parallel)
+         {
+            groups.push_back( { left, right, mNumChannels, start, len } );
+            return;
+         }
+
          // Let the client know the sample rate
          SetSampleRate(left->GetRate());
 
@@ -1535,6 +1557,11 @@ bool Effect::ProcessPass()
       }
    );
 
+   if (bGoodResult && parallel)
+   {
+      bGoodResult = ProcessGroupsInParallel(groups);
+   }
+
    if (bGoodResult && GetType() == EffectTypeGenerate)
    {
       mT1 = mT0 + mDuration;
@@ -1543,6 +1570,110 @@ bool Effect::ProcessPass()
    return bGoodResult;
 }
 
+// Samples per channel in each round of ProcessGroupsInParallel(), which
+// bounds the memory used for the buffers of all of the groups
+static const size_t ParallelBufferSize = 65536;
+
+bool Effect::ProcessGroupsInParallel(const std::vector<ChannelGroup> &groups)
+{
+   const auto nGroups = groups.size();
+
+   // Make one processor per group, as for realtime processing of the tracks.
+   // The processors take the place of the one that ProcessInitialize() and
+   // ProcessFinalize() prepare and clean up, so those are not called.
+   RealtimeInitialize();
+   auto cleanup = finally( [&] { RealtimeFinalize(); } );
+   for (const auto &group : groups)
+      RealtimeAddProcessor(group.nChannels, group.left->GetRate());
+
+   const auto blockSize = std::max<size_t>(1, GetBlockSize());
+   const auto bufferSize =
+      std::max(blockSize, (ParallelBufferSize / blockSize) * blockSize);
+
+   // Unused input buffers stay cleared
+   std::vector<FloatBuffers> inBuffers(nGroups), outBuffers(nGroups);
+   sampleCount maxLen = 0;
+   double total = 0;
+   for (size_t ii = 0; ii < nGroups; ++ii)
+   {
+      inBuffers[ii].reinit(mNumAudioIn, bufferSize, true);
+      outBuffers[ii].reinit(mNumAudioOut, bufferSize);
+      maxLen = std::max(maxLen, groups[ii].len);
+      total += groups[ii].len.as_double();
+   }
+
+   std::vector<size_t> counts(nGroups);
+   double processed = 0;
+   for (sampleCount done = 0; done < maxLen; done += bufferSize)
+   {
+      // Read the tracks in order in this thread.  Reads alone may share the
+      // database connection with other threads, but the writes below make
+      // new sample blocks, which are not safe to make from several threads
+      // at once, so all track I/O stays here
+      for (size_t ii = 0; ii < nGroups; ++ii)
+      {
+         const auto &group = groups[ii];
+         counts[ii] = group.len > done
+            ? limitSampleBufferSize(bufferSize, group.len - done)
+            : 0;
+         if (counts[ii] == 0)
+            continue;
+         group.left->Get((samplePtr) inBuffers[ii][0].get(),
+            floatSample, group.start + done, counts[ii]);
+         if (group.right)
+            group.right->Get((samplePtr) inBuffers[ii][1].get(),
+               floatSample, group.start + done, counts[ii]);
+      }
+
+      // Process the groups on all cores
+      try
+      {
+         ThreadPool::Get().ParallelFor(nGroups, [&](size_t ii) {
+            std::vector<float *> inBufPos(mNumAudioIn), outBufPos(mNumAudioOut);
+            for (size_t pos = 0; pos < counts[ii]; pos += blockSize)
+            {
+               for (size_t i = 0; i < mNumAudioIn; i++)
+                  inBufPos[i] = inBuffers[ii][i].get() + pos;
+               for (size_t i = 0; i < mNumAudioOut; i++)
+                  outBufPos[i] = outBuffers[ii][i].get() + pos;
+               RealtimeProcess(ii, inBufPos.data(), outBufPos.data(),
+                  std::min(blockSize, counts[ii] - pos));
+            }
+         } );
+      }
+      catch( const AudacityException & WXUNUSED(e) )
+      {
+         throw;
+      }
+      catch(...)
+      {
+         // As in ProcessTrack()
+         return false;
+      }
+
+      // Write the tracks in order in this thread
+      for (size_t ii = 0; ii < nGroups; ++ii)
+      {
+         if (counts[ii] == 0)
+            continue;
+         const auto &group = groups[ii];
+         const auto &outBuffer = outBuffers[ii];
+         const auto chans = std::min<unsigned>(mNumAudioOut, group.nChannels);
+         group.left->Set((samplePtr) outBuffer[0].get(),
+            floatSample, group.start + done, counts[ii]);
+         if (group.right)
+            group.right->Set((samplePtr) outBuffer[chans >= 2 ? 1 : 0].get(),
+               floatSample, group.start + done, counts[ii]);
+         processed += counts[ii];
+      }
+
+      if (TotalProgress(processed / total))
+         return false;
+   }
+
+   return true;
+}
+
 bool Effect::ProcessTrack(int count,
                           ChannelNames map,
                           WaveTrack *left,
@@ -141,6 +141,7 @@ class AUDACITY_DLL_API Effect /* not final */ : public wxEvtHandler,
                                        float **outbuf,
                                        size_t numSamples) override;
    bool RealtimeProcessEnd() override;
+   bool SupportsParallelProcessing() override;
 
    bool ShowInterface( wxWindow &parent,
       const EffectDialogFactory &factory, bool forceModal = false) override;
@@ -499,6 +500,19 @@ protected:
                      ArrayOf< float * > &inBufPos,
                      ArrayOf< float *> &outBufPos);
 
+   struct ChannelGroup {
+      WaveTrack *left;
+      WaveTrack *right;
+      unsigned nChannels;
+      sampleCount start;
+      sampleCount len;
+   };
+
+   // Driver for client effects that SupportsParallelProcessing(); reads
+   // and writes the tracks in order, but processes the groups in parallel,
+   // without ProcessInitialize() or ProcessFinalize()
+   bool ProcessGroupsInParallel(const std::vector<ChannelGroup> &groups);
+
  //
  // private data
  //
@@ -54,6 +54,7 @@
 
 #include "../Audacity.h"
 #include "Equalization.h"
+#include "FFTConvolver.h"
 #include "LoadEffects.h"
 
 #include "../Experimental.h"
@@ -243,9 +244,9 @@ BEGIN_EVENT_TABLE(EffectEqualization, wxEvtHandler)
 END_EVENT_TABLE()
 
 EffectEqualization::EffectEqualization(int Options)
-   : mFFTBuffer{ windowSize }
-   , mFilterFuncR{ windowSize }
+   : mFilterFuncR{ windowSize }
    , mFilterFuncI{ windowSize }
+   , mFilterTaps{ windowSize }
 {
    mOptions = Options;
    mGraphic = NULL;
@@ -1292,61 +1293,43 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
    auto output = t->EmptyCopy();
    t->ConvertToSampleFormat( floatSample );
 
-   wxASSERT(mM - 1 < windowSize);
-   size_t L = windowSize - (mM - 1);   //Process L samples at a go
-   auto s = start;
-   auto idealBlockLen = t->GetMaxBlockSize() * 4;
-   if (idealBlockLen % L != 0)
-      idealBlockLen += (L - (idealBlockLen % L));
-
-   Floats buffer{ idealBlockLen };
+   FFTConvolver convolver{ ConvolutionBlockSize, 1 };
+   convolver.SetFilter(mFilterTaps.get(), mM);
 
-   Floats window1{ windowSize };
-   Floats window2{ windowSize };
-   float *thisWindow = window1.get();
-   float *lastWindow = window2.get();
+   // The convolver delays its output by one block, which is dropped; feed
+   // it zeroes after the input, until the 'tail' of mM - 1 samples is out
+   size_t delay = convolver.GetBlockSize();
+   const auto total = len + (mM - 1) + delay;
 
-   auto originalLen = len;
-
-   for(size_t i = 0; i < windowSize; i++)
-      lastWindow[i] = 0;
+   auto idealBlockLen = t->GetMaxBlockSize() * 4;
+   Floats buffer{ idealBlockLen };
+   float *const channels[] = { buffer.get() };
 
    TrackProgress(count, 0.);
    bool bLoopSuccess = true;
-   size_t wcopy = 0;
    int offset = (mM - 1) / 2;
 
-   while (len != 0)
+   sampleCount done = 0;
+   while (done < total)
    {
-      auto block = limitSampleBufferSize( idealBlockLen, len );
-
-      t->Get((samplePtr)buffer.get(), floatSample, s, block);
-
-      for(size_t i = 0; i < block; i += L)   //go through block in lumps of length L
-      {
-         wcopy = std::min <size_t> (L, block - i);
-         for(size_t j = 0; j < wcopy; j++)
-            thisWindow[j] = buffer[i+j];   //copy the L (or remaining) samples
-         for(auto j = wcopy; j < windowSize; j++)
-            thisWindow[j] = 0;   //this includes the padding
+      auto block = limitSampleBufferSize( idealBlockLen, total - done );
 
-         Filter(windowSize, thisWindow);
+      const auto nInput = done < len
+         ? limitSampleBufferSize( block, len - done )
+         : 0;
+      if (nInput > 0)
+         t->Get((samplePtr)buffer.get(), floatSample, start + done, nInput);
+      std::fill(buffer.get() + nInput, buffer.get() + block, 0.0f);
 
-         // Overlap - Add
-         for(size_t j = 0; (j < mM - 1) && (j < wcopy); j++)
-            buffer[i+j] = thisWindow[j] + lastWindow[L + j];
-         for(size_t j = mM - 1; j < wcopy; j++)
-            buffer[i+j] = thisWindow[j];
+      convolver.Process(channels, channels, block);
 
-         std::swap( thisWindow, lastWindow );
-      }  //next i, lump of this block
+      const auto dropped = std::min(delay, block);
+      output->Append((samplePtr)(buffer.get() + dropped), floatSample,
+         block - dropped);
+      delay -= dropped;
+      done += block;
 
-      output->Append((samplePtr)buffer.get(), floatSample, block);
-      len -= block;
-      s += block;
-
-      if (TrackProgress(count, ( s - start ).as_double() /
-                        originalLen.as_double()))
+      if (TrackProgress(count, done.as_double() / total.as_double()))
       {
          bLoopSuccess = false;
          break;
@@ -1355,22 +1338,6 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
 
    if(bLoopSuccess)
    {
-      // mM-1 samples of 'tail' left in lastWindow, get them now
-      if(wcopy < (mM - 1)) {
-         // Still have some overlap left to process
-         // (note that lastWindow and thisWindow have been exchanged at this point
-         //  so that 'thisWindow' is really the window prior to 'lastWindow')
-         size_t j = 0;
-         for(; j < mM - 1 - wcopy; j++)
-            buffer[j] = lastWindow[wcopy + j] + thisWindow[L + wcopy + j];
-         // And fill in the remainder after the overlap
-         for( ; j < mM - 1; j++)
-            buffer[j] = lastWindow[wcopy + j];
-      } else {
-         for(size_t j = 0; j < mM - 1; j++)
-            buffer[j] = lastWindow[wcopy + j];
-      }
-      output->Append((samplePtr)buffer.get(), floatSample, mM - 1);
       output->Flush();
 
       std::vector<EnvPoint> envPoints;
@@ -1378,7 +1345,7 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
       // now move the appropriate bit of the output back to the track
       // (this could be enhanced in the future to use the tails)
       double offsetT0 = t->LongSamplesToTime(offset);
-      double lenT = t->LongSamplesToTime(originalLen);
+      double lenT = t->LongSamplesToTime(len);
       // 'start' is the sample offset in 't', the passed in track
       // 'startT' is the equivalent time value
       // 'output' starts at zero
@@ -1550,6 +1517,7 @@ bool EffectEqualization::CalcFilter()
    for (size_t i = 0; i < mM; i++)
    {   //and copy useful values back
       outr[i] = tempr[i];
+      mFilterTaps[i] = tempr[i];
    }
    for (size_t i = mM; i < mWindowSize; i++)
    {   //rest is padding
@@ -1562,31 +1530,6 @@ bool EffectEqualization::CalcFilter()
    return TRUE;
 }
 
-void EffectEqualization::Filter(size_t len, float *buffer)
-{
-   float re,im;
-   // Apply FFT
-   RealFFTf(buffer, hFFT.get());
-   //FFT(len, false, inr, NULL, outr, outi);
-
-   // Apply filter
-   // DC component is purely real
-   mFFTBuffer[0] = buffer[0] * mFilterFuncR[0];
-   for(size_t i = 1; i < (len / 2); i++)
-   {
-      re=buffer[hFFT->BitReversed[i]  ];
-      im=buffer[hFFT->BitReversed[i]+1];
-      mFFTBuffer[2*i  ] = re*mFilterFuncR[i] - im*mFilterFuncI[i];
-      mFFTBuffer[2*i+1] = re*mFilterFuncI[i] + im*mFilterFuncR[i];
-   }
-   // Fs/2 component is purely real
-   mFFTBuffer[1] = buffer[1] * mFilterFuncR[len/2];
-
-   // Inverse FFT and normalization
-   InverseRealFFTf(mFFTBuffer.get(), hFFT.get());
-   ReorderToTime(hFFT.get(), mFFTBuffer.get(), buffer);
-}
-
 //
 // Load external curves with fallback to default, then message
 //
@@ -143,6 +143,9 @@ private:
    // Number of samples in an FFT window
    static const size_t windowSize = 16384u; //MJS - work out the optimum for this at run time?  Have a dialog box for it?
 
+   // Partition length for the convolution of the filter with the tracks
+   static const size_t ConvolutionBlockSize = 4096u;
+
    // Low frequency of the FFT.  20Hz is the
    // low range of human hearing
    enum {loFreqI=20};
@@ -150,7 +153,6 @@ private:
    bool ProcessOne(int count, WaveTrack * t,
                    sampleCount start, sampleCount len);
    bool CalcFilter();
-   void Filter(size_t len, float *buffer);
    
    void Flatten();
    void ForceRecalc();
@@ -208,7 +210,9 @@ private:
 private:
    int mOptions;
    HFFT hFFT;
-   Floats mFFTBuffer, mFilterFuncR, mFilterFuncI;
+   Floats mFilterFuncR, mFilterFuncI;
+   // The mM coefficients of the filter, as computed by CalcFilter()
+   Floats mFilterTaps;
    size_t mM;
    wxString mCurveName;
    bool mLin;
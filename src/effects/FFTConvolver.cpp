@@ -0,0 +1,142 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FFTConvolver.cpp
+
+**********************************************************************/
+
+#include "FFTConvolver.h"
+
+#include <algorithm>
+
+FFTConvolver::FFTConvolver(size_t blockSize, size_t nChannels)
+   : mBlockSize{ blockSize }
+   , mFFTSize{ 2 * blockSize }
+   , hFFT{ GetFFT(2 * blockSize) }
+   , mChannels(nChannels)
+   , mScratch{ 2 * blockSize }
+   , mAccumulator{ 2 * blockSize }
+{
+   wxASSERT((blockSize & (blockSize - 1)) == 0);
+   for (auto &channel : mChannels) {
+      channel.input.reinit(mFFTSize, true);
+      channel.output.reinit(mBlockSize, true);
+   }
+   // Until there is a filter, the output is silent
+   float zero = 0;
+   SetFilter(&zero, 1);
+}
+
+FFTConvolver::~FFTConvolver()
+{
+}
+
+void FFTConvolver::Transform(float *spectrum)
+{
+   RealFFTf(mScratch.get(), hFFT.get());
+
+   // DC and Nyquist components are purely real and packed together
+   spectrum[0] = mScratch[0];
+   spectrum[1] = mScratch[1];
+   for (size_t i = 1; i < mFFTSize / 2; i++) {
+      spectrum[2 * i    ] = mScratch[hFFT->BitReversed[i]    ];
+      spectrum[2 * i + 1] = mScratch[hFFT->BitReversed[i] + 1];
+   }
+}
+
+void FFTConvolver::SetFilter(const float *taps, size_t nTaps)
+{
+   const auto partitions =
+      std::max<size_t>(1, (nTaps + mBlockSize - 1) / mBlockSize);
+   if (partitions != mPartitions) {
+      mPartitions = partitions;
+      mFilterSpectra.reinit(mPartitions * mFFTSize);
+      for (auto &channel : mChannels)
+         channel.spectra.reinit(mPartitions * mFFTSize);
+      Reset();
+   }
+
+   // RealFFTf and InverseRealFFTf together are normalized, so that the
+   // product of spectra needs no further scaling
+   for (size_t ii = 0; ii < mPartitions; ++ii) {
+      const auto offset = ii * mBlockSize;
+      const auto count = std::min(mBlockSize, nTaps - std::min(nTaps, offset));
+      std::copy(taps + offset, taps + offset + count, mScratch.get());
+      std::fill(mScratch.get() + count, mScratch.get() + mFFTSize, 0.0f);
+      Transform(mFilterSpectra.get() + ii * mFFTSize);
+   }
+}
+
+void FFTConvolver::Reset()
+{
+   for (auto &channel : mChannels) {
+      std::fill(channel.input.get(), channel.input.get() + mFFTSize, 0.0f);
+      std::fill(channel.output.get(), channel.output.get() + mBlockSize, 0.0f);
+      std::fill(channel.spectra.get(),
+         channel.spectra.get() + mPartitions * mFFTSize, 0.0f);
+   }
+   mPosition = 0;
+   mCurrent = 0;
+}
+
+void FFTConvolver::Process(
+   const float *const *input, float *const *output, size_t len)
+{
+   const auto nChannels = mChannels.size();
+   for (size_t done = 0; done < len;) {
+      const auto count = std::min(len - done, mBlockSize - mPosition);
+      for (size_t ii = 0; ii < nChannels; ++ii) {
+         auto &channel = mChannels[ii];
+         // Take all input before giving output, which may overwrite it
+         std::copy(input[ii] + done, input[ii] + done + count,
+            channel.input.get() + mBlockSize + mPosition);
+         std::copy(channel.output.get() + mPosition,
+            channel.output.get() + mPosition + count, output[ii] + done);
+      }
+      done += count;
+      mPosition += count;
+      if (mPosition == mBlockSize) {
+         ProcessBlock();
+         mPosition = 0;
+      }
+   }
+}
+
+void FFTConvolver::ProcessBlock()
+{
+   const auto spectrumSize = mFFTSize;
+   for (auto &channel : mChannels) {
+      // Transform the previous and current blocks into the delay line
+      std::copy(channel.input.get(), channel.input.get() + mFFTSize,
+         mScratch.get());
+      Transform(channel.spectra.get() + mCurrent * spectrumSize);
+
+      // Multiply each partition of the filter by the spectrum of the input
+      // block as old as the partition's offset, and sum
+      auto acc = mAccumulator.get();
+      std::fill(acc, acc + spectrumSize, 0.0f);
+      for (size_t ii = 0; ii < mPartitions; ++ii) {
+         const auto x = channel.spectra.get() +
+            ((mCurrent + mPartitions - ii) % mPartitions) * spectrumSize;
+         const auto h = mFilterSpectra.get() + ii * spectrumSize;
+         acc[0] += x[0] * h[0];
+         acc[1] += x[1] * h[1];
+         for (size_t i = 2; i < spectrumSize; i += 2) {
+            acc[i    ] += x[i] * h[i    ] - x[i + 1] * h[i + 1];
+            acc[i + 1] += x[i] * h[i + 1] + x[i + 1] * h[i    ];
+         }
+      }
+
+      // The second half of the circular convolution is free of aliasing
+      InverseRealFFTf(acc, hFFT.get());
+      ReorderToTime(hFFT.get(), acc, mScratch.get());
+      std::copy(mScratch.get() + mBlockSize, mScratch.get() + mFFTSize,
+         channel.output.get());
+
+      // The current block becomes the previous
+      std::copy(channel.input.get() + mBlockSize,
+         channel.input.get() + mFFTSize, channel.input.get());
+   }
+   mCurrent = (mCurrent + 1) % mPartitions;
+}
@@ -0,0 +1,84 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  FFTConvolver.h
+
+*******************************************************************//**
+
+\class FFTConvolver
+\brief Convolves any number of channels with one long FIR filter, by
+uniformly partitioned overlap-save on RealFFTf
+
+The filter is cut into partitions of the block size, and the spectra of
+the latest input blocks are kept in a delay line, so that each block of
+output costs one forward and one inverse FFT of twice the block size, plus
+one complex multiply-add per partition.  The latency is one block, however
+long the filter.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_FFT_CONVOLVER__
+#define __AUDACITY_FFT_CONVOLVER__
+
+#include <vector>
+
+#include "../RealFFTf.h"
+#include "../SampleFormat.h"
+
+class FFTConvolver
+{
+public:
+   //! @param blockSize a power of two
+   FFTConvolver(size_t blockSize, size_t nChannels);
+   ~FFTConvolver();
+
+   //! Replace the impulse response used for all channels
+   /*! Input history is kept unless the number of partitions changes */
+   void SetFilter(const float *taps, size_t nTaps);
+
+   //! Forget all previous input
+   void Reset();
+
+   //! Delay of the output, in samples
+   size_t GetBlockSize() const { return mBlockSize; }
+   size_t GetChannelCount() const { return mChannels.size(); }
+
+   //! Filter len samples of each channel; output[i] may equal input[i]
+   void Process(const float *const *input, float *const *output, size_t len);
+
+private:
+   void ProcessBlock();
+
+   // Compute the spectrum of the first mFFTSize values of mScratch, in the
+   // order that InverseRealFFTf takes
+   void Transform(float *spectrum);
+
+   const size_t mBlockSize;
+   const size_t mFFTSize;
+   HFFT hFFT;
+
+   size_t mPartitions{ 0 };
+   // mPartitions spectra, each of mFFTSize values
+   Floats mFilterSpectra;
+
+   struct Channel {
+      // The previous and the current block of input
+      Floats input;
+      // Output for the current block
+      Floats output;
+      // Spectra of the latest mPartitions blocks of input
+      Floats spectra;
+   };
+   std::vector<Channel> mChannels;
+
+   // Position of the next sample within the current block
+   size_t mPosition{ 0 };
+   // Index in the spectra of the current block
+   size_t mCurrent{ 0 };
+
+   Floats mScratch;
+   Floats mAccumulator;
+};
+
+#endif
@@ -18,6 +18,7 @@
 
 #include <atomic>
 #include <wx/time.h>
+#include <wx/utils.h>
 
 class RealtimeEffectState
 {
@@ -42,6 +43,16 @@ private:
    std::atomic<int> mRealtimeSuspendCount{ 1 };    // Effects are initially suspended
 };
 
+// The audio thread never takes a lock.  The main thread builds a new Chain
+// for each change and swaps a pointer; then it waits for the audio thread to
+// stop using the old Chain before destroying it, which may also destroy the
+// states of removed effects.  So the audio thread also never frees memory.
+struct RealtimeEffectManager::Chain
+{
+   std::vector< std::shared_ptr<RealtimeEffectState> > states;
+   bool suspended;
+};
+
 RealtimeEffectManager & RealtimeEffectManager::Get()
 {
    static RealtimeEffectManager rem;
@@ -50,17 +61,56 @@ RealtimeEffectManager & RealtimeEffectManager::Get()
 
 RealtimeEffectManager::RealtimeEffectManager()
 {
-   mRealtimeLock.Enter();
    mRealtimeActive = false;
    mRealtimeSuspended = true;
-   mRealtimeLatency = 0;
-   mRealtimeLock.Leave();
+   Publish();
 }
 
 RealtimeEffectManager::~RealtimeEffectManager()
 {
 }
 
+void RealtimeEffectManager::Publish()
+{
+   auto chain = std::make_unique<Chain>();
+   chain->states = mStates;
+   chain->suspended = mRealtimeSuspended;
+   mChain.store(chain.get());
+
+   // The audio thread picks up the new chain in its next call, or is still
+   // busy with the old one for at most the duration of one buffer
+   const auto old = mPublished.get();
+   while (old && mInUse.load() == old)
+      wxMilliSleep(1);
+
+   mPublished = std::move(chain);
+}
+
+//
+// This will be called in a different thread than the main GUI thread.
+//
+auto RealtimeEffectManager::AcquireChain() -> const Chain &
+{
+   // Announce which chain is in use, then confirm it was not replaced in the
+   // meantime; if it was, Publish() might not have seen the announcement
+   auto chain = mChain.load();
+   while (true) {
+      mInUse.store(chain);
+      const auto current = mChain.load();
+      if (current == chain)
+         return *chain;
+      chain = current;
+   }
+}
+
+//
+// This will be called in a different thread than the main GUI thread.
+//
+void RealtimeEffectManager::ReleaseChain()
+{
+   mInUse.store(nullptr);
+}
+
 #if defined(EXPERIMENTAL_EFFECTS_RACK)
 void RealtimeEffectManager::RealtimeSetEffects(const EffectArray & effects)
 {
@@ -79,7 +129,7 @@ void RealtimeEffectManager::RealtimeSetEffects(const EffectArray & effects)
          // Tell New effect to get ready
          pEffect->RealtimeInitialize();
          newStates.emplace_back(
-            std::make_unique< RealtimeEffectState >( *pEffect ) );
+            std::make_shared< RealtimeEffectState >( *pEffect ) );
       }
       else {
          // Preserve state for effect that remains in the chain
@@ -118,7 +168,7 @@ void RealtimeEffectManager::RealtimeAddEffect(EffectClientInterface *effect)
    RealtimeSuspend();
 
    // Add to list of active effects
-   mStates.emplace_back( std::make_unique< RealtimeEffectState >( *effect ) );
+   mStates.emplace_back( std::make_shared< RealtimeEffectState >( *effect ) );
    auto &state = mStates.back();
 
    // Initialize effect if realtime is already active
@@ -218,23 +268,20 @@ void RealtimeEffectManager::RealtimeFinalize()
 
 void RealtimeEffectManager::RealtimeSuspend()
 {
-   mRealtimeLock.Enter();
-
    // Already suspended...bail
    if (mRealtimeSuspended)
    {
-      mRealtimeLock.Leave();
       return;
    }
 
-   // Show that we aren't going to be doing anything
+   // Show that we aren't going to be doing anything, and wait until the
+   // audio thread is no longer processing
    mRealtimeSuspended = true;
+   Publish();
 
    // And make sure the effects don't either
    for (auto &state : mStates)
       state->RealtimeSuspend();
-
-   mRealtimeLock.Leave();
 }
 
 void RealtimeEffectManager::RealtimeSuspendOne( EffectClientInterface &effect )
@@ -251,12 +298,9 @@ void RealtimeEffectManager::RealtimeSuspendOne( EffectClientInterface &effect )
 
 void RealtimeEffectManager::RealtimeResume()
 {
-   mRealtimeLock.Enter();
-
    // Already running...bail
    if (!mRealtimeSuspended)
    {
-      mRealtimeLock.Leave();
       return;
    }
 
@@ -264,10 +308,9 @@ void RealtimeEffectManager::RealtimeResume()
    for (auto &state : mStates)
       state->RealtimeResume();
 
-   // And we should too
+   // And we should too, with the chain as it is now
    mRealtimeSuspended = false;
-
-   mRealtimeLock.Leave();
+   Publish();
 }
 
 void RealtimeEffectManager::RealtimeResumeOne( EffectClientInterface &effect )
@@ -288,20 +331,19 @@ void RealtimeEffectManager::RealtimeResumeOne( EffectClientInterface &effect )
 void RealtimeEffectManager::RealtimeProcessStart()
 {
    // Protect ourselves from the main thread
-   mRealtimeLock.Enter();
+   auto &chain = AcquireChain();
+   auto cleanup = finally( [this]{ ReleaseChain(); } );
 
    // Can be suspended because of the audio stream being paused or because effects
    // have been suspended.
-   if (!mRealtimeSuspended)
+   if (!chain.suspended)
    {
-      for (auto &state : mStates)
+      for (auto &state : chain.states)
       {
          if (state->IsRealtimeActive())
             state->GetEffect().RealtimeProcessStart();
       }
    }
-
-   mRealtimeLock.Leave();
 }
 
 //
@@ -310,13 +352,13 @@ void RealtimeEffectManager::RealtimeProcessStart()
 size_t RealtimeEffectManager::RealtimeProcess(int group, unsigned chans, float **buffers, size_t numSamples)
 {
    // Protect ourselves from the main thread
-   mRealtimeLock.Enter();
+   auto &chain = AcquireChain();
+   auto cleanup = finally( [this]{ ReleaseChain(); } );
 
    // Can be suspended because of the audio stream being paused or because effects
    // have been suspended, so allow the samples to pass as-is.
-   if (mRealtimeSuspended || mStates.empty())
+   if (chain.suspended || chain.states.empty())
    {
-      mRealtimeLock.Leave();
       return numSamples;
    }
 
@@ -339,7 +381,7 @@ size_t RealtimeEffectManager::RealtimeProcess(int group, unsigned chans, float *
    // Now call each effect in the chain while swapping buffer pointers to feed the
    // output of one effect as the input to the next effect
    size_t called = 0;
-   for (auto &state : mStates)
+   for (auto &state : chain.states)
    {
       if (state->IsRealtimeActive())
       {
@@ -371,8 +413,6 @@ size_t RealtimeEffectManager::RealtimeProcess(int group, unsigned chans, float *
    // Remember the latency
    mRealtimeLatency = (int) (wxGetUTCTimeMillis() - start).GetValue();
 
-   mRealtimeLock.Leave();
-
    //
    // This is wrong...needs to handle tails
    //
@@ -385,20 +425,19 @@ size_t RealtimeEffectManager::RealtimeProcess(int group, unsigned chans, float *
 void RealtimeEffectManager::RealtimeProcessEnd()
 {
    // Protect ourselves from the main thread
-   mRealtimeLock.Enter();
+   auto &chain = AcquireChain();
+   auto cleanup = finally( [this]{ ReleaseChain(); } );
 
    // Can be suspended because of the audio stream being paused or because effects
    // have been suspended.
-   if (!mRealtimeSuspended)
+   if (!chain.suspended)
    {
-      for (auto &state : mStates)
+      for (auto &state : chain.states)
       {
          if (state->IsRealtimeActive())
             state->GetEffect().RealtimeProcessEnd();
       }
    }
-
-   mRealtimeLock.Leave();
 }
 
 int RealtimeEffectManager::GetRealtimeLatency()
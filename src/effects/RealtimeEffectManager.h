@@ -11,9 +11,9 @@
 #ifndef __AUDACITY_REALTIME_EFFECT_MANAGER__
 #define __AUDACITY_REALTIME_EFFECT_MANAGER__
 
+#include <atomic>
 #include <memory>
 #include <vector>
-#include <wx/thread.h>
 
 class EffectClientInterface;
 class RealtimeEffectState;
@@ -48,9 +48,30 @@ private:
    RealtimeEffectManager();
    ~RealtimeEffectManager();
 
-   wxCriticalSection mRealtimeLock;
-   std::vector< std::unique_ptr<RealtimeEffectState> > mStates;
-   int mRealtimeLatency;
+   //! Immutable copy of the chain, which is all that the audio thread reads
+   struct Chain;
+
+   //! Replace the audio thread's copy of the chain, and reclaim the old one
+   //! once the audio thread no longer uses it; call in the main thread only
+   void Publish();
+
+   //! Get the current chain for the duration of one call in the audio thread,
+   //! without blocking
+   const Chain &AcquireChain();
+   void ReleaseChain();
+
+   // Members below, except as noted, are used only in the main thread
+
+   std::vector< std::shared_ptr<RealtimeEffectState> > mStates;
+   std::unique_ptr<const Chain> mPublished;
+   // Equals mPublished.get(), except briefly during Publish()
+   std::atomic<const Chain*> mChain{ nullptr };
+   // The chain that the audio thread is now reading, if any
+   std::atomic<const Chain*> mInUse{ nullptr };
+
+   // Written by the audio thread
+   std::atomic<int> mRealtimeLatency{ 0 };
+
    bool mRealtimeSuspended;
    bool mRealtimeActive;
    std::vector<unsigned> mRealtimeChans;
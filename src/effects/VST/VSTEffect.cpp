@@ -1575,6 +1575,11 @@ bool VSTEffect::RealtimeProcessEnd()
    return true;
 }
 
+bool VSTEffect::SupportsParallelProcessing()
+{
+   return false;
+}
+
 ///
 /// Some history...
 ///
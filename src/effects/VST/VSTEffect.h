@@ -150,6 +150,7 @@ class VSTEffect final : public wxEvtHandler,
                                        float **outbuf,
                                        size_t numSamples) override;
    bool RealtimeProcessEnd() override;
+   bool SupportsParallelProcessing() override;
 
    bool ShowInterface( wxWindow &parent,
       const EffectDialogFactory &factory, bool forceModal = false) override;
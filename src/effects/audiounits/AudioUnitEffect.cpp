@@ -1471,6 +1471,11 @@ bool AudioUnitEffect::RealtimeProcessEnd()
    return true;
 }
 
+bool AudioUnitEffect::SupportsParallelProcessing()
+{
+   return false;
+}
+
 bool AudioUnitEffect::ShowInterface(wxWindow &parent,
                                     const EffectDialogFactory &factory,
                                     bool forceModal)
@@ -1067,6 +1067,11 @@ bool LadspaEffect::RealtimeProcessEnd()
    return true;
 }
 
+bool LadspaEffect::SupportsParallelProcessing()
+{
+   return false;
+}
+
 bool LadspaEffect::ShowInterface(
    wxWindow &parent, const EffectDialogFactory &factory, bool forceModal)
 {
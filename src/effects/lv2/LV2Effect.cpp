@@ -1445,6 +1445,11 @@ bool LV2Effect::RealtimeProcessEnd()
    return true;
 }
 
+bool LV2Effect::SupportsParallelProcessing()
+{
+   return false;
+}
+
 bool LV2Effect::ShowInterface(
    wxWindow &parent, const EffectDialogFactory &factory, bool forceModal)
 {
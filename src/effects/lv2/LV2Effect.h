@@ -308,6 +308,7 @@ public:
    bool RealtimeProcessStart() override;
    size_t RealtimeProcess(int group, float **inbuf, float **outbuf, size_t numSamples) override;
    bool RealtimeProcessEnd() override;
+   bool SupportsParallelProcessing() override;
 
    bool ShowInterface( wxWindow &parent,
       const EffectDialogFactory &factory, bool forceModal = false) override;
@@ -30,6 +30,13 @@
 
 #include "../Audacity.h" // for USE_* macros
 #include "Export.h"
+#include "ExportBatch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <utility>
 
 #include <wx/bmpbuttn.h>
 #include <wx/dcclient.h>
@@ -62,6 +69,7 @@
 #include "../ShuttleGui.h"
 #include "../Tags.h"
 #include "../Theme.h"
+#include "../ThreadPool.h"
 #include "../WaveTrack.h"
 #include "../widgets/AudacityMessageBox.h"
 #include "../widgets/Warning.h"
@@ -218,8 +226,161 @@ void ExportPlugin::OptionsCreate(ShuttleGui &S, int WXUNUSED(format))
    S.EndHorizontalLay();
 }
 
+// Buffers that the mixer thread may fill while the plug-in encodes one
+static const size_t ExportMixerSlots = 4;
+
+struct ExportMixer::Slot
+{
+   // One interleaved buffer, or one buffer per channel
+   ArrayOf<SampleBuffer> buffers;
+   size_t len{ 0 };
+   // Times of the mixer before and after mixing the slot
+   double t0{ 0 }, t1{ 0 };
+};
+
+ExportMixer::ExportMixer(std::unique_ptr<Mixer> pMixer,
+   unsigned numChannels, size_t bufferSize, bool interleaved,
+   sampleFormat format)
+   : mpMixer{ std::move(pMixer) }
+   , mNumChannels{ numChannels }
+   , mBufferSize{ bufferSize }
+   , mInterleaved{ interleaved }
+   , mFormat{ format }
+   , mTime{ mpMixer->MixGetCurrentTime() }
+{
+   if (std::thread::hardware_concurrency() < 2)
+      return;
+
+   const auto nBuffers = mInterleaved ? 1 : mNumChannels;
+   const auto bufferLen = mInterleaved ? mBufferSize * mNumChannels : mBufferSize;
+   mSlots.reinit(ExportMixerSlots);
+   for (size_t ii = 0; ii < ExportMixerSlots; ++ii) {
+      auto &slot = mSlots[ii];
+      slot.buffers.reinit(nBuffers);
+      for (unsigned c = 0; c < nBuffers; ++c)
+         slot.buffers[c].Allocate(bufferLen, mFormat);
+   }
+
+   mMixing = ReusedThreads::Get().Run( [this]{ MixAhead(); } );
+}
+
+ExportMixer::~ExportMixer()
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mStop = true;
+   }
+   mChanged.notify_all();
+   if (mMixing.valid())
+      mMixing.wait();
+}
+
+void ExportMixer::MixAhead()
+{
+   std::unique_lock<std::mutex> lock{ mMutex };
+   while (true) {
+      mChanged.wait(lock,
+         [this]{ return mStop || mFilled < ExportMixerSlots; });
+      if (mStop)
+         break;
+      // This slot is not the consumer's until it is counted as filled
+      auto &slot = mSlots[(mFirst + mFilled) % ExportMixerSlots];
+      lock.unlock();
+
+      bool more = false;
+      try {
+         slot.t0 = mpMixer->MixGetCurrentTime();
+         slot.len = mpMixer->Process(mBufferSize);
+         slot.t1 = mpMixer->MixGetCurrentTime();
+         if (slot.len > 0) {
+            more = true;
+            const auto bytes = slot.len * SAMPLE_SIZE(mFormat);
+            if (mInterleaved)
+               memcpy(slot.buffers[0].ptr(), mpMixer->GetBuffer(),
+                  bytes * mNumChannels);
+            else
+               for (unsigned c = 0; c < mNumChannels; ++c)
+                  memcpy(slot.buffers[c].ptr(), mpMixer->GetBuffer(c), bytes);
+         }
+      }
+      catch (...) {
+         // Give the exception to the consumer after the slots before it
+         lock.lock();
+         mError = std::current_exception();
+         break;
+      }
+
+      lock.lock();
+      if (!more)
+         break;
+      ++mFilled;
+      mChanged.notify_all();
+   }
+   mDone = true;
+   mChanged.notify_all();
+}
+
+size_t ExportMixer::Process(size_t maxSamples)
+{
+   if (!mMixing.valid())
+      return mpMixer->Process(maxSamples);
+
+   std::unique_lock<std::mutex> lock{ mMutex };
+
+   // Release the first slot, when all of it was returned
+   mOffset += mReturned;
+   mReturned = 0;
+   if (mFilled > 0 && mOffset >= mSlots[mFirst].len) {
+      mFirst = (mFirst + 1) % ExportMixerSlots;
+      --mFilled;
+      mOffset = 0;
+      mChanged.notify_all();
+   }
+
+   mChanged.wait(lock, [this]{ return mFilled > 0 || mDone; });
+   if (mFilled == 0) {
+      if (mError)
+         std::rethrow_exception(std::exchange(mError, nullptr));
+      return 0;
+   }
+
+   // Callers ask for the buffer size given to the mixer, but a smaller
+   // request takes the slot in parts
+   const auto &slot = mSlots[mFirst];
+   mReturned = std::min(maxSamples, slot.len - mOffset);
+   mTime = slot.t0 +
+      (slot.t1 - slot.t0) * (mOffset + mReturned) / slot.len;
+   return mReturned;
+}
+
+double ExportMixer::MixGetCurrentTime()
+{
+   if (!mMixing.valid())
+      return mpMixer->MixGetCurrentTime();
+   return mTime;
+}
+
+samplePtr ExportMixer::GetBuffer()
+{
+   if (!mMixing.valid())
+      return mpMixer->GetBuffer();
+   const auto &slot = mSlots[mFirst];
+   return slot.buffers[0].ptr() + mOffset * SAMPLE_SIZE(mFormat) *
+      (mInterleaved ? mNumChannels : 1);
+}
+
+samplePtr ExportMixer::GetBuffer(int channel)
+{
+   if (!mMixing.valid())
+      return mpMixer->GetBuffer(channel);
+   // Interleaved samples are all in the one buffer
+   wxASSERT(!mInterleaved);
+   const auto &slot = mSlots[mFirst];
+   return slot.buffers[channel].ptr() + mOffset * SAMPLE_SIZE(mFormat);
+}
+
 //Create a mixer by computing the time warp factor
-std::unique_ptr<Mixer> ExportPlugin::CreateMixer(const TrackList &tracks,
+std::unique_ptr<ExportMixer> ExportPlugin::CreateMixer(const TrackList &tracks,
          bool selectionOnly,
          double startTime, double stopTime,
          unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
@@ -230,26 +391,72 @@ std::unique_ptr<Mixer> ExportPlugin::CreateMixer(const TrackList &tracks,
 
    bool anySolo = !(( tracks.Any<const WaveTrack>() + &WaveTrack::GetSolo ).empty());
 
+   const auto &selection = mBatchSelection;
+   const auto isSelected = [&](const Track *pTrack) {
+      if (selection.empty())
+         return pTrack->GetSelected();
+      return make_iterator_range( selection ).contains( pTrack );
+   };
+
    auto range = tracks.Any< const WaveTrack >()
-      + (selectionOnly ? &Track::IsSelected : &Track::Any )
       - ( anySolo ? &WaveTrack::GetNotSolo : &WaveTrack::GetMute);
    for (auto pTrack: range)
-      inputTracks.push_back(
-         pTrack->SharedPointer< const WaveTrack >() );
-   // MB: the stop time should not be warped, this was a bug.
-   return std::make_unique<Mixer>(inputTracks,
-                  // Throw, to stop exporting, if read fails:
-                  true,
-                  Mixer::WarpOptions{tracks},
-                  startTime, stopTime,
-                  numOutChannels, outBufferSize, outInterleaved,
-                  outRate, outFormat,
-                  true, mixerSpec);
+      if (!selectionOnly || isSelected(pTrack))
+         inputTracks.push_back(
+            pTrack->SharedPointer< const WaveTrack >() );
+
+   std::unique_ptr<Mixer> result;
+   // Constructing resamplers reads preferences
+   InMainThread( [&]{
+      // MB: the stop time should not be warped, this was a bug.
+      result = std::make_unique<Mixer>(inputTracks,
+                     // Throw, to stop exporting, if read fails:
+                     true,
+                     Mixer::WarpOptions{tracks},
+                     startTime, stopTime,
+                     numOutChannels, outBufferSize, outInterleaved,
+                     outRate, outFormat,
+                     true, mixerSpec);
+   } );
+   return std::make_unique<ExportMixer>(std::move(result),
+      numOutChannels, outBufferSize, outInterleaved, outFormat);
+}
+
+bool ExportPlugin::SupportsBatch(int)
+{
+   return false;
+}
+
+void ExportPlugin::SetBatch(ExportBatch *pBatch, size_t index,
+   std::vector<const Track *> selection)
+{
+   mpBatch = pBatch;
+   mBatchIndex = index;
+   mBatchSelection = std::move(selection);
+}
+
+ProgressResult ExportPlugin::UpdateProgress(
+   std::unique_ptr<ProgressDialog> &pDialog, double current, double total)
+{
+   if (mpBatch)
+      return mpBatch->UpdateProgress(
+         mBatchIndex, total > 0 ? current / total : 1.0);
+   return pDialog->Update(current, total);
+}
+
+void ExportPlugin::InMainThread(const std::function<void()> &f)
+{
+   if (mpBatch)
+      mpBatch->InMainThread(f);
+   else
+      f();
 }
 
 void ExportPlugin::InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
    const TranslatableString &title, const TranslatableString &message)
 {
+   if (mpBatch)
+      return;
    if (!pDialog)
       pDialog = std::make_unique<ProgressDialog>( title, message );
    else {
@@ -343,14 +550,17 @@ Exporter::Exporter( AudacityProject &project )
 
       void Visit( SingleItem &item, const Path &path ) override
       {
-         mPlugins.emplace_back(
-            static_cast<ExporterItem&>( item ).mFactory() );
+         const auto &factory = static_cast<ExporterItem&>( item ).mFactory;
+         mPlugins.emplace_back( factory() );
+         mFactories.push_back( factory );
       }
 
       ExportPluginArray mPlugins;
+      std::vector< ExportPluginFactory > mFactories;
    } visitor;
 
    mPlugins.swap( visitor.mPlugins );
+   mFactories.swap( visitor.mFactories );
 
    SetFileDialogTitle( XO("Export Audio") );
 }
@@ -395,6 +605,13 @@ const ExportPluginArray &Exporter::GetPlugins()
    return mPlugins;
 }
 
+std::unique_ptr<ExportPlugin> Exporter::NewPlugin(size_t index) const
+{
+   if (index >= mFactories.size())
+      return {};
+   return mFactories[index]();
+}
+
 bool Exporter::DoEditMetadata(AudacityProject &project,
    const TranslatableString &title,
    const TranslatableString &shortUndoDescription, bool force)
@@ -11,7 +11,12 @@
 #ifndef __AUDACITY_EXPORT__
 #define __AUDACITY_EXPORT__
 
+#include <condition_variable>
+#include <exception>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <wx/filename.h> // member variable
 #include "audacity/Types.h"
@@ -38,6 +43,8 @@ class Mixer;
 using WaveTrackConstArray = std::vector < std::shared_ptr < const WaveTrack > >;
 enum class ProgressResult : unsigned;
 class wxFileNameWrapper;
+class ExportBatch;
+class Track;
 
 class AUDACITY_DLL_API FormatInfo
 {
@@ -58,6 +65,64 @@ class AUDACITY_DLL_API FormatInfo
       bool mCanMetaData;
 };
 
+//----------------------------------------------------------------------------
+// ExportMixer
+//----------------------------------------------------------------------------
+//! Mixes for an export plug-in in another thread, ahead of the encoding
+/*! Has the functions of Mixer that the plug-ins use.  A mixer thread, reused
+ by later exports, fills a bounded ring of buffers, so that mixing the next
+ samples overlaps encoding and writing of those that Process() last returned,
+ which remain valid until the next call.  Without a second core, Process()
+ mixes directly. */
+class AUDACITY_DLL_API ExportMixer final
+{
+public:
+   ExportMixer(std::unique_ptr<Mixer> pMixer,
+      unsigned numChannels, size_t bufferSize, bool interleaved,
+      sampleFormat format);
+   ExportMixer(const ExportMixer&) = delete;
+   ExportMixer &operator=(const ExportMixer&) = delete;
+   //! Stops the mixer thread, discarding what it mixed ahead
+   ~ExportMixer();
+
+   //! Like Mixer::Process(); rethrows what the mixer threw, after the
+   //! samples mixed before that
+   size_t Process(size_t maxSamples);
+   //! Like Mixer::MixGetCurrentTime(), for the samples Process() returned
+   double MixGetCurrentTime();
+   //! Like Mixer::GetBuffer()
+   samplePtr GetBuffer();
+   //! Like Mixer::GetBuffer(int)
+   samplePtr GetBuffer(int channel);
+
+private:
+   struct Slot;
+   void MixAhead();
+
+   const std::unique_ptr<Mixer> mpMixer;
+   const unsigned mNumChannels;
+   const size_t mBufferSize;
+   const bool mInterleaved;
+   const sampleFormat mFormat;
+
+   // Used only by the thread calling Process()
+   size_t mOffset{ 0 }; // samples of the first slot returned before
+   size_t mReturned{ 0 }; // samples that Process() last returned
+   double mTime;
+
+   // Ring of mixed buffers, filled in turn by the mixer thread
+   ArrayOf<Slot> mSlots;
+   size_t mFirst{ 0 };
+   size_t mFilled{ 0 };
+   bool mDone{ false };
+   bool mStop{ false };
+   std::exception_ptr mError;
+   std::mutex mMutex;
+   std::condition_variable mChanged;
+   // Valid while a reused thread mixes ahead
+   std::future<void> mMixing;
+};
+
 //----------------------------------------------------------------------------
 // ExportPlugin
 //----------------------------------------------------------------------------
@@ -133,22 +198,48 @@ public:
                        const Tags *metadata = NULL,
                        int subformat = 0) = 0;
 
+   /** @brief Whether Export() may run in a worker thread, as one of a batch
+    * of concurrent exports, each with its own instance of the plug-in.
+    *
+    * Such a plug-in reads preferences and shows messages only through
+    * InMainThread(), and reports progress only through UpdateProgress(). */
+   virtual bool SupportsBatch(int subformat);
+
+   /** @brief Make Export() run as one of a batch of concurrent exports
+    * @param selection The tracks to treat as selected, if not empty, because
+    * the selection of the project is shared by the batch */
+   void SetBatch(ExportBatch *pBatch, size_t index,
+      std::vector<const Track *> selection = {});
+
 protected:
-   std::unique_ptr<Mixer> CreateMixer(const TrackList &tracks,
+   //! In a batch, the mixer is made in the main thread
+   std::unique_ptr<ExportMixer> CreateMixer(const TrackList &tracks,
          bool selectionOnly,
          double startTime, double stopTime,
          unsigned numOutChannels, size_t outBufferSize, bool outInterleaved,
          double outRate, sampleFormat outFormat,
          MixerSpec *mixerSpec);
 
-   // Create or recycle a dialog.
-   static void InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
+   // Create or recycle a dialog; does nothing in a batch, which has one
+   // dialog for all exports
+   void InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
          const TranslatableString &title, const TranslatableString &message);
-   static void InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
+   void InitProgress(std::unique_ptr<ProgressDialog> &pDialog,
          const wxFileNameWrapper &title, const TranslatableString &message);
 
+   bool IsBatch() const { return mpBatch != nullptr; }
+   //! Update the dialog made by InitProgress(), or the progress of the batch
+   ProgressResult UpdateProgress(std::unique_ptr<ProgressDialog> &pDialog,
+         double current, double total);
+   //! Call f now, or in a batch, have the main thread call it and wait
+   void InMainThread(const std::function<void()> &f);
+
 private:
    std::vector<FormatInfo> mFormatInfos;
+
+   ExportBatch *mpBatch{};
+   size_t mBatchIndex{ 0 };
+   std::vector<const Track *> mBatchSelection;
 };
 
 using ExportPluginArray = std::vector < std::unique_ptr< ExportPlugin > > ;
@@ -199,6 +290,9 @@ public:
    int FindFormatIndex(int exportindex);
 
    const ExportPluginArray &GetPlugins();
+   //! Make another instance of the plug-in at the given index in
+   //! GetPlugins(), with fresh state
+   std::unique_ptr<ExportPlugin> NewPlugin(size_t index) const;
 
    // Auto Export from Timer Recording
    bool ProcessFromTimerRecording(bool selectedOnly,
@@ -235,6 +329,8 @@ private:
    std::unique_ptr<MixerSpec> mMixerSpec;
 
    ExportPluginArray mPlugins;
+   // The factories of mPlugins, in the same order
+   std::vector<ExportPluginFactory> mFactories;
 
    wxFileName mFilename;
    wxFileName mActualName;
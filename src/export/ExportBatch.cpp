@@ -0,0 +1,100 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportBatch.cpp
+
+**********************************************************************/
+
+#include "ExportBatch.h"
+
+#include <algorithm>
+
+#include "../widgets/ProgressDialog.h"
+
+struct ExportBatch::Call
+{
+   const std::function<void()> *pF{};
+   bool done{ false };
+   std::exception_ptr error;
+};
+
+ExportBatch::ExportBatch(std::vector<double> durations)
+   : mDurations{ std::move(durations) }
+   , mProgress{ mDurations.size() }
+   , mResult{ ProgressResult::Success }
+{
+   for (size_t ii = 0; ii < mDurations.size(); ++ii) {
+      mProgress[ii] = 0.0;
+      mTotalDuration += std::max(0.0, mDurations[ii]);
+   }
+}
+
+void ExportBatch::DoMainThreadCalls()
+{
+   std::unique_lock<std::mutex> lock{ mMutex };
+   while (!mCalls.empty()) {
+      const auto pCall = std::move(mCalls.front());
+      mCalls.pop_front();
+      lock.unlock();
+
+      // The call may show a modal dialog, during which this function is not
+      // reentered, because workers only poll through ThreadPool::ParallelFor
+      try {
+         (*pCall->pF)();
+      }
+      catch (...) {
+         pCall->error = std::current_exception();
+      }
+
+      lock.lock();
+      pCall->done = true;
+      mDone.notify_all();
+   }
+}
+
+double ExportBatch::GetProgress() const
+{
+   const auto nExports = mDurations.size();
+   if (nExports == 0)
+      return 1.0;
+   double sum = 0;
+   if (mTotalDuration > 0) {
+      for (size_t ii = 0; ii < nExports; ++ii)
+         sum += mProgress[ii] * std::max(0.0, mDurations[ii]);
+      return sum / mTotalDuration;
+   }
+   for (size_t ii = 0; ii < nExports; ++ii)
+      sum += mProgress[ii];
+   return sum / nExports;
+}
+
+void ExportBatch::SetResult(ProgressResult result)
+{
+   // Cancellation overrides stopping, but nothing overrides cancellation
+   if (mResult != ProgressResult::Cancelled)
+      mResult = result;
+}
+
+ProgressResult ExportBatch::GetResult() const
+{
+   return mResult;
+}
+
+void ExportBatch::InMainThread(const std::function<void()> &f)
+{
+   const auto pCall = std::make_shared<Call>();
+   pCall->pF = &f;
+
+   std::unique_lock<std::mutex> lock{ mMutex };
+   mCalls.push_back(pCall);
+   mDone.wait(lock, [&]{ return pCall->done; });
+   if (pCall->error)
+      std::rethrow_exception(pCall->error);
+}
+
+ProgressResult ExportBatch::UpdateProgress(size_t index, double fraction)
+{
+   mProgress[index] = std::min(1.0, std::max(0.0, fraction));
+   return mResult;
+}
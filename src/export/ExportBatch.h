@@ -0,0 +1,76 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ExportBatch.h
+
+*******************************************************************//**
+
+\class ExportBatch
+\brief Shared state of the concurrent export of several files
+
+Each file is mixed and encoded by its own instance of an ExportPlugin in a
+worker thread.  Preferences, dialogs and the construction of mixers are
+not safe to use from several threads at once, so the plug-ins pass such
+work to the main thread, which does it while it polls for progress.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_EXPORT_BATCH__
+#define __AUDACITY_EXPORT_BATCH__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "../MemoryX.h"
+
+enum class ProgressResult : unsigned;
+
+class ExportBatch final
+{
+public:
+   //! @param durations of the exports, which weight their progress
+   explicit ExportBatch(std::vector<double> durations);
+   ExportBatch(const ExportBatch&) = delete;
+   ExportBatch &operator=(const ExportBatch&) = delete;
+
+   // Functions for the main thread, while the workers run
+
+   //! Do the calls that workers passed to InMainThread, in order
+   void DoMainThreadCalls();
+   //! Fraction of the work done, weighted by duration
+   double GetProgress() const;
+   //! Make all workers stop or cancel when they next update progress
+   void SetResult(ProgressResult result);
+   ProgressResult GetResult() const;
+
+   // Functions for the workers, through ExportPlugin
+
+   //! Have the main thread call f when it next polls, and wait for it;
+   //! rethrows what f throws
+   void InMainThread(const std::function<void()> &f);
+   ProgressResult UpdateProgress(size_t index, double fraction);
+
+private:
+   struct Call;
+
+   const std::vector<double> mDurations;
+   double mTotalDuration{ 0 };
+
+   // Fraction done of each export
+   ArrayOf< std::atomic<double> > mProgress;
+   std::atomic<ProgressResult> mResult;
+
+   // Calls waiting for the main thread
+   std::mutex mMutex;
+   std::condition_variable mDone;
+   std::deque< std::shared_ptr<Call> > mCalls;
+};
+
+#endif
@@ -222,6 +222,7 @@ public:
                MixerSpec *mixerSpec = NULL,
                const Tags *metadata = NULL,
                int subformat = 0) override;
+   bool SupportsBatch(int) override { return true; }
 
 private:
 
@@ -263,9 +264,11 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
    auto updateResult = ProgressResult::Success;
 
    long levelPref;
-   FLACLevel.Read().ToLong( &levelPref );
-
-   auto bitDepthPref = FLACBitDepth.Read();
+   wxString bitDepthPref;
+   InMainThread( [&]{
+      FLACLevel.Read().ToLong( &levelPref );
+      bitDepthPref = FLACBitDepth.Read();
+   } );
 
    FLAC::Encoder::File encoder;
 
@@ -280,7 +283,7 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
    // See note in GetMetadata() about a bug in libflac++ 1.1.2
    if (success && !GetMetadata(project, metadata)) {
       // TODO: more precise message
-      ShowExportErrorDialog("FLAC:283");
+      InMainThread( []{ ShowExportErrorDialog("FLAC:283"); } );
       return ProgressResult::Cancelled;
    }
 
@@ -333,7 +336,7 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
 
    if (!success) {
       // TODO: more precise message
-      ShowExportErrorDialog("FLAC:336");
+      InMainThread( []{ ShowExportErrorDialog("FLAC:336"); } );
       return ProgressResult::Cancelled;
    }
 
@@ -343,7 +346,9 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
    wxFFile f;     // will be closed when it goes out of scope
    const auto path = fName.GetFullPath();
    if (!f.Open(path, wxT("w+b"))) {
-      AudacityMessageBox( XO("FLAC export couldn't open %s").Format( path ) );
+      InMainThread( [&]{
+         AudacityMessageBox( XO("FLAC export couldn't open %s").Format( path ) );
+      } );
       return ProgressResult::Cancelled;
    }
 
@@ -352,9 +357,11 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
    // libflac can't (under Windows).
    int status = encoder.init(f.fp());
    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
-      AudacityMessageBox(
-         XO("FLAC encoder failed to initialize\nStatus: %d")
-            .Format( status ) );
+      InMainThread( [&]{
+         AudacityMessageBox(
+            XO("FLAC encoder failed to initialize\nStatus: %d")
+               .Format( status ) );
+      } );
       return ProgressResult::Cancelled;
    }
 #endif
@@ -382,7 +389,6 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
       selectionOnly
          ? XO("Exporting the selected audio as FLAC")
          : XO("Exporting the audio as FLAC") );
-   auto &progress = *pDialog;
 
    while (updateResult == ProgressResult::Success) {
       auto samplesThisRun = mixer->Process(SAMPLES_PER_RUN);
@@ -407,13 +413,13 @@ ProgressResult ExportFLAC::Export(AudacityProject *project,
                reinterpret_cast<FLAC__int32**>( tmpsmplbuf.get() ),
                samplesThisRun) ) {
             // TODO: more precise message
-            ShowDiskFullExportErrorDialog(fName);
+            InMainThread( [&]{ ShowDiskFullExportErrorDialog(fName); } );
             updateResult = ProgressResult::Cancelled;
             break;
          }
          if (updateResult == ProgressResult::Success)
-            updateResult =
-               progress.Update(mixer->MixGetCurrentTime() - t0, t1 - t0);
+            updateResult = UpdateProgress(
+               pDialog, mixer->MixGetCurrentTime() - t0, t1 - t0);
       }
    }
 
@@ -1708,6 +1708,7 @@ public:
                MixerSpec *mixerSpec = NULL,
                const Tags *metadata = NULL,
                int subformat = 0) override;
+   bool SupportsBatch(int) override { return true; }
 
 private:
 
@@ -1774,111 +1775,124 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
    const auto &tracks = TrackList::Get( *project );
    MP3Exporter exporter;
 
+   // Loading the library, reading preferences and asking for a valid rate
+   // may show dialogs; initializing the stream fills tables of the library
+   // that are shared by all streams
+   int bitrate = 0;
+   int brate = 0;
+   MP3RateMode rmode = MODE_CBR;
+   int inSamples = -1;
+   bool ready = false;
+   const auto prepare = [&]{
 #ifdef DISABLE_DYNAMIC_LOADING_LAME
-   if (!exporter.InitLibrary(wxT(""))) {
-      AudacityMessageBox( XO("Could not initialize MP3 encoding library!") );
-      gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
-      gPrefs->Flush();
+      if (!exporter.InitLibrary(wxT(""))) {
+         AudacityMessageBox( XO("Could not initialize MP3 encoding library!") );
+         gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
+         gPrefs->Flush();
 
-      return ProgressResult::Cancelled;
-   }
+         return false;
+      }
 #else
-   if (!exporter.LoadLibrary(parent, MP3Exporter::Maybe)) {
-      AudacityMessageBox( XO("Could not open MP3 encoding library!") );
-      gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
-      gPrefs->Flush();
+      if (!exporter.LoadLibrary(parent, MP3Exporter::Maybe)) {
+         AudacityMessageBox( XO("Could not open MP3 encoding library!") );
+         gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
+         gPrefs->Flush();
 
-      return ProgressResult::Cancelled;
-   }
+         return false;
+      }
 
-   if (!exporter.ValidLibraryLoaded()) {
-      AudacityMessageBox( XO("Not a valid or supported MP3 encoding library!") );
-      gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
-      gPrefs->Flush();
+      if (!exporter.ValidLibraryLoaded()) {
+         AudacityMessageBox( XO("Not a valid or supported MP3 encoding library!") );
+         gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
+         gPrefs->Flush();
 
-      return ProgressResult::Cancelled;
-   }
+         return false;
+      }
 #endif // DISABLE_DYNAMIC_LOADING_LAME
 
-   // Retrieve preferences
-   int highrate = 48000;
-   int lowrate = 8000;
-   int bitrate = 0;
-   int brate;
-   //int vmode;
-   bool forceMono;
-
-   gPrefs->Read(wxT("/FileFormats/MP3Bitrate"), &brate, 128);
-   auto rmode = MP3RateModeSetting.ReadEnumWithDefault( MODE_CBR );
-   //gPrefs->Read(wxT("/FileFormats/MP3VarMode"), &vmode, ROUTINE_FAST);
-   auto cmode = MP3ChannelModeSetting.ReadEnumWithDefault( CHANNEL_STEREO );
-   gPrefs->Read(wxT("/FileFormats/MP3ForceMono"), &forceMono, 0);
-
-   // Set the bitrate/quality and mode
-   if (rmode == MODE_SET) {
-      brate = ValidateValue(setRateNames.size(), brate, PRESET_STANDARD);
-      //int r = ValidateValue( varModeNames.size(), vmode, ROUTINE_FAST );
-      exporter.SetMode(MODE_SET);
-      exporter.SetQuality(brate/*, r*/);
-   }
-   else if (rmode == MODE_VBR) {
-      brate = ValidateValue( varRateNames.size(), brate, QUALITY_2 );
-      //int r = ValidateValue( varModeNames.size(), vmode, ROUTINE_FAST );
-      exporter.SetMode(MODE_VBR);
-      exporter.SetQuality(brate/*, r*/);
-   }
-   else if (rmode == MODE_ABR) {
-      brate = ValidateIndex( fixRateValues, brate, 6 /* 128 kbps */ );
-      bitrate = fixRateValues[ brate ];
-      exporter.SetMode(MODE_ABR);
-      exporter.SetBitrate(bitrate);
-
-      if (bitrate > 160) {
-         lowrate = 32000;
+      // Retrieve preferences
+      int highrate = 48000;
+      int lowrate = 8000;
+      //int vmode;
+      bool forceMono;
+
+      gPrefs->Read(wxT("/FileFormats/MP3Bitrate"), &brate, 128);
+      rmode = MP3RateModeSetting.ReadEnumWithDefault( MODE_CBR );
+      //gPrefs->Read(wxT("/FileFormats/MP3VarMode"), &vmode, ROUTINE_FAST);
+      auto cmode = MP3ChannelModeSetting.ReadEnumWithDefault( CHANNEL_STEREO );
+      gPrefs->Read(wxT("/FileFormats/MP3ForceMono"), &forceMono, 0);
+
+      // Set the bitrate/quality and mode
+      if (rmode == MODE_SET) {
+         brate = ValidateValue(setRateNames.size(), brate, PRESET_STANDARD);
+         //int r = ValidateValue( varModeNames.size(), vmode, ROUTINE_FAST );
+         exporter.SetMode(MODE_SET);
+         exporter.SetQuality(brate/*, r*/);
       }
-      else if (bitrate < 32 || bitrate == 144) {
-         highrate = 24000;
+      else if (rmode == MODE_VBR) {
+         brate = ValidateValue( varRateNames.size(), brate, QUALITY_2 );
+         //int r = ValidateValue( varModeNames.size(), vmode, ROUTINE_FAST );
+         exporter.SetMode(MODE_VBR);
+         exporter.SetQuality(brate/*, r*/);
       }
-   }
-   else {
-      brate = ValidateIndex( fixRateValues, brate, 6 /* 128 kbps */ );
-      bitrate = fixRateValues[ brate ];
-      exporter.SetMode(MODE_CBR);
-      exporter.SetBitrate(bitrate);
+      else if (rmode == MODE_ABR) {
+         brate = ValidateIndex( fixRateValues, brate, 6 /* 128 kbps */ );
+         bitrate = fixRateValues[ brate ];
+         exporter.SetMode(MODE_ABR);
+         exporter.SetBitrate(bitrate);
+
+         if (bitrate > 160) {
+            lowrate = 32000;
+         }
+         else if (bitrate < 32 || bitrate == 144) {
+            highrate = 24000;
+         }
+      }
+      else {
+         brate = ValidateIndex( fixRateValues, brate, 6 /* 128 kbps */ );
+         bitrate = fixRateValues[ brate ];
+         exporter.SetMode(MODE_CBR);
+         exporter.SetBitrate(bitrate);
 
-      if (bitrate > 160) {
-         lowrate = 32000;
+         if (bitrate > 160) {
+            lowrate = 32000;
+         }
+         else if (bitrate < 32 || bitrate == 144) {
+            highrate = 24000;
+         }
       }
-      else if (bitrate < 32 || bitrate == 144) {
-         highrate = 24000;
+
+      // Verify sample rate
+      if (!make_iterator_range( sampRates ).contains( rate ) ||
+         (rate < lowrate) || (rate > highrate)) {
+         rate = AskResample(bitrate, rate, lowrate, highrate);
+         if (rate == 0) {
+            return false;
+         }
       }
-   }
 
-   // Verify sample rate
-   if (!make_iterator_range( sampRates ).contains( rate ) ||
-      (rate < lowrate) || (rate > highrate)) {
-      rate = AskResample(bitrate, rate, lowrate, highrate);
-      if (rate == 0) {
-         return ProgressResult::Cancelled;
+      // Set the channel mode
+      if (forceMono) {
+         exporter.SetChannel(CHANNEL_MONO);
+      }
+      else if (cmode == CHANNEL_JOINT) {
+         exporter.SetChannel(CHANNEL_JOINT);
+      }
+      else {
+         exporter.SetChannel(CHANNEL_STEREO);
       }
-   }
 
-   // Set the channel mode
-   if (forceMono) {
-      exporter.SetChannel(CHANNEL_MONO);
-   }
-   else if (cmode == CHANNEL_JOINT) {
-      exporter.SetChannel(CHANNEL_JOINT);
-   }
-   else {
-      exporter.SetChannel(CHANNEL_STEREO);
-   }
+      inSamples = exporter.InitializeStream(channels, rate);
+      if (((int)inSamples) < 0) {
+         AudacityMessageBox( XO("Unable to initialize MP3 stream") );
+         return false;
+      }
 
-   auto inSamples = exporter.InitializeStream(channels, rate);
-   if (((int)inSamples) < 0) {
-      AudacityMessageBox( XO("Unable to initialize MP3 stream") );
+      return true;
+   };
+   InMainThread( [&]{ ready = prepare(); } );
+   if (!ready)
       return ProgressResult::Cancelled;
-   }
 
    // Put ID3 tags at beginning of file
    if (metadata == NULL)
@@ -1887,7 +1901,9 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
    // Open file for writing
    wxFFile outFile(fName.GetFullPath(), wxT("w+b"));
    if (!outFile.IsOpened()) {
-      AudacityMessageBox( XO("Unable to open target file for writing") );
+      InMainThread( []{
+         AudacityMessageBox( XO("Unable to open target file for writing") );
+      } );
       return ProgressResult::Cancelled;
    }
 
@@ -1897,7 +1913,7 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
    if (id3len && !endOfFile) {
       if (id3len > outFile.Write(id3buffer.get(), id3len)) {
          // TODO: more precise message
-         ShowExportErrorDialog("MP3:1882");
+         InMainThread( []{ ShowExportErrorDialog("MP3:1882"); } );
          return ProgressResult::Cancelled;
       }
    }
@@ -1909,7 +1925,7 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
    size_t bufferSize = std::max(0, exporter.GetOutBufferSize());
    if (bufferSize <= 0) {
       // TODO: more precise message
-      ShowExportErrorDialog("MP3:1849");
+      InMainThread( []{ ShowExportErrorDialog("MP3:1849"); } );
       return ProgressResult::Cancelled;
    }
 
@@ -1943,7 +1959,6 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
       }
 
       InitProgress( pDialog, fName, title );
-      auto &progress = *pDialog;
 
       while (updateResult == ProgressResult::Success) {
          auto blockLen = mixer->Process(inSamples);
@@ -1974,19 +1989,20 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
          if (bytes < 0) {
             auto msg = XO("Error %ld returned from MP3 encoder")
                .Format( bytes );
-            AudacityMessageBox( msg );
+            InMainThread( [&]{ AudacityMessageBox( msg ); } );
             updateResult = ProgressResult::Cancelled;
             break;
          }
 
          if (bytes > (int)outFile.Write(buffer.get(), bytes)) {
             // TODO: more precise message
-            ShowDiskFullExportErrorDialog(fName);
+            InMainThread( [&]{ ShowDiskFullExportErrorDialog(fName); } );
             updateResult = ProgressResult::Cancelled;
             break;
          }
 
-         updateResult = progress.Update(mixer->MixGetCurrentTime() - t0, t1 - t0);
+         updateResult = UpdateProgress(
+            pDialog, mixer->MixGetCurrentTime() - t0, t1 - t0);
       }
    }
 
@@ -1996,14 +2012,14 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
 
       if (bytes < 0) {
          // TODO: more precise message
-         ShowExportErrorDialog("MP3:1981");
+         InMainThread( []{ ShowExportErrorDialog("MP3:1981"); } );
          return ProgressResult::Cancelled;
       }
 
       if (bytes > 0) {
          if (bytes > (int)outFile.Write(buffer.get(), bytes)) {
             // TODO: more precise message
-            ShowExportErrorDialog("MP3:1988");
+            InMainThread( []{ ShowExportErrorDialog("MP3:1988"); } );
             return ProgressResult::Cancelled;
          }
       }
@@ -2012,7 +2028,7 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
       if (id3len > 0 && endOfFile) {
          if (bytes > (int)outFile.Write(id3buffer.get(), id3len)) {
             // TODO: more precise message
-            ShowExportErrorDialog("MP3:1997");
+            InMainThread( []{ ShowExportErrorDialog("MP3:1997"); } );
             return ProgressResult::Cancelled;
          }
       }
@@ -2027,7 +2043,7 @@ ProgressResult ExportMP3::Export(AudacityProject *project,
           !outFile.Flush() ||
           !outFile.Close()) {
          // TODO: more precise message
-         ShowExportErrorDialog("MP3:2012");
+         InMainThread( []{ ShowExportErrorDialog("MP3:2012"); } );
          return ProgressResult::Cancelled;
       }
    }
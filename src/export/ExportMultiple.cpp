@@ -17,6 +17,9 @@
 
 #include "../Audacity.h"
 #include "ExportMultiple.h"
+#include "ExportBatch.h"
+
+#include <algorithm>
 
 #include <wx/defs.h>
 #include <wx/button.h>
@@ -46,6 +49,7 @@
 #include "../SelectionState.h"
 #include "../ShuttleGui.h"
 #include "../Tags.h"
+#include "../ThreadPool.h"
 #include "../WaveTrack.h"
 #include "../widgets/HelpSystem.h"
 #include "../widgets/AudacityMessageBox.h"
@@ -864,6 +868,19 @@ ProgressResult ExportMultipleDialog::ExportMultipleByLabel(bool byName,
       l++;  // next label, count up one
    }
 
+   // Export all the files at once, if the plug-in allows
+   {
+      std::vector<ConcurrentExport> exports;
+      for (const auto &kit : exportSettings)
+         // Bug 1440 fix.
+         if (!kit.destfile.GetName().empty())
+            exports.push_back(
+               { channels, kit.destfile, kit.t0, kit.t1, &kit.filetags, {} });
+      auto result = ProgressResult::Success;
+      if (ExportConcurrently(exports, false, result))
+         return result;
+   }
+
    auto ok = ProgressResult::Success;   // did it work?
    int count = 0; // count the number of successful runs
    ExportKit activeSetting;  // pointer to the settings in use for this export
@@ -1008,6 +1025,27 @@ ProgressResult ExportMultipleDialog::ExportMultipleByTrack(bool byName,
    }
    // end of user-interactive data gathering loop, start of export processing
    // loop
+
+   // Export all the files at once, if the plug-in allows; each export mixes
+   // the channels of one track, without changing the selection
+   {
+      std::vector<ConcurrentExport> exports;
+      size_t ii = 0;
+      for (auto tr : mTracks->Leaders<WaveTrack>() -
+         (anySolo ? &WaveTrack::GetNotSolo : &WaveTrack::GetMute)) {
+         const auto &kit = exportSettings[ii++];
+         if (kit.destfile.GetName().empty())
+            continue;
+         ConcurrentExport info{
+            kit.channels, kit.destfile, kit.t0, kit.t1, &kit.filetags, {} };
+         for (auto channel : TrackList::Channels(tr))
+            info.selection.push_back(channel);
+         exports.push_back(std::move(info));
+      }
+      if (ExportConcurrently(exports, true, ok))
+         return ok;
+   }
+
    int count = 0; // count the number of successful runs
    ExportKit activeSetting;  // pointer to the settings in use for this export
    std::unique_ptr<ProgressDialog> pDialog;
@@ -1063,8 +1101,6 @@ ProgressResult ExportMultipleDialog::DoExport(std::unique_ptr<ProgressDialog> &p
                               double t1,
                               const Tags &tags)
 {
-   wxFileName name;
-
    wxLogDebug(wxT("Doing multiple Export: File name \"%s\""), (inName.GetFullName()));
    wxLogDebug(wxT("Channels: %i, Start: %lf, End: %lf "), channels, t0, t1);
    if (selectedOnly)
@@ -1073,50 +1109,11 @@ ProgressResult ExportMultipleDialog::DoExport(std::unique_ptr<ProgressDialog> &p
       wxLogDebug(wxT("Whole Project"));
 
    wxFileName backup;
-   if (mOverwrite->GetValue()) {
-      name = inName;
-      backup.Assign(name);
-
-      int suffix = 0;
-      do {
-         backup.SetName(name.GetName() +
-                           wxString::Format(wxT("%d"), suffix));
-         ++suffix;
-      }
-      while (backup.FileExists());
-      ::wxRenameFile(inName.GetFullPath(), backup.GetFullPath());
-   }
-   else {
-      name = inName;
-      int i = 2;
-      wxString base(name.GetName());
-      while (name.FileExists()) {
-         name.SetName(wxString::Format(wxT("%s-%d"), base, i++));
-      }
-   }
-
    ProgressResult success = ProgressResult::Cancelled;
-   const wxString fullPath{name.GetFullPath()};
+   const wxString fullPath{ PrepareDestination(inName, backup) };
 
    auto cleanup = finally( [&] {
-      bool ok =
-         success == ProgressResult::Stopped ||
-         success == ProgressResult::Success;
-      if (backup.IsOk()) {
-         if ( ok )
-            // Remove backup
-            ::wxRemoveFile(backup.GetFullPath());
-         else {
-            // Restore original
-            ::wxRemoveFile(fullPath);
-            ::wxRenameFile(backup.GetFullPath(), fullPath);
-         }
-      }
-      else {
-         if ( ! ok )
-            // Remove any new, and only partially written, file.
-            ::wxRemoveFile(fullPath);
-      }
+      FinishDestination(success, fullPath, backup);
    } );
 
    // Call the format export routine
@@ -1141,6 +1138,168 @@ ProgressResult ExportMultipleDialog::DoExport(std::unique_ptr<ProgressDialog> &p
    return success;
 }
 
+bool ExportMultipleDialog::ExportConcurrently(
+   const std::vector<ConcurrentExport> &exports, bool selectedOnly,
+   ProgressResult &result)
+{
+   auto &pool = ThreadPool::Get();
+   const auto nExports = exports.size();
+   if (nExports < 2 || pool.GetThreadCount() < 1 ||
+       !mPlugins[mPluginIndex]->SupportsBatch(mSubFormatIndex))
+      return false;
+
+   // When overwriting, a later export of the same name replaces an earlier
+   // one, which needs them to happen in turn
+   if (mOverwrite->GetValue())
+      for (size_t ii = 1; ii < nExports; ++ii)
+         for (size_t jj = 0; jj < ii; ++jj)
+            if (exports[ii].destfile.SameAs(exports[jj].destfile))
+               return false;
+
+   // Each export has its own instance of the plug-in
+   std::vector< std::unique_ptr<ExportPlugin> > plugins;
+   std::vector<double> durations;
+   for (const auto &info : exports) {
+      auto pPlugin = mExporter.NewPlugin(mPluginIndex);
+      if (!pPlugin)
+         return false;
+      plugins.push_back(std::move(pPlugin));
+      durations.push_back(info.t1 - info.t0);
+   }
+
+   ExportBatch batch{ std::move(durations) };
+   std::vector<wxString> paths(nExports);
+   std::vector<wxFileName> backups(nExports);
+   std::vector<ProgressResult> outcomes(nExports, ProgressResult::Cancelled);
+   // No file is written until all paths are chosen, so the paths chosen
+   // must be reserved, or two exports could choose the same.  When
+   // overwriting, all are known, and no backup may take one of them.
+   std::vector<wxFileName> reserved;
+   if (mOverwrite->GetValue())
+      for (const auto &info : exports)
+         reserved.push_back(info.destfile);
+   for (size_t ii = 0; ii < nExports; ++ii) {
+      wxLogDebug(wxT("Doing concurrent Export: File name \"%s\""),
+         exports[ii].destfile.GetFullName());
+      paths[ii] =
+         PrepareDestination(exports[ii].destfile, backups[ii], &reserved);
+      plugins[ii]->SetBatch(&batch, ii, exports[ii].selection);
+   }
+
+   // Keep or remove the files in order, even if an export threw
+   auto cleanup = finally( [&] {
+      for (size_t ii = 0; ii < nExports; ++ii) {
+         FinishDestination(outcomes[ii], paths[ii], backups[ii]);
+         if (outcomes[ii] == ProgressResult::Success ||
+             outcomes[ii] == ProgressResult::Stopped)
+            mExported.push_back(paths[ii]);
+      }
+   } );
+
+   // One dialog for all exports.  Without a stop button, because stopping
+   // one export of a sequence leaves a choice to continue, which does not
+   // apply to exports that run together.
+   ProgressDialog progress{ XO("Export Multiple"),
+      XO("Exporting %d files").Format( (int)nExports ),
+      pdlgHideStopButton };
+
+   pool.ParallelFor(nExports, [&](size_t ii) {
+      if (batch.GetResult() != ProgressResult::Success) {
+         outcomes[ii] = batch.GetResult();
+         return;
+      }
+      const auto &info = exports[ii];
+      // Not used in a batch
+      std::unique_ptr<ProgressDialog> pDialog;
+      try {
+         outcomes[ii] = plugins[ii]->Export(mProject, pDialog,
+            info.channels, paths[ii], selectedOnly, info.t0, info.t1,
+            nullptr, info.pTags, mSubFormatIndex);
+      }
+      catch (...) {
+         // ParallelFor rethrows after the exports in progress end
+         batch.SetResult(ProgressResult::Failed);
+         throw;
+      }
+      batch.UpdateProgress(ii, 1.0);
+      // As in a sequence of exports, a failure ends the others
+      if (outcomes[ii] != ProgressResult::Success &&
+          outcomes[ii] != ProgressResult::Stopped)
+         batch.SetResult(outcomes[ii]);
+   }, [&]{
+      batch.DoMainThreadCalls();
+      const auto pollResult = progress.Update(batch.GetProgress());
+      if (pollResult != ProgressResult::Success)
+         batch.SetResult(pollResult);
+      // Let the workers see the result when they next update progress
+      return true;
+   } );
+
+   result = batch.GetResult();
+   return true;
+}
+
+wxString ExportMultipleDialog::PrepareDestination(
+   const wxFileName &inName, wxFileName &backup,
+   std::vector<wxFileName> *pReserved)
+{
+   const auto isReserved = [&](const wxFileName &name) {
+      return pReserved && std::any_of(pReserved->begin(), pReserved->end(),
+         [&](const wxFileName &other){ return other.SameAs(name); });
+   };
+
+   wxFileName name;
+   if (mOverwrite->GetValue()) {
+      name = inName;
+      backup.Assign(name);
+
+      int suffix = 0;
+      do {
+         backup.SetName(name.GetName() +
+                           wxString::Format(wxT("%d"), suffix));
+         ++suffix;
+      }
+      while (backup.FileExists() || isReserved(backup));
+      ::wxRenameFile(inName.GetFullPath(), backup.GetFullPath());
+      if (pReserved)
+         pReserved->push_back(backup);
+   }
+   else {
+      name = inName;
+      int i = 2;
+      wxString base(name.GetName());
+      while (name.FileExists() || isReserved(name)) {
+         name.SetName(wxString::Format(wxT("%s-%d"), base, i++));
+      }
+   }
+   if (pReserved)
+      pReserved->push_back(name);
+   return name.GetFullPath();
+}
+
+void ExportMultipleDialog::FinishDestination(ProgressResult result,
+   const wxString &fullPath, const wxFileName &backup)
+{
+   bool ok =
+      result == ProgressResult::Stopped ||
+      result == ProgressResult::Success;
+   if (backup.IsOk()) {
+      if ( ok )
+         // Remove backup
+         ::wxRemoveFile(backup.GetFullPath());
+      else {
+         // Restore original
+         ::wxRemoveFile(fullPath);
+         ::wxRenameFile(backup.GetFullPath(), fullPath);
+      }
+   }
+   else {
+      if ( ! ok )
+         // Remove any new, and only partially written, file.
+         ::wxRemoveFile(fullPath);
+   }
+}
+
 wxString ExportMultipleDialog::MakeFileName(const wxString &input)
 {
    wxString newname = input; // name we are generating
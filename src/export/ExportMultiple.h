@@ -79,6 +79,39 @@ private:
                  double t0,
                  double t1,
                  const Tags &tags);
+
+   //! What one of several concurrent exports needs
+   struct ConcurrentExport
+   {
+      unsigned channels;
+      wxFileName destfile;
+      double t0;
+      double t1;
+      const Tags *pTags;
+      //! The tracks to mix, or empty for all
+      std::vector<const Track *> selection;
+   };
+
+   /** \brief Export several files at once on the thread pool, if the
+    * selected plug-in allows it
+    *
+    * @param selectedOnly Whether each export mixes only its selection
+    * @param result Assigned the outcome, if any file was exported
+    * @return false if nothing was exported, and the caller should export
+    * the files one at a time instead */
+   bool ExportConcurrently(const std::vector<ConcurrentExport> &exports,
+                 bool selectedOnly,
+                 ProgressResult &result);
+
+   //! Choose the path to export to, moving aside any file to overwrite
+   /*! @param pReserved if not null, paths not to choose for a new file or
+    a backup, except to overwrite; the paths chosen are added */
+   wxString PrepareDestination(const wxFileName &inName, wxFileName &backup,
+                 std::vector<wxFileName> *pReserved = nullptr);
+   //! Keep the new file, or remove it and restore any file moved aside
+   void FinishDestination(ProgressResult result,
+                 const wxString &fullPath, const wxFileName &backup);
+
    /** \brief Takes an arbitrary text string and converts it to a form that can
     * be used as a file name, if necessary prompting the user to edit the file
     * name produced */
@@ -143,6 +143,7 @@ public:
                MixerSpec *mixerSpec = NULL,
                const Tags *metadata = NULL,
                int subformat = 0) override;
+   bool SupportsBatch(int) override { return true; }
 
 private:
 
@@ -173,7 +174,10 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
 {
    double    rate    = ProjectSettings::Get( *project ).GetRate();
    const auto &tracks = TrackList::Get( *project );
-   double    quality = (gPrefs->Read(wxT("/FileFormats/OggExportQuality"), 50)/(float)100.0);
+   double    quality;
+   InMainThread( [&]{
+      quality = (gPrefs->Read(wxT("/FileFormats/OggExportQuality"), 50)/(float)100.0);
+   } );
 
    wxLogNull logNo;            // temporarily disable wxWidgets error messages
    auto updateResult = ProgressResult::Success;
@@ -182,7 +186,9 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
    FileIO outFile(fName, FileIO::Output);
 
    if (!outFile.IsOpened()) {
-      AudacityMessageBox( XO("Unable to open target file for writing") );
+      InMainThread( []{
+         AudacityMessageBox( XO("Unable to open target file for writing") );
+      } );
       return ProgressResult::Cancelled;
    }
 
@@ -209,7 +215,9 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
    vorbis_info_init(&info);
    if (vorbis_encode_init_vbr(&info, numChannels, (int)(rate + 0.5), quality)) {
       // TODO: more precise message
-      AudacityMessageBox( XO("Unable to export - rate or quality problem") );
+      InMainThread( []{
+         AudacityMessageBox( XO("Unable to export - rate or quality problem") );
+      } );
       return ProgressResult::Cancelled;
    }
 
@@ -223,14 +231,18 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
 
    // Retrieve tags
    if (!FillComment(project, &comment, metadata)) {
-      AudacityMessageBox( XO("Unable to export - problem with metadata") );
+      InMainThread( []{
+         AudacityMessageBox( XO("Unable to export - problem with metadata") );
+      } );
       return ProgressResult::Cancelled;
    }
 
    // Set up analysis state and auxiliary encoding storage
    if (vorbis_analysis_init(&dsp, &info) ||
        vorbis_block_init(&dsp, &block)) {
-      AudacityMessageBox( XO("Unable to export - problem initialising") );
+      InMainThread( []{
+         AudacityMessageBox( XO("Unable to export - problem initialising") );
+      } );
       return ProgressResult::Cancelled;
    }
 
@@ -239,7 +251,9 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
    // chained streams with concatenation.
    srand(time(NULL));
    if (ogg_stream_init(&stream, rand())) {
-      AudacityMessageBox( XO("Unable to export - problem creating stream") );
+      InMainThread( []{
+         AudacityMessageBox( XO("Unable to export - problem creating stream") );
+      } );
       return ProgressResult::Cancelled;
    }
 
@@ -261,7 +275,9 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
       ogg_stream_packetin(&stream, &bitstream_header) ||
       ogg_stream_packetin(&stream, &comment_header) ||
       ogg_stream_packetin(&stream, &codebook_header)) {
-      AudacityMessageBox( XO("Unable to export - problem with packets") );
+      InMainThread( []{
+         AudacityMessageBox( XO("Unable to export - problem with packets") );
+      } );
       return ProgressResult::Cancelled;
    }
 
@@ -270,7 +286,9 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
    while (ogg_stream_flush(&stream, &page)) {
       if ( outFile.Write(page.header, page.header_len).GetLastError() ||
            outFile.Write(page.body, page.body_len).GetLastError()) {
-         AudacityMessageBox( XO("Unable to export - problem with file") );
+         InMainThread( []{
+            AudacityMessageBox( XO("Unable to export - problem with file") );
+         } );
          return ProgressResult::Cancelled;
       }
    }
@@ -285,7 +303,6 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
          selectionOnly
             ? XO("Exporting the selected audio as Ogg Vorbis")
             : XO("Exporting the audio as Ogg Vorbis") );
-      auto &progress = *pDialog;
 
       while (updateResult == ProgressResult::Success && !eos) {
          float **vorbis_buffer = vorbis_analysis_buffer(&dsp, SAMPLES_PER_RUN);
@@ -338,7 +355,7 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
                   if ( outFile.Write(page.header, page.header_len).GetLastError() ||
                        outFile.Write(page.body, page.body_len).GetLastError()) {
                      // TODO: more precise message
-                     ShowDiskFullExportErrorDialog(fName);
+                     InMainThread( [&]{ ShowDiskFullExportErrorDialog(fName); } );
                      return ProgressResult::Cancelled;
                   }
 
@@ -352,18 +369,19 @@ ProgressResult ExportOGG::Export(AudacityProject *project,
          if (err) {
             updateResult = ProgressResult::Cancelled;
             // TODO: more precise message
-            ShowExportErrorDialog("OGG:355");
+            InMainThread( []{ ShowExportErrorDialog("OGG:355"); } );
             break;
          }
 
-         updateResult = progress.Update(mixer->MixGetCurrentTime() - t0, t1 - t0);
+         updateResult = UpdateProgress(
+            pDialog, mixer->MixGetCurrentTime() - t0, t1 - t0);
       }
    }
 
    if ( !outFile.Close() ) {
       updateResult = ProgressResult::Cancelled;
       // TODO: more precise message
-      ShowExportErrorDialog("OGG:366");
+      InMainThread( []{ ShowExportErrorDialog("OGG:366"); } );
    }
 
    return updateResult;
@@ -400,6 +400,7 @@ public:
    wxString GetFormat(int index) override;
    FileExtension GetExtension(int index) override;
    unsigned GetMaxChannels(int index) override;
+   bool SupportsBatch(int) override { return true; }
 
 private:
    void ReportTooBigError(wxWindow * pParent);
@@ -477,30 +478,32 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
    // Set a default in case the settings aren't found
    int sf_format;
 
-   switch (subformat)
-   {
+   InMainThread( [&]{
+      switch (subformat)
+      {
 #if defined(__WXMAC__)
-      case FMT_AIFF:
-         sf_format = SF_FORMAT_AIFF;
-      break;
+         case FMT_AIFF:
+            sf_format = SF_FORMAT_AIFF;
+         break;
 #endif
 
-      case FMT_WAV:
-         sf_format = SF_FORMAT_WAV;
-      break;
+         case FMT_WAV:
+            sf_format = SF_FORMAT_WAV;
+         break;
 
-      default:
-         // Retrieve the current format.
-         sf_format = LoadOtherFormat();
-      break;
-   }
+         default:
+            // Retrieve the current format.
+            sf_format = LoadOtherFormat();
+         break;
+      }
 
-   // Prior to v2.4.0, sf_format will include the subtype. If not present,
-   // check for the format specific preference.
-   if (!(sf_format & SF_FORMAT_SUBMASK))
-   {
-      sf_format |= LoadEncoding(sf_format);
-   }
+      // Prior to v2.4.0, sf_format will include the subtype. If not present,
+      // check for the format specific preference.
+      if (!(sf_format & SF_FORMAT_SUBMASK))
+      {
+         sf_format |= LoadEncoding(sf_format);
+      }
+   } );
 
    // If subtype is still not specified, supply a default.
    if (!(sf_format & SF_FORMAT_SUBMASK))
@@ -536,13 +539,17 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
       // Bug 46.  Trap here, as sndfile.c does not trap it properly.
       if( (numChannels != 1) && ((sf_format & SF_FORMAT_SUBMASK) == SF_FORMAT_GSM610) )
       {
-         AudacityMessageBox( XO("GSM 6.10 requires mono") );
+         InMainThread( []{
+            AudacityMessageBox( XO("GSM 6.10 requires mono") );
+         } );
          return ProgressResult::Cancelled;
       }
 
       if (sf_format == SF_FORMAT_WAVEX + SF_FORMAT_GSM610) {
-         AudacityMessageBox(
-            XO("WAVEX and GSM 6.10 formats are not compatible") );
+         InMainThread( []{
+            AudacityMessageBox(
+               XO("WAVEX and GSM 6.10 formats are not compatible") );
+         } );
          return ProgressResult::Cancelled;
       }
 
@@ -555,7 +562,9 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
       if (!sf_format_check(&info))
          info.format = (info.format & SF_FORMAT_TYPEMASK);
       if (!sf_format_check(&info)) {
-         AudacityMessageBox( XO("Cannot export audio in this format.") );
+         InMainThread( []{
+            AudacityMessageBox( XO("Cannot export audio in this format.") );
+         } );
          return ProgressResult::Cancelled;
       }
       const auto path = fName.GetFullPath();
@@ -569,7 +578,9 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
       }
 
       if (!sf) {
-         AudacityMessageBox( XO("Cannot export audio to %s").Format( path ) );
+         InMainThread( [&]{
+            AudacityMessageBox( XO("Cannot export audio to %s").Format( path ) );
+         } );
          return ProgressResult::Cancelled;
       }
       // Retrieve tags if not given a set
@@ -603,7 +614,9 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
          // Test for 4 Gibibytes, rather than 4 Gigabytes
          if( byteCount > 4.295e9)
          {
-            ReportTooBigError( wxTheApp->GetTopWindow() );
+            InMainThread( [this]{
+               ReportTooBigError( wxTheApp->GetTopWindow() );
+            } );
             return ProgressResult::Failed;
          }
       }
@@ -626,7 +639,6 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
                ? XO("Exporting the selected audio as %s")
                : XO("Exporting the audio as %s"))
                .Format( formatStr ) );
-         auto &progress = *pDialog;
 
          while (updateResult == ProgressResult::Success) {
             sf_count_t samplesWritten;
@@ -682,7 +694,8 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
                break;
             }
             
-            updateResult = progress.Update(mixer->MixGetCurrentTime() - t0, t1 - t0);
+            updateResult = UpdateProgress(
+               pDialog, mixer->MixGetCurrentTime() - t0, t1 - t0);
          }
       }
       
@@ -693,13 +706,13 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
              fileFormat == SF_FORMAT_WAVEX) {
             if (!AddStrings(project, sf.get(), metadata, sf_format)) {
                // TODO: more precise message
-               ShowExportErrorDialog("PCM:675");
+               InMainThread( []{ ShowExportErrorDialog("PCM:675"); } );
                return ProgressResult::Cancelled;
             }
          }
          if (0 != sf.close()) {
             // TODO: more precise message
-            ShowExportErrorDialog("PCM:681");
+            InMainThread( []{ ShowExportErrorDialog("PCM:681"); } );
             return ProgressResult::Cancelled;
          }
       }
@@ -712,7 +725,7 @@ ProgressResult ExportPCM::Export(AudacityProject *project,
          // Note: file has closed, and gets reopened and closed again here:
          if (!AddID3Chunk(fName, metadata, sf_format) ) {
             // TODO: more precise message
-            ShowExportErrorDialog("PCM:694");
+            InMainThread( []{ ShowExportErrorDialog("PCM:694"); } );
             return ProgressResult::Cancelled;
          }
 
@@ -38,9 +38,11 @@ ImportLOF.cpp, and ImportAUP.cpp.
 #include "../Audacity.h" // for USE_* macros
 #include "Import.h"
 
+#include "ImportBatch.h"
 #include "ImportPlugin.h"
 
 #include <algorithm>
+#include <chrono>
 #include <unordered_set>
 
 #include <wx/textctrl.h>
@@ -53,6 +55,8 @@ ImportLOF.cpp, and ImportAUP.cpp.
 #include "../FileNames.h"
 #include "../ShuttleGui.h"
 #include "../Project.h"
+#include "../Tags.h"
+#include "../ThreadPool.h"
 #include "../WaveTrack.h"
 
 #include "../Prefs.h"
@@ -453,45 +457,11 @@ std::unique_ptr<ExtImportItem> Importer::CreateDefaultImportItem()
    return new_item;
 }
 
-// returns number of tracks imported
-bool Importer::Import( AudacityProject &project,
-                     const FilePath &fName,
-                     WaveTrackFactory *trackFactory,
-                     TrackHolders &tracks,
-                     Tags *tags,
-                     TranslatableString &errorMessage)
+std::vector<ImportPlugin*> Importer::GetImportPlugins(
+   const FilePath &fName, const FileExtension &extension)
 {
-   AudacityProject *pProj = &project;
-   auto cleanup = valueRestorer( pProj->mbBusyImporting, true );
-
-   const FileExtension extension{ fName.AfterLast(wxT('.')) };
-
-   // Always refuse to import MIDI, even though the FFmpeg plugin pretends to know how (but makes very bad renderings)
-#ifdef USE_MIDI
-   // MIDI files must be imported, not opened
-   if (FileNames::IsMidi(fName)) {
-      errorMessage = XO(
-"\"%s\" \nis a MIDI file, not an audio file. \nAudacity cannot open this type of file for playing, but you can\nedit it by clicking File > Import > MIDI.")
-         .Format( fName );
-      return false;
-   }
-#endif
-
-   // Bug #2647: Peter has a Word 2000 .doc file that is recognized and imported by FFmpeg.
-   if (wxFileName(fName).GetExt() == wxT("doc")) {
-      errorMessage =
-         XO("\"%s\" \nis a not an audio file. \nAudacity cannot open this type of file.")
-         .Format( fName );
-      return false;
-   }
-
-   using ImportPluginPtrs = std::vector< ImportPlugin* >;
-
    // This list is used to call plugins in correct order
-   ImportPluginPtrs importPlugins;
-
-   // This list is used to remember plugins that should have been compatible with the file.
-   ImportPluginPtrs compatiblePlugins;
+   std::vector< ImportPlugin* > importPlugins;
 
    // Not implemented (yet?)
    wxString mime_type = wxT("*");
@@ -604,12 +574,68 @@ bool Importer::Import( AudacityProject &project,
       }
    }
 
+   return importPlugins;
+}
+
+// returns number of tracks imported
+bool Importer::Import( AudacityProject &project,
+                     const FilePath &fName,
+                     WaveTrackFactory *trackFactory,
+                     TrackHolders &tracks,
+                     Tags *tags,
+                     TranslatableString &errorMessage,
+                     ImportPlugin *pOpenedBy,
+                     std::shared_ptr<ImportFileHandle> pOpened)
+{
+   AudacityProject *pProj = &project;
+   auto cleanup = valueRestorer( pProj->mbBusyImporting, true );
+
+   const FileExtension extension{ fName.AfterLast(wxT('.')) };
+
+   // Always refuse to import MIDI, even though the FFmpeg plugin pretends to know how (but makes very bad renderings)
+#ifdef USE_MIDI
+   // MIDI files must be imported, not opened
+   if (FileNames::IsMidi(fName)) {
+      errorMessage = XO(
+"\"%s\" \nis a MIDI file, not an audio file. \nAudacity cannot open this type of file for playing, but you can\nedit it by clicking File > Import > MIDI.")
+         .Format( fName );
+      return false;
+   }
+#endif
+
+   // Bug #2647: Peter has a Word 2000 .doc file that is recognized and imported by FFmpeg.
+   if (wxFileName(fName).GetExt() == wxT("doc")) {
+      errorMessage =
+         XO("\"%s\" \nis a not an audio file. \nAudacity cannot open this type of file.")
+         .Format( fName );
+      return false;
+   }
+
+   using ImportPluginPtrs = std::vector< ImportPlugin* >;
+
+   // This list is used to call plugins in correct order
+   ImportPluginPtrs importPlugins = GetImportPlugins(fName, extension);
+
+   // This list is used to remember plugins that should have been compatible with the file.
+   ImportPluginPtrs compatiblePlugins;
+
    // Try the import plugins, in the permuted sequences just determined
    for (const auto plugin : importPlugins)
    {
-      // Try to open the file with this plugin (probe it)
-      wxLogMessage(wxT("Opening with %s"),plugin->GetPluginStringID());
-      auto inFile = plugin->Open(fName, pProj);
+      std::shared_ptr<ImportFileHandle> inFile;
+      if (pOpened)
+      {
+         // Plugins before the one that opened the file already failed
+         if (plugin != pOpenedBy)
+            continue;
+         inFile = std::move(pOpened);
+      }
+      else
+      {
+         // Try to open the file with this plugin (probe it)
+         wxLogMessage(wxT("Opening with %s"),plugin->GetPluginStringID());
+         inFile = plugin->Open(fName, pProj);
+      }
       if ( (inFile != NULL) && (inFile->GetStreamCount() > 0) )
       {
          wxLogMessage(wxT("Open(%s) succeeded"), fName);
@@ -832,6 +858,143 @@ bool Importer::Import( AudacityProject &project,
    return false;
 }
 
+ProgressResult Importer::ImportConcurrently( AudacityProject &project,
+                     const FilePaths &fileNames,
+                     WaveTrackFactory *trackFactory,
+                     std::vector<ConcurrentResult> &results)
+{
+   const auto nFiles = fileNames.size();
+   results.clear();
+   results.resize(nFiles);
+
+   auto &pool = ThreadPool::Get();
+   if (pool.GetThreadCount() == 0 || nFiles < 2)
+      return ProgressResult::Success;
+
+   AudacityProject *pProj = &project;
+   auto cleanup = valueRestorer( pProj->mbBusyImporting, true );
+
+   // Open the files in this thread, because probing may talk to the user.
+   // Keep the handles that can import without more questions, and leave the
+   // other files, and all special cases, to Import().
+   std::vector< std::unique_ptr<ImportFileHandle> > handles;
+   std::vector< size_t > indices;
+   for (size_t ii = 0; ii < nFiles; ++ii) {
+      const auto &fName = fileNames[ii];
+      const FileExtension extension{ fName.AfterLast(wxT('.')) };
+      if (extension.IsSameAs(wxT("lof"), false) ||
+          extension.IsSameAs(wxT("aup"), false) ||
+          extension.IsSameAs(wxT("aup3"), false) ||
+#ifdef USE_MIDI
+          FileNames::IsMidi(fName) ||
+#endif
+          wxFileName(fName).GetExt() == wxT("doc"))
+         continue;
+
+      // Take the first plugin that opens the file, as Import() would
+      for (const auto plugin : GetImportPlugins(fName, extension)) {
+         auto inFile = plugin->Open(fName, pProj);
+         if ( (inFile != NULL) && (inFile->GetStreamCount() > 0) ) {
+            if (inFile->GetStreamCount() == 1 && inFile->SupportsBatch()) {
+               inFile->SetStreamUsage(0, TRUE);
+               handles.push_back(std::move(inFile));
+               indices.push_back(ii);
+            }
+            else {
+               // Import() continues with this, so that probing does not
+               // repeat any questions to the user
+               results[ii].pOpenedBy = plugin;
+               results[ii].pOpened = std::move(inFile);
+            }
+            break;
+         }
+      }
+   }
+
+   const auto nHandles = handles.size();
+   if (nHandles < 2)
+      return ProgressResult::Success;
+
+   std::vector< TrackHolders > tracks(nHandles);
+   std::vector< std::shared_ptr<Tags> > tags(nHandles);
+   std::vector< ProgressResult > outcomes(nHandles, ProgressResult::Failed);
+   ImportBatch batch{ *trackFactory, nHandles };
+   for (size_t jj = 0; jj < nHandles; ++jj) {
+      handles[jj]->SetBatch(&batch, jj);
+      // Start from no tags, so that only those of the file are merged later
+      tags[jj] = std::make_shared<Tags>();
+      tags[jj]->Clear();
+   }
+
+   // Stop and Cancel apply to all the files, not just one as when importing
+   // them in turn, so confirm them
+   ProgressDialog progress{ XO("Import"),
+      XO("Importing %d files").Format( (int)nHandles ),
+      pdlgConfirmStopCancel };
+
+   using namespace std::chrono;
+   const auto start = steady_clock::now();
+   pool.ParallelFor(nHandles, [&](size_t jj) {
+      if (batch.GetResult() != ProgressResult::Success)
+         outcomes[jj] = batch.GetResult();
+      else
+         outcomes[jj] =
+            handles[jj]->Import(trackFactory, tracks[jj], tags[jj].get());
+   }, [&]{
+      batch.ReplenishTracks();
+      const auto result = progress.Update(batch.GetProgress());
+      if (result != ProgressResult::Success)
+         batch.SetResult(result);
+      // Let the workers see the result when they next update progress
+      return true;
+   } );
+   batch.Finish();
+   const duration<double> elapsed = steady_clock::now() - start;
+
+   for (size_t jj = 0; jj < nHandles; ++jj)
+      batch.ShowMessagesAtEnd(jj);
+
+   const auto result = batch.GetResult();
+   if (result == ProgressResult::Cancelled)
+      return result;
+
+   size_t nImported = 0;
+   for (size_t jj = 0; jj < nHandles; ++jj) {
+      const auto outcome = outcomes[jj];
+      auto &fileResult = results[indices[jj]];
+      if (outcome == ProgressResult::Failed) {
+         // Any messages were shown above; decoding again would fail again
+         fileResult.failed = true;
+         continue;
+      }
+      if (outcome == ProgressResult::Success ||
+          outcome == ProgressResult::Stopped)
+         batch.DoEditsAtEnd(jj);
+
+      auto &groups = tracks[jj];
+      // As in Import(), drop any empty groups of channels
+      groups.erase( std::remove_if( groups.begin(), groups.end(),
+            std::mem_fn( &NewChannelGroup::empty ) ),
+         groups.end() );
+      if ((outcome == ProgressResult::Success ||
+           outcome == ProgressResult::Stopped) && !groups.empty()) {
+         fileResult.imported = true;
+         fileResult.tracks = std::move(groups);
+         fileResult.pTags = tags[jj];
+         ++nImported;
+      }
+   }
+
+   const auto seconds = std::max(1e-6, elapsed.count());
+   const auto megabytes = batch.GetBytesAppended() / (1024.0 * 1024.0);
+   wxLogMessage(
+      wxT("Imported %d of %d files concurrently, %.1f MB of samples in %.2f s: %.1f MB/s, %.1f files/s"),
+      (int)nImported, (int)nHandles, megabytes, seconds,
+      megabytes / seconds, nImported / seconds);
+
+   return result;
+}
+
 //-------------------------------------------------------------------------
 // ImportStreamDialog
 //-------------------------------------------------------------------------
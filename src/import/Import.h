@@ -30,6 +30,7 @@ class Track;
 class ImportPlugin;
 class ImportFileHandle;
 class UnusableImportPlugin;
+enum class ProgressResult : unsigned;
 typedef bool (*progress_callback_t)( void *userData, float percent );
 
 class ExtImportItem;
@@ -165,14 +166,53 @@ public:
     std::unique_ptr<ExtImportItem> CreateDefaultImportItem();
 
    // if false, the import failed and errorMessage will be set.
+   // pOpened, if not null, is the file as opened by pOpenedBy, so that it
+   // is not probed again.
    bool Import( AudacityProject &project,
               const FilePath &fName,
               WaveTrackFactory *trackFactory,
               TrackHolders &tracks,
               Tags *tags,
-              TranslatableString &errorMessage);
+              TranslatableString &errorMessage,
+              ImportPlugin *pOpenedBy = nullptr,
+              std::shared_ptr<ImportFileHandle> pOpened = {});
+
+   //! Outcome of the import of one of several files by ImportConcurrently
+   struct ConcurrentResult
+   {
+      //! If false, and not failed, the file should be imported alone by
+      //! Import, which also reports any errors
+      bool imported{ false };
+      //! The file was decoded in the batch, and failed, so that nothing more
+      //! is to be done, as when Import() returns false
+      bool failed{ false };
+      TrackHolders tracks;
+      //! Only the tags found in the file, to be merged into the project's
+      std::shared_ptr<Tags> pTags;
+      //! If not imported nor failed, and not null, the file as opened when
+      //! probing, to be passed to Import
+      ImportPlugin *pOpenedBy{};
+      std::shared_ptr<ImportFileHandle> pOpened;
+   };
+
+   /*!
+    Decode several files at once, in worker threads, if their importers
+    allow it and there is no need to ask the user about streams; tracks are
+    made with trackFactory but not added to the project.
+    Aggregate throughput is written to the log.
+    @param results receives one result for each file name, in order
+    @return Success, or else Stopped or Cancelled if the user chose that
+    */
+   ProgressResult ImportConcurrently( AudacityProject &project,
+              const FilePaths &fileNames,
+              WaveTrackFactory *trackFactory,
+              std::vector<ConcurrentResult> &results);
 
 private:
+   //! Plugins that may import the file, in the order to try them
+   std::vector<ImportPlugin*> GetImportPlugins(
+      const FilePath &fName, const FileExtension &extension);
+
    static Importer mInstance;
 
    ExtImportItems mExtImportItems;
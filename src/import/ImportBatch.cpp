@@ -0,0 +1,279 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ImportBatch.cpp
+
+**********************************************************************/
+
+#include "ImportBatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ImportPlugin.h"
+#include "../SampleFormat.h"
+#include "../ThreadPool.h"
+#include "../WaveTrack.h"
+#include "../prefs/QualityPrefs.h"
+#include "../widgets/AudacityMessageBox.h"
+#include "../widgets/ProgressDialog.h"
+
+// Bound on the samples queued for the writer, so that fast decoders do not
+// fill memory while the writer lags
+static const size_t MaxQueuedBytes = 64 * 1024 * 1024;
+
+struct ImportBatch::Job
+{
+   // Either samples to append to a track...
+   WaveTrack *pTrack{};
+   ArrayOf<char> samples;
+   sampleFormat format{ floatSample };
+   size_t len{ 0 };
+   size_t bytes{ 0 };
+
+   // ...or an edit, for which the caller waits
+   const std::function<void()> *pEdit{};
+   bool done{ false };
+   std::exception_ptr error;
+};
+
+ImportBatch::ImportBatch(WaveTrackFactory &trackFactory, size_t nFiles)
+   : mTrackFactory{ trackFactory }
+   , mDefaultFormat{ QualityPrefs::SampleFormatChoice() }
+   , mProgress{ nFiles }
+   , mnFiles{ nFiles }
+   , mResult{ ProgressResult::Success }
+   , mEditsAtEnd( nFiles )
+   , mMessagesAtEnd( nFiles )
+{
+   for (size_t ii = 0; ii < nFiles; ++ii)
+      mProgress[ii] = 0.0;
+
+   // Most files are mono or stereo
+   mTracksWanted = 2 * nFiles;
+   ReplenishTracks();
+   mTracksWanted = 0;
+
+   // Not a thread of its own, which would leave behind the statements that
+   // DBConnection prepares for each thread, until the project closes
+   mWriting = ReusedThreads::Get().Run( [this]{ Writer(); } );
+}
+
+ImportBatch::~ImportBatch()
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mStop = true;
+   }
+   mQueued.notify_all();
+   if (mWriting.valid())
+      mWriting.wait();
+}
+
+void ImportBatch::ReplenishTracks()
+{
+   std::lock_guard<std::mutex> lock{ mTrackMutex };
+   if (mSpareTracks.size() >= mTracksWanted)
+      return;
+   // Format and rate are changed when the tracks are given out; the
+   // constructor of WaveTrack reads preferences, which only the main
+   // thread may do
+   while (mSpareTracks.size() < mTracksWanted)
+      mSpareTracks.push_back( mTrackFactory.NewWaveTrack(floatSample) );
+   mTrackAvailable.notify_all();
+}
+
+double ImportBatch::GetProgress() const
+{
+   double sum = 0;
+   for (size_t ii = 0; ii < mnFiles; ++ii)
+      sum += mProgress[ii];
+   return mnFiles > 0 ? sum / mnFiles : 1.0;
+}
+
+void ImportBatch::SetResult(ProgressResult result)
+{
+   // Cancellation overrides stopping, but nothing overrides cancellation
+   if (mResult != ProgressResult::Cancelled)
+      mResult = result;
+}
+
+ProgressResult ImportBatch::GetResult() const
+{
+   return mResult;
+}
+
+void ImportBatch::Finish()
+{
+   {
+      std::lock_guard<std::mutex> lock{ mMutex };
+      mFinishing = true;
+   }
+   mQueued.notify_all();
+   if (mWriting.valid())
+      mWriting.wait();
+
+   if (mError)
+      std::rethrow_exception(mError);
+}
+
+std::shared_ptr<WaveTrack> ImportBatch::NewWaveTrack(
+   sampleFormat effectiveFormat, double rate)
+{
+   std::shared_ptr<WaveTrack> result;
+   {
+      std::unique_lock<std::mutex> lock{ mTrackMutex };
+      if (mSpareTracks.empty()) {
+         // The main thread replenishes when it next polls
+         ++mTracksWanted;
+         mTrackAvailable.wait(lock, [this]{ return !mSpareTracks.empty(); });
+         --mTracksWanted;
+      }
+      result = std::move(mSpareTracks.back());
+      mSpareTracks.pop_back();
+      mTracks.push_back(result);
+   }
+
+   // These are cheap while the track has no clips
+   result->ConvertToSampleFormat(
+      ImportFileHandle::ChooseFormat(effectiveFormat, mDefaultFormat));
+   result->SetRate(rate);
+   return result;
+}
+
+void ImportBatch::Append(WaveTrack &track, constSamplePtr buffer,
+   sampleFormat format, size_t len, unsigned int stride)
+{
+   if (mFailed || len == 0)
+      return;
+
+   auto pJob = std::make_shared<Job>();
+   pJob->pTrack = &track;
+   pJob->format = format;
+   pJob->len = len;
+   pJob->bytes = len * SAMPLE_SIZE(format);
+   pJob->samples.reinit(pJob->bytes);
+   if (stride == 1)
+      memcpy(pJob->samples.get(), buffer, pJob->bytes);
+   else
+      CopySamples(buffer, format, pJob->samples.get(), format, len, true,
+         stride);
+
+   std::unique_lock<std::mutex> lock{ mMutex };
+   mDone.wait(lock, [this]{
+      return mQueuedBytes < MaxQueuedBytes || mFailed || mStop; });
+   mQueuedBytes += pJob->bytes;
+   mJobs.push_back(pJob);
+   mQueued.notify_all();
+}
+
+void ImportBatch::Edit(const std::function<void()> &edit)
+{
+   const auto pJob = std::make_shared<Job>();
+   pJob->pEdit = &edit;
+
+   std::unique_lock<std::mutex> lock{ mMutex };
+   mJobs.push_back(pJob);
+   mQueued.notify_all();
+   mDone.wait(lock, [&]{ return pJob->done; });
+   if (pJob->error)
+      std::rethrow_exception(pJob->error);
+}
+
+void ImportBatch::EditAtEnd(size_t index, std::function<void()> edit)
+{
+   std::lock_guard<std::mutex> lock{ mEditsMutex };
+   mEditsAtEnd[index].push_back(std::move(edit));
+}
+
+void ImportBatch::DoEditsAtEnd(size_t index)
+{
+   // The workers are done, so there is no need to lock
+   auto edits = std::move(mEditsAtEnd[index]);
+   for (const auto &edit : edits)
+      edit();
+}
+
+void ImportBatch::ShowAtEnd(size_t index, const TranslatableString &message)
+{
+   std::lock_guard<std::mutex> lock{ mEditsMutex };
+   mMessagesAtEnd[index].push_back(message);
+}
+
+void ImportBatch::ShowMessagesAtEnd(size_t index)
+{
+   // The workers are done, so there is no need to lock
+   auto messages = std::move(mMessagesAtEnd[index]);
+   for (const auto &message : messages)
+      AudacityMessageBox(message);
+}
+
+ProgressResult ImportBatch::UpdateProgress(size_t index, double fraction)
+{
+   mProgress[index] = std::min(1.0, std::max(0.0, fraction));
+   if (mFailed)
+      return ProgressResult::Failed;
+   return mResult;
+}
+
+void ImportBatch::Writer()
+{
+   std::unique_lock<std::mutex> lock{ mMutex };
+   while (true) {
+      mQueued.wait(lock,
+         [this]{ return mStop || mFinishing || !mJobs.empty(); });
+      if (mStop || mJobs.empty())
+         // Stopping, or finishing with nothing left to do
+         break;
+
+      const auto pJob = std::move(mJobs.front());
+      mJobs.pop_front();
+      lock.unlock();
+
+      if (pJob->pEdit) {
+         // Edits that follow a failed append would see incomplete tracks
+         if (mFailed)
+            pJob->error = mError;
+         else {
+            try {
+               (*pJob->pEdit)();
+            }
+            catch (...) {
+               pJob->error = std::current_exception();
+            }
+         }
+         lock.lock();
+         pJob->done = true;
+         mDone.notify_all();
+         continue;
+      }
+
+      if (!mFailed) {
+         try {
+            pJob->pTrack->Append(
+               pJob->samples.get(), pJob->format, pJob->len);
+            mBytesAppended += pJob->bytes;
+         }
+         catch (...) {
+            // Probably the disk is full; there is no point in writing more
+            mError = std::current_exception();
+            mFailed = true;
+         }
+      }
+
+      lock.lock();
+      mQueuedBytes -= pJob->bytes;
+      mDone.notify_all();
+   }
+
+   // Release any waiters, though if workers still run, the batch is being
+   // abandoned because of an exception
+   for (auto &pJob : mJobs) {
+      pJob->error = mError;
+      pJob->done = true;
+   }
+   mJobs.clear();
+   mQueuedBytes = 0;
+   mDone.notify_all();
+}
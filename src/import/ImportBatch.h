@@ -0,0 +1,135 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ImportBatch.h
+
+*******************************************************************//**
+
+\class ImportBatch
+\brief Shared state of the concurrent import of several files
+
+Each file is decoded by an ImportFileHandle in a worker thread.  Tracks and
+sample blocks are not safe to make from several threads at once, so the
+handles take new tracks from a stock that the main thread makes, and one
+writer, run on one of the ReusedThreads, does all appends to and edits of the tracks, in the order
+that each handle requested them.
+
+Edits that may destroy sample blocks, such as trimming, are kept until all
+files are decoded, and then done by the main thread; so are messages about
+errors, which only the main thread may show.  Tracks are kept until
+the batch is destroyed, in the main thread, so that no sample block is
+destroyed in a worker either.
+
+*//*******************************************************************/
+
+#ifndef __AUDACITY_IMPORT_BATCH__
+#define __AUDACITY_IMPORT_BATCH__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "audacity/Types.h"
+#include "../MemoryX.h"
+
+class WaveTrack;
+class WaveTrackFactory;
+enum class ProgressResult : unsigned;
+
+class ImportBatch final
+{
+public:
+   //! Construct in the main thread, which starts the writer
+   ImportBatch(WaveTrackFactory &trackFactory, size_t nFiles);
+   ImportBatch(const ImportBatch&) = delete;
+   ImportBatch &operator=(const ImportBatch&) = delete;
+   //! Abandons any writing not yet done
+   ~ImportBatch();
+
+   // Functions for the main thread, while the workers run
+
+   //! Make more tracks for workers that need them
+   void ReplenishTracks();
+   //! Fraction of the work done, averaged over the files
+   double GetProgress() const;
+   //! Make all workers stop or cancel when they next update progress
+   void SetResult(ProgressResult result);
+   ProgressResult GetResult() const;
+
+   // Functions for the main thread, after the workers finish
+
+   //! Wait until the writer thread is done, and rethrow the first exception
+   //! that it caught
+   void Finish();
+   //! Bytes of the samples that were appended, in the formats given
+   unsigned long long GetBytesAppended() const { return mBytesAppended; }
+   //! Do the edits given to EditAtEnd for one file, in order
+   void DoEditsAtEnd(size_t index);
+   //! Show the messages given to ShowAtEnd for one file, in order
+   void ShowMessagesAtEnd(size_t index);
+
+   // Functions for the workers, through ImportFileHandle
+
+   std::shared_ptr<WaveTrack> NewWaveTrack(
+      sampleFormat effectiveFormat, double rate);
+   //! Queue a copy of samples to append, waiting while too much is queued
+   void Append(WaveTrack &track, constSamplePtr buffer,
+      sampleFormat format, size_t len, unsigned int stride);
+   //! Have the writer thread call edit after the appends queued before, and
+   //! wait for it; rethrows what edit throws
+   void Edit(const std::function<void()> &edit);
+   //! Keep edit for the main thread to do, after all files are decoded
+   void EditAtEnd(size_t index, std::function<void()> edit);
+   //! Keep a message for the main thread to show, after all files are
+   //! decoded
+   void ShowAtEnd(size_t index, const TranslatableString &message);
+   ProgressResult UpdateProgress(size_t index, double fraction);
+
+private:
+   struct Job;
+   void Writer();
+
+   WaveTrackFactory &mTrackFactory;
+   // The user preference, read once in the main thread
+   const sampleFormat mDefaultFormat;
+
+   // Fraction done of each file
+   ArrayOf< std::atomic<double> > mProgress;
+   const size_t mnFiles;
+   std::atomic<ProgressResult> mResult;
+
+   // Stock of empty tracks, and all tracks given out
+   std::mutex mTrackMutex;
+   std::condition_variable mTrackAvailable;
+   std::vector< std::shared_ptr<WaveTrack> > mSpareTracks;
+   std::vector< std::shared_ptr<WaveTrack> > mTracks;
+   size_t mTracksWanted{ 0 };
+
+   // Edits and messages for the main thread, for each file
+   std::mutex mEditsMutex;
+   std::vector< std::vector< std::function<void()> > > mEditsAtEnd;
+   std::vector< TranslatableStrings > mMessagesAtEnd;
+
+   // Queue of work for the writer thread
+   std::mutex mMutex;
+   std::condition_variable mQueued;
+   std::condition_variable mDone;
+   std::deque< std::shared_ptr<Job> > mJobs;
+   size_t mQueuedBytes{ 0 };
+   bool mFinishing{ false };
+   bool mStop{ false };
+   std::exception_ptr mError;
+   std::atomic<bool> mFailed{ false };
+   std::atomic<unsigned long long> mBytesAppended{ 0 };
+   // Ready when the writer returns
+   std::future<void> mWriting;
+};
+
+#endif
@@ -251,6 +251,10 @@ public:
          mScs->get()[StreamID]->m_use = Use;
    }
 
+   ///! Called by Import.cpp
+   ///\return true, because decoding does not use the GUI
+   bool SupportsBatch() override { return true; }
+
 private:
 
    std::shared_ptr<FFmpegContext> mContext; // An object that does proper IO shutdown in its destructor; may be shared with decoder task.
@@ -536,14 +540,16 @@ ProgressResult FFmpegImportFileHandle::Import(WaveTrackFactory *trackFactory,
       }
       if (stream_delay > 0)
       {
-         int c = -1;
-         for (auto &channel : stream)
-         {
-            ++c;
+         EditTracks( [&]{
+            int c = -1;
+            for (auto &channel : stream)
+            {
+               ++c;
 
-            WaveTrack *t = channel.get();
-            t->InsertSilence(0,double(stream_delay)/AV_TIME_BASE);
-         }
+               WaveTrack *t = channel.get();
+               t->InsertSilence(0,double(stream_delay)/AV_TIME_BASE);
+            }
+         } );
       }
    }
    // This is the heart of the importing process
@@ -594,9 +600,11 @@ ProgressResult FFmpegImportFileHandle::Import(WaveTrackFactory *trackFactory,
    //else if (res == 2), we just stop the decoding as if the file has ended
 
    // Copy audio from mChannels to newly created tracks (destroying mChannels elements in process)
-   for (auto &stream : mChannels)
-      for(auto &channel : stream)
-         channel->Flush();
+   EditTracks( [&]{
+      for (auto &stream : mChannels)
+         for(auto &channel : stream)
+            channel->Flush();
+   } );
 
    outTracks.swap(mChannels);
 
@@ -699,7 +707,7 @@ ProgressResult FFmpegImportFileHandle::WriteData(streamContext *sc)
    auto iter2 = iter->begin();
    for (size_t chn=0; chn < nChannels; ++iter2, ++chn)
    {
-      iter2->get()->Append((samplePtr)tmp[chn].get(), sc->m_osamplefmt, index);
+      AppendToTrack(**iter2, (samplePtr)tmp[chn].get(), sc->m_osamplefmt, index);
    }
 
    // Try to update the progress indicator (and see if user wants to cancel)
@@ -723,7 +731,7 @@ ProgressResult FFmpegImportFileHandle::WriteData(streamContext *sc)
       mProgressPos = sc->m_pkt->pos;
       mProgressLen = filesize;
    }
-   updateResult = mProgress->Update(mProgressPos, mProgressLen != 0 ? mProgressLen : 1);
+   updateResult = UpdateProgress(mProgressPos, mProgressLen != 0 ? mProgressLen : 1);
 
    return updateResult;
 }
@@ -160,6 +160,8 @@ public:
    void SetStreamUsage(wxInt32 WXUNUSED(StreamID), bool WXUNUSED(Use)) override
    {}
 
+   bool SupportsBatch() override { return true; }
+
 private:
    sampleFormat          mFormat;
    std::unique_ptr<MyFLACFile> mFile;
@@ -252,12 +254,12 @@ FLAC__StreamDecoderWriteStatus MyFLACFile::write_callback(const FLAC__Frame *fra
                tmp[s]=buffer[chn][s];
             }
 
-            iter->get()->Append((samplePtr)tmp.get(),
+            mFile->AppendToTrack(**iter, (samplePtr)tmp.get(),
                      int16Sample,
                      frame->header.blocksize);
          }
          else {
-            iter->get()->Append((samplePtr)buffer[chn],
+            mFile->AppendToTrack(**iter, (samplePtr)buffer[chn],
                      int24Sample,
                      frame->header.blocksize);
          }
@@ -265,7 +267,7 @@ FLAC__StreamDecoderWriteStatus MyFLACFile::write_callback(const FLAC__Frame *fra
 
       mFile->mSamplesDone += frame->header.blocksize;
 
-      mFile->mUpdateResult = mFile->mProgress->Update((wxULongLong_t) mFile->mSamplesDone, mFile->mNumSamples != 0 ? (wxULongLong_t)mFile->mNumSamples : 1);
+      mFile->mUpdateResult = mFile->UpdateProgress((double) mFile->mSamplesDone, mFile->mNumSamples != 0 ? (double)mFile->mNumSamples : 1);
       if (mFile->mUpdateResult != ProgressResult::Success)
       {
          return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
@@ -434,8 +436,10 @@ ProgressResult FLACImportFileHandle::Import(WaveTrackFactory *trackFactory,
       return mUpdateResult;
    }
 
-   for (const auto &channel : mChannels)
-      channel->Flush();
+   EditTracks( [&]{
+      for (const auto &channel : mChannels)
+         channel->Flush();
+   } );
 
    if (!mChannels.empty())
       outTracks.push_back(std::move(mChannels));
@@ -113,6 +113,7 @@ public:
    wxInt32 GetStreamCount() override;
    const TranslatableStrings &GetStreamInfo() override;
    void SetStreamUsage(wxInt32 StreamID, bool Use) override;
+   bool SupportsBatch() override;
 
 private:
    bool Open();
@@ -251,6 +252,11 @@ void MP3ImportFileHandle::SetStreamUsage(wxInt32 WXUNUSED(StreamID), bool WXUNUS
 {
 }
 
+bool MP3ImportFileHandle::SupportsBatch()
+{
+   return true;
+}
+
 ProgressResult MP3ImportFileHandle::Import(WaveTrackFactory *trackFactory,
                                            TrackHolders &outTracks,
                                            Tags *tags)
@@ -288,27 +294,34 @@ ProgressResult MP3ImportFileHandle::Import(WaveTrackFactory *trackFactory,
       return mUpdateResult;
    }
 
-   // Flush and trim the channels
-   for (const auto &channel : mChannels)
-   {
-      channel->Flush();
+   // Flush the channels
+   EditTracks( [&]{
+      for (const auto &channel : mChannels)
+         channel->Flush();
+   } );
 
-      // Trim any padding
-      if (mPadding)
+   // Then trim them, which destroys sample blocks
+   EditTracksAtEnd(
+      [channels = mChannels, padding = mPadding, delay = mDelay]{
+      for (const auto &channel : channels)
       {
-         double et = channel->GetEndTime();
-         double t1 = et - channel->LongSamplesToTime(mPadding);
-         channel->Clear(t1, et);
-      }
+         // Trim any padding
+         if (padding)
+         {
+            double et = channel->GetEndTime();
+            double t1 = et - channel->LongSamplesToTime(padding);
+            channel->Clear(t1, et);
+         }
 
-      // And delay
-      if (mDelay)
-      {
-         double st = channel->GetStartTime();
-         double t0 = st + channel->LongSamplesToTime(mDelay);
-         channel->Clear(st, t0);
+         // And delay
+         if (delay)
+         {
+            double st = channel->GetStartTime();
+            double t0 = st + channel->LongSamplesToTime(delay);
+            channel->Clear(st, t0);
+         }
       }
-   }
+   } );
 
    // Copy the WaveTrack pointers into the Track pointer list that
    // we are expected to fill
@@ -862,7 +875,7 @@ mad_flow MP3ImportFileHandle::input_cb(void *that,
 mad_flow MP3ImportFileHandle::InputCB(struct mad_stream *stream)
 {
    // Update the progress
-   mUpdateResult = mProgress->Update((wxLongLong_t) mFilePos, (wxLongLong_t) mFileLen);
+   mUpdateResult = UpdateProgress((double) mFilePos, (double) mFileLen);
    if (mUpdateResult != ProgressResult::Success)
    {
       return MAD_FLOW_STOP;
@@ -1060,7 +1073,7 @@ enum mad_flow MP3ImportFileHandle::OutputCB(struct mad_header const * WXUNUSED(h
       }
 
       // And append to the channel
-      mChannels[chn]->Append((samplePtr) sampleBuf, floatSample, samples);
+      AppendToTrack(*mChannels[chn], (samplePtr) sampleBuf, floatSample, samples);
    }
 
    return MAD_FLOW_CONTINUE;
@@ -1097,7 +1110,7 @@ enum mad_flow MP3ImportFileHandle::ErrorCB(struct mad_stream *stream,
    }
 
    // Let the user know about the error
-   AudacityMessageBox(XO("Import failed\n\nThis is likely caused by a malformed MP3.\n\n"));
+   ShowError(XO("Import failed\n\nThis is likely caused by a malformed MP3.\n\n"));
 
    return MAD_FLOW_BREAK;
 }
@@ -148,6 +148,8 @@ public:
       }
    }
 
+   bool SupportsBatch() override { return true; }
+
 private:
    std::unique_ptr<wxFFile> mFile;
    std::unique_ptr<OggVorbis_File> mVorbisFile;
@@ -329,7 +331,7 @@ ProgressResult OggImportFileHandle::Import(
          {
             auto iter2 = iter->begin();
             for (int c = 0; c < mVorbisFile->vi[bitstream].channels; ++iter2, ++c)
-               iter2->get()->Append((char *)(mainBuffer.get() + c),
+               AppendToTrack(**iter2, (char *)(mainBuffer.get() + c),
                int16Sample,
                samplesRead,
                mVorbisFile->vi[bitstream].channels);
@@ -337,7 +339,7 @@ ProgressResult OggImportFileHandle::Import(
 
          samplesSinceLastCallback += samplesRead;
          if (samplesSinceLastCallback > SAMPLES_PER_CALLBACK) {
-            updateResult = mProgress->Update(ov_time_tell(mVorbisFile.get()),
+            updateResult = UpdateProgress(ov_time_tell(mVorbisFile.get()),
                ov_time_total(mVorbisFile.get(), bitstream));
             samplesSinceLastCallback -= SAMPLES_PER_CALLBACK;
          }
@@ -352,12 +354,13 @@ ProgressResult OggImportFileHandle::Import(
       return res;
    }
 
+   EditTracks( [&]{
+      for (auto &link : mChannels)
+         for (auto &channel : link)
+            channel->Flush();
+   } );
    for (auto &link : mChannels)
-   {
-      for (auto &channel : link)
-         channel->Flush();
       outTracks.push_back(std::move(link));
-   }
 
    //\todo { Extract comments from each stream? }
    if (mVorbisFile->vc[0].comments > 0) {
@@ -47,6 +47,7 @@
 #include "../FileFormats.h"
 #include "../Prefs.h"
 #include "../ShuttleGui.h"
+#include "../WaveClip.h"
 #include "../WaveTrack.h"
 #include "ImportPlugin.h"
 
@@ -86,7 +87,8 @@ public:
 class PCMImportFileHandle final : public ImportFileHandle
 {
 public:
-   PCMImportFileHandle(const FilePath &name, SFFile &&file, SF_INFO info);
+   PCMImportFileHandle(
+      const FilePath &name, SFFile &&file, SF_INFO info, int fd);
    ~PCMImportFileHandle();
 
    TranslatableString GetFileDescription() override;
@@ -105,8 +107,20 @@ public:
    void SetStreamUsage(wxInt32 WXUNUSED(StreamID), bool WXUNUSED(Use)) override
    {}
 
+   bool SupportsBatch() override { return true; }
+
 private:
+   //! Fast path for uncompressed data that is already in the format of the
+   //! tracks:  read the file in large pieces, bypassing libsndfile, and make
+   //! whole blocks directly from what was read
+   /*! @return how many frames were imported, zero if the file does not
+    qualify; if nonzero, updateResult is also assigned */
+   sampleCount ImportDirectly(const NewChannelGroup &channels,
+      size_t blockSize, ProgressResult &updateResult);
+
    SFFile                mFile;
+   // The descriptor that mFile reads, not owned
+   const int             mFd;
    const SF_INFO         mInfo;
    sampleFormat          mFormat;
 };
@@ -143,11 +157,13 @@ std::unique_ptr<ImportFileHandle> PCMImportPlugin::Open(
 #endif
 
 
+   int fd = -1;
    if (f.Open(filename)) {
       // Even though there is an sf_open() that takes a filename, use the one that
       // takes a file descriptor since wxWidgets can open a file with a Unicode name and
       // libsndfile can't (under Windows).
-      file.reset(SFCall<SNDFILE*>(sf_open_fd, f.fd(), SFM_READ, &info, TRUE));
+      fd = f.fd();
+      file.reset(SFCall<SNDFILE*>(sf_open_fd, fd, SFM_READ, &info, TRUE));
    }
 
    // The file descriptor is now owned by "file", so we must tell "f" to leave
@@ -178,7 +194,8 @@ std::unique_ptr<ImportFileHandle> PCMImportPlugin::Open(
    }
 
    // Success, so now transfer the duty to close the file from "file".
-   return std::make_unique<PCMImportFileHandle>(filename, std::move(file), info);
+   return std::make_unique<PCMImportFileHandle>(
+      filename, std::move(file), info, fd);
 }
 
 static Importer::RegisteredImportPlugin registered{ "PCM",
@@ -186,9 +203,10 @@ static Importer::RegisteredImportPlugin registered{ "PCM",
 };
 
 PCMImportFileHandle::PCMImportFileHandle(const FilePath &name,
-                                         SFFile &&file, SF_INFO info)
+                                         SFFile &&file, SF_INFO info, int fd)
 :  ImportFileHandle(name),
    mFile(std::move(file)),
+   mFd(fd),
    mInfo(info)
 {
    wxASSERT(info.channels >= 0);
@@ -285,6 +303,137 @@ using id3_tag_holder = std::unique_ptr<id3_tag, id3_tag_deleter>;
 
 using NewChannelGroup = std::vector< std::shared_ptr<WaveTrack> >;
 
+// Bound on the bytes read at once by ImportDirectly, which makes all the
+// blocks of each read in one call of EditTracks
+static const size_t MaxReadBytes = 16 * 1024 * 1024;
+
+sampleCount PCMImportFileHandle::ImportDirectly(
+   const NewChannelGroup &channels, size_t blockSize,
+   ProgressResult &updateResult)
+{
+   // Only uncompressed samples that need no conversion qualify
+   const auto subtype = mInfo.format & SF_FORMAT_SUBMASK;
+   if (!((subtype == SF_FORMAT_PCM_16 && mFormat == int16Sample) ||
+         (subtype == SF_FORMAT_FLOAT && mFormat == floatSample)))
+      return 0;
+   switch (mInfo.format & SF_FORMAT_TYPEMASK) {
+      case SF_FORMAT_WAV:
+      case SF_FORMAT_WAVEX:
+      case SF_FORMAT_RF64:
+      case SF_FORMAT_AIFF:
+         break;
+      default:
+         return 0;
+   }
+   if (mInfo.channels < 1 || mInfo.frames <= 0 || blockSize < 1)
+      return 0;
+   for (const auto &channel : channels)
+      if (channel->GetSampleFormat() != mFormat)
+         return 0;
+   // The samples must also be in the byte order of this machine
+   if (SFCall<int>(sf_command,
+      mFile.get(), SFC_RAW_DATA_NEEDS_ENDSWAP, nullptr, 0))
+      return 0;
+
+   const size_t nChannels = mInfo.channels;
+   const size_t sampleSize = SAMPLE_SIZE(mFormat);
+   const size_t frameBytes = nChannels * sampleSize;
+   const sampleCount totalFrames = mInfo.frames;
+
+   // Read through the descriptor of libsndfile, which keeps it
+   wxFile file(mFd);
+   auto cleanup = finally( [&]{ file.Detach(); } );
+
+   // libsndfile does not tell where the samples begin, but seeking to the
+   // first frame leaves the descriptor there
+   const wxFileOffset fileLength = file.Length();
+   if (SFCall<sf_count_t>(sf_seek, mFile.get(), 0, SEEK_SET) != 0)
+      return 0;
+   const wxFileOffset dataOffset = file.Tell();
+   if (dataOffset < 0 || fileLength < dataOffset ||
+       dataOffset % sampleSize != 0 ||
+       (fileLength - dataOffset) / (wxFileOffset)frameBytes <
+          totalFrames.as_long_long())
+      return 0;
+
+   // Make sure, by comparing the first frames with what libsndfile reads
+   {
+      const size_t nCheck = limitSampleBufferSize(256, totalFrames);
+      const size_t checkBytes = nCheck * frameBytes;
+      SampleBuffer check(nCheck * nChannels, mFormat);
+      SampleBuffer raw(nCheck * nChannels, mFormat);
+      const auto nRead = (mFormat == int16Sample)
+         ? SFCall<sf_count_t>(
+            sf_readf_short, mFile.get(), (short *)check.ptr(), nCheck)
+         : SFCall<sf_count_t>(
+            sf_readf_float, mFile.get(), (float *)check.ptr(), nCheck);
+      if (nRead != (sf_count_t)nCheck ||
+          file.Seek(dataOffset) == wxInvalidOffset ||
+          file.Read(raw.ptr(), checkBytes) != (ssize_t)checkBytes ||
+          memcmp(raw.ptr(), check.ptr(), checkBytes) != 0)
+         return 0;
+   }
+
+   // Read whole rows of blocks at a time
+   const size_t rowsPerRead =
+      std::max<size_t>(1, MaxReadBytes / (blockSize * frameBytes));
+   const size_t maxFrames = rowsPerRead * blockSize;
+   SampleBuffer raw(maxFrames * nChannels, mFormat);
+
+   // Each channel's part of what was read; mono needs none, because blocks
+   // are made directly from what was read
+   SampleBuffer deinterleaved;
+   if (nChannels > 1)
+      deinterleaved.Allocate(maxFrames * nChannels, mFormat);
+   const auto channelBuffer = [&](size_t c) {
+      return nChannels == 1
+         ? raw.ptr()
+         : deinterleaved.ptr() + c * maxFrames * sampleSize; };
+
+   if (file.Seek(dataOffset) == wxInvalidOffset)
+      return 0;
+   sampleCount framesDone = 0;
+   auto result = ProgressResult::Success;
+   while (framesDone < totalFrames && result == ProgressResult::Success) {
+      const auto frames =
+         limitSampleBufferSize(maxFrames, totalFrames - framesDone);
+      const auto bytes = frames * frameBytes;
+      // After an error, as when the file was truncated meanwhile, leave the
+      // rest to the caller, where libsndfile fails as it did before
+      if (file.Read(raw.ptr(), bytes) != (ssize_t)bytes)
+         break;
+
+      if (nChannels > 1)
+         for (size_t c = 0; c < nChannels; ++c)
+            CopySamples(raw.ptr() + c * sampleSize, mFormat,
+               channelBuffer(c), mFormat, frames, true, nChannels);
+
+      // One call for all the blocks read, so that a batch import does not
+      // wait on its writer thread for each block
+      EditTracks( [&]{
+         for (size_t done = 0; done < frames; done += blockSize) {
+            const auto len = std::min(blockSize, frames - done);
+            for (size_t c = 0; c < nChannels; ++c)
+               channels[c]->RightmostOrNewClip()->AppendNewBlock(
+                  channelBuffer(c) + done * sampleSize, mFormat, len);
+         }
+      } );
+      framesDone += frames;
+
+      result = UpdateProgress(
+         framesDone.as_double(), totalFrames.as_double());
+   }
+
+   if (framesDone > 0) {
+      EditTracks( [&]{
+         for (const auto &channel : channels)
+            channel->RightmostOrNewClip()->UpdateEnvelopeTrackLen();
+      } );
+      updateResult = result;
+   }
+   return framesDone;
+}
+
 ProgressResult PCMImportFileHandle::Import(WaveTrackFactory *trackFactory,
                                 TrackHolders &outTracks,
                                 Tags *tags)
@@ -309,7 +458,17 @@ ProgressResult PCMImportFileHandle::Import(WaveTrackFactory *trackFactory,
    auto maxBlockSize = channels.begin()->get()->GetMaxBlockSize();
    auto updateResult = ProgressResult::Cancelled;
 
-   {
+   // Make whole blocks directly from the file when possible, and read
+   // whatever that did not import
+   auto framescompleted =
+      ImportDirectly(channels, maxBlockSize, updateResult);
+   if (framescompleted == 0 ||
+       (updateResult == ProgressResult::Success &&
+        framescompleted < fileTotalFrames)) {
+      if (SFCall<sf_count_t>(sf_seek, mFile.get(),
+         framescompleted.as_long_long(), SEEK_SET) < 0)
+         return ProgressResult::Failed;
+
       // Otherwise, we're in the "copy" mode, where we read in the actual
       // samples from the file and store our own local copy of the
       // samples in the tracks.
@@ -335,8 +494,6 @@ ProgressResult PCMImportFileHandle::Import(WaveTrackFactory *trackFactory,
             return ProgressResult::Failed;
       }
 
-      decltype(fileTotalFrames) framescompleted = 0;
-
       long block;
       do {
          block = maxBlock;
@@ -366,14 +523,14 @@ ProgressResult PCMImportFileHandle::Import(WaveTrackFactory *trackFactory,
                         ((float *)srcbuffer.ptr())[mInfo.channels*j+c];
                }
 
-               iter->get()->Append(buffer.ptr(), (mFormat == int16Sample)?int16Sample:floatSample, block);
+               AppendToTrack(**iter, buffer.ptr(), (mFormat == int16Sample)?int16Sample:floatSample, block);
             }
             framescompleted += block;
          }
 
-         updateResult = mProgress->Update(
-            framescompleted.as_long_long(),
-            fileTotalFrames.as_long_long()
+         updateResult = UpdateProgress(
+            framescompleted.as_double(),
+            fileTotalFrames.as_double()
          );
          if (updateResult != ProgressResult::Success)
             break;
@@ -385,8 +542,10 @@ ProgressResult PCMImportFileHandle::Import(WaveTrackFactory *trackFactory,
       return updateResult;
    }
 
-   for(const auto &channel : channels)
-      channel->Flush();
+   EditTracks( [&]{
+      for(const auto &channel : channels)
+         channel->Flush();
+   } );
 
    if (!channels.empty())
       outTracks.push_back(std::move(channels));
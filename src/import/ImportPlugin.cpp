@@ -11,7 +11,9 @@ Paul Licameli split from Import.cpp
 #include "ImportPlugin.h"
 
 #include <wx/filename.h>
+#include "ImportBatch.h"
 #include "../WaveTrack.h"
+#include "../widgets/AudacityMessageBox.h"
 #include "../widgets/ProgressDialog.h"
 #include "../prefs/QualityPrefs.h"
 
@@ -26,6 +28,9 @@ ImportFileHandle::~ImportFileHandle()
 
 void ImportFileHandle::CreateProgress()
 {
+   if (mpBatch)
+      return;
+
    wxFileName ff( mFilename );
 
    auto title = XO("Importing %s").Format( GetFileDescription() );
@@ -33,11 +38,67 @@ void ImportFileHandle::CreateProgress()
       title, Verbatim( ff.GetFullName() ) );
 }
 
+bool ImportFileHandle::SupportsBatch()
+{
+   return false;
+}
+
+void ImportFileHandle::SetBatch(ImportBatch *pBatch, size_t index)
+{
+   mpBatch = pBatch;
+   mBatchIndex = index;
+}
+
+ProgressResult ImportFileHandle::UpdateProgress(double current, double total)
+{
+   if (mpBatch)
+      return mpBatch->UpdateProgress(mBatchIndex,
+         total != 0 ? current / total : 1.0);
+   return mProgress->Update(current, total);
+}
+
+void ImportFileHandle::AppendToTrack(WaveTrack &track, constSamplePtr buffer,
+   sampleFormat format, size_t len, unsigned int stride)
+{
+   if (mpBatch)
+      mpBatch->Append(track, buffer, format, len, stride);
+   else
+      track.Append(buffer, format, len, stride);
+}
+
+void ImportFileHandle::EditTracks(const std::function<void()> &edit)
+{
+   if (mpBatch)
+      mpBatch->Edit(edit);
+   else
+      edit();
+}
+
+void ImportFileHandle::EditTracksAtEnd(std::function<void()> edit)
+{
+   if (mpBatch)
+      mpBatch->EditAtEnd(mBatchIndex, std::move(edit));
+   else
+      edit();
+}
+
+void ImportFileHandle::ShowError(const TranslatableString &message)
+{
+   if (mpBatch)
+      mpBatch->ShowAtEnd(mBatchIndex, message);
+   else
+      AudacityMessageBox(message);
+}
+
 sampleFormat ImportFileHandle::ChooseFormat(sampleFormat effectiveFormat)
 {
    // Consult user preference
-   auto defaultFormat = QualityPrefs::SampleFormatChoice();
+   return ChooseFormat(effectiveFormat, QualityPrefs::SampleFormatChoice());
+}
 
+sampleFormat ImportFileHandle::ChooseFormat(
+   sampleFormat effectiveFormat, sampleFormat defaultFormat)
+{
    // Don't choose format narrower than effective or default
    auto format = std::max(effectiveFormat, defaultFormat);
 
@@ -51,5 +112,7 @@ sampleFormat ImportFileHandle::ChooseFormat(sampleFormat effectiveFormat)
 std::shared_ptr<WaveTrack> ImportFileHandle::NewWaveTrack(
    WaveTrackFactory &trackFactory, sampleFormat effectiveFormat, double rate)
 {
+   if (mpBatch)
+      return mpBatch->NewWaveTrack(effectiveFormat, rate);
    return trackFactory.NewWaveTrack(ChooseFormat(effectiveFormat), rate);
 }
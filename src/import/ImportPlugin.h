@@ -47,11 +47,14 @@ but little else.
 
 #include "../Audacity.h"
 
+#include <functional>
+
 #include "audacity/Types.h"
 #include "../Internat.h"
 #include "../MemoryX.h"
 
 class AudacityProject;
+class ImportBatch;
 class ProgressDialog;
 enum class ProgressResult : unsigned;
 class WaveTrackFactory;
@@ -119,8 +122,17 @@ public:
 
    // The importer should call this to create the progress dialog and
    // identify the filename being imported.
+   // (It does nothing during a batch import, which has one dialog for all.)
    void CreateProgress();
 
+   // Whether Import may run in a worker thread, concurrently with the import
+   // of other files of a batch.  Such an importer must report progress, and
+   // append to and change its tracks, only with the protected functions below.
+   virtual bool SupportsBatch();
+
+   // Make Import a part of a batch, as the file with the given index
+   void SetBatch(ImportBatch *pBatch, size_t index);
+
    // This is similar to GetPluginFormatDescription, but if possible the
    // importer will return a more specific description of the
    // specific file that is open.
@@ -154,14 +166,48 @@ public:
 
    //! Choose appropriate format, which will not be narrower than the specified one
    static sampleFormat ChooseFormat(sampleFormat effectiveFormat);
+   //! Choose as above, given the format of the user preference
+   static sampleFormat ChooseFormat(
+      sampleFormat effectiveFormat, sampleFormat defaultFormat);
 
    //! Build a wave track with appropriate format, which will not be narrower than the specified one
    std::shared_ptr<WaveTrack> NewWaveTrack( WaveTrackFactory &trackFactory,
       sampleFormat effectiveFormat, double rate);
 
 protected:
+   bool IsBatch() const { return mpBatch != nullptr; }
+
+   // Update the progress dialog, or this file's part of the progress of a
+   // batch
+   ProgressResult UpdateProgress(double current, double total);
+
+   // Append to a track made by NewWaveTrack.  During a batch import, a copy
+   // of the samples is appended later, by the thread that writes all sample
+   // blocks of the batch.
+   void AppendToTrack(WaveTrack &track, constSamplePtr buffer,
+      sampleFormat format, size_t len, unsigned int stride = 1);
+
+   // Do any other changes of the tracks made by NewWaveTrack, including
+   // Flush, with this function.  During a batch import, the writer thread
+   // does them after the appends so far, while this thread waits.
+   void EditTracks(const std::function<void()> &edit);
+
+   // Do changes of the tracks that may destroy sample blocks, such as
+   // Clear, with this function.  During a batch import, the main thread
+   // does them after all files are decoded, if this file succeeded, because
+   // blocks must not be destroyed in other threads.
+   void EditTracksAtEnd(std::function<void()> edit);
+
+   // Tell the user of an error with this function.  During a batch import,
+   // the main thread shows the message after all files are decoded.
+   void ShowError(const TranslatableString &message);
+
    FilePath mFilename;
    std::unique_ptr<ProgressDialog> mProgress;
+
+private:
+   ImportBatch *mpBatch{};
+   size_t mBatchIndex{};
 };
 
 
@@ -154,10 +154,12 @@ void DoImport(const CommandContext &context, bool isRaw)
                .AddImportedTracks(fileName, std::move(newTracks));
          }
       }
-      else {
-         ProjectFileManager::Get( project ).Import(fileName);
-      }
    }
+
+   if (!isRaw)
+      // Decode the files concurrently where possible
+      ProjectFileManager::Get( project ).ImportFiles(
+         FilePaths( selectedFiles.begin(), selectedFiles.end() ) );
 }
 
 }
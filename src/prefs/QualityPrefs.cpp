@@ -26,6 +26,7 @@
 #include "../Dither.h"
 #include "../Prefs.h"
 #include "../Resample.h"
+#include "../SampleBlockCodec.h"
 #include "../ShuttleGui.h"
 
 #define ID_SAMPLE_RATE_CHOICE           7001
@@ -50,6 +51,20 @@ static EnumSetting< sampleFormat > formatSetting{
    wxT("/SamplingRate/DefaultProjectSampleFormat"),
 };
 
+static EnumSetting< SampleBlockCodec > codecSetting{
+   wxT("/SampleBlocks/Codec"),
+   {
+      { wxT("None"), XO("None") },
+      { wxT("Lossless"), XO("Lossless") }
+   },
+   0, // None
+
+   {
+      SampleBlockCodec::None,
+      SampleBlockCodec::Lossless
+   },
+};
+
 //////////
 BEGIN_EVENT_TABLE(QualityPrefs, PrefsPanel)
    EVT_CHOICE(ID_SAMPLE_RATE_CHOICE, QualityPrefs::OnSampleRateChoice)
@@ -169,6 +184,10 @@ void QualityPrefs::PopulateOrExchange(ShuttleGui & S)
 
          S.TieChoice(XXO("Default Sample &Format:"),
                      formatSetting);
+
+         // Projects so compressed can't be opened by earlier versions
+         S.TieChoice(XXO("&Compression of New Projects:"),
+                     codecSetting);
       }
       S.EndMultiColumn();
    }
@@ -248,3 +267,8 @@ sampleFormat QualityPrefs::SampleFormatChoice()
    return formatSetting.ReadEnum();
 }
 
+SampleBlockCodec QualityPrefs::SampleBlockCodecChoice()
+{
+   return codecSetting.ReadEnum();
+}
+
@@ -22,6 +22,7 @@ class wxTextCtrl;
 class ShuttleGui;
 enum sampleFormat : unsigned;
 enum DitherType : unsigned;
+enum class SampleBlockCodec : int;
 
 #define QUALITY_PREFS_PLUGIN_SYMBOL ComponentInterfaceSymbol{ XO("Quality") }
 
@@ -38,6 +39,8 @@ class QualityPrefs final : public PrefsPanel
    void PopulateOrExchange(ShuttleGui & S) override;
 
    static sampleFormat SampleFormatChoice();
+   //! How new projects store their samples
+   static SampleBlockCodec SampleBlockCodecChoice();
 
  private:
    void Populate();
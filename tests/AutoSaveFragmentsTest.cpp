@@ -0,0 +1,101 @@
+
+#include "DBConnection.h"
+#include "ProjectFileIO.h"
+#include "SampleFormat.h"
+#include "Track.h"
+#include "WaveTrack.h"
+#include <sqlite3.h>
+#include <vector>
+#include <iostream>
+
+class AutoSaveFragmentsTest
+{
+private:
+   InvisibleTemporaryProject *mProject;
+
+public:
+   AutoSaveFragmentsTest()
+   {
+      std::cout << "==> Testing AutoSaveFragments\n";
+   }
+
+   void SetUp()
+   {
+      mProject = new InvisibleTemporaryProject;
+   }
+
+   void TearDown()
+   {
+      delete mProject;
+   }
+
+   long long CountFragments()
+   {
+      auto db = ProjectFileIO::Get( mProject->Project() ).GetConnection().DB();
+      sqlite3_stmt *stmt = nullptr;
+      long long count = -1;
+      if (sqlite3_prepare_v2(db, "SELECT count(*) FROM autosavefragments;",
+            -1, &stmt, nullptr) == SQLITE_OK &&
+          sqlite3_step(stmt) == SQLITE_ROW)
+         count = sqlite3_column_int64(stmt, 0);
+      sqlite3_finalize(stmt);
+      return count;
+   }
+
+   void TestRecordingDoesNotAccumulate()
+   {
+      /* A track that is still being recorded has no id, so its clips are
+       * written again by each autosave; the rows of the previous autosave
+       * must be deleted, so the count stays the same as the track grows. */
+
+      std::cout << "\tautosaving twice while recording should not leave the rows of the first autosave..." << std::flush;
+
+      auto &project = mProject->Project();
+      auto &projectFileIO = ProjectFileIO::Get( project );
+      auto &tracks = TrackList::Get( project );
+
+      auto track = WaveTrackFactory::Get( project ).NewWaveTrack( floatSample );
+      tracks.RegisterPendingNewTrack( track );
+
+      std::vector<float> buffer( track->GetMaxBlockSize() );
+
+      track->Append( (samplePtr)buffer.data(), floatSample, buffer.size() );
+      track->Flush();
+      if (!projectFileIO.AutoSave( true ))
+      {
+         std::cout << "failed (first autosave)\n";
+         return;
+      }
+      const auto first = CountFragments();
+
+      track->Append( (samplePtr)buffer.data(), floatSample, buffer.size() );
+      track->Flush();
+      if (!projectFileIO.AutoSave( true ))
+      {
+         std::cout << "failed (second autosave)\n";
+         return;
+      }
+      const auto second = CountFragments();
+
+      tracks.ClearPendingTracks();
+
+      if (first <= 0 || second != first)
+      {
+         std::cout << "failed (" << first << " then " << second << " rows)\n";
+         return;
+      }
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   AutoSaveFragmentsTest tester;
+
+   tester.SetUp();
+   tester.TestRecordingDoesNotAccumulate();
+   tester.TearDown();
+
+   return 0;
+}